@@ -0,0 +1,113 @@
+#include "bench_common.hh"
+
+#include <cpputils/aggregate.hh>
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+constexpr std::size_t ROWS = 1 << 20;
+
+/// Keys range over 1K (cache-resident) to 1M (memory-bound) distinct values
+void KeyCounts(benchmark::internal::Benchmark* b) {
+  b->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 20);
+}
+
+/*******************************************************************************
+*                                   CountBy                                   *
+*******************************************************************************/
+
+void BM_CountByUnorderedMap(benchmark::State& state) {
+  const auto values = bench::Ints(ROWS, static_cast<int>(state.range(0)));
+  bench::TAllocationCounter allocs{state};
+  for (auto _ : state) {
+    std::unordered_map<int, std::size_t> counts;
+    for (auto x : values) {
+      counts[x]++;
+    }
+    benchmark::DoNotOptimize(counts.size());
+  }
+  state.SetItemsProcessed(state.iterations() * ROWS);
+}
+BENCHMARK(BM_CountByUnorderedMap)->Apply(KeyCounts);
+
+void BM_CountBy(benchmark::State& state) {
+  const auto values = bench::Ints(ROWS, static_cast<int>(state.range(0)));
+  bench::TAllocationCounter allocs{state};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(utils::CountBy(values, [](int x) { return x; }).size());
+  }
+  state.SetItemsProcessed(state.iterations() * ROWS);
+}
+BENCHMARK(BM_CountBy)->Apply(KeyCounts);
+
+/*******************************************************************************
+*                                   GroupBy                                   *
+*******************************************************************************/
+
+void BM_GroupSumUnorderedMap(benchmark::State& state) {
+  const auto keys = bench::Ints(ROWS, static_cast<int>(state.range(0)));
+  const auto values = bench::Doubles(ROWS);
+  for (auto _ : state) {
+    std::unordered_map<int, double> sums;
+    for (std::size_t i = 0; i < ROWS; i++) {
+      sums[keys[i]] += values[i];
+    }
+    benchmark::DoNotOptimize(sums.size());
+  }
+  state.SetItemsProcessed(state.iterations() * ROWS);
+}
+BENCHMARK(BM_GroupSumUnorderedMap)->Apply(KeyCounts);
+
+void BM_GroupSum(benchmark::State& state) {
+  const auto keys = bench::Ints(ROWS, static_cast<int>(state.range(0)));
+  const auto values = bench::Doubles(ROWS);
+  for (auto _ : state) {
+    const auto sums = utils::GroupBy(
+      utils::Zip(keys, values),
+      [](const auto& row) { return std::get<0>(row); },
+      0.0,
+      [](double sum, const auto& row) { return sum + std::get<1>(row); }
+    );
+    benchmark::DoNotOptimize(sums.size());
+  }
+  state.SetItemsProcessed(state.iterations() * ROWS);
+}
+BENCHMARK(BM_GroupSum)->Apply(KeyCounts);
+
+/*******************************************************************************
+*                                  Distinct                                   *
+*******************************************************************************/
+
+void BM_DistinctWordsUnorderedSet(benchmark::State& state) {
+  const auto words = bench::Words(ROWS / 4, 4);
+  for (auto _ : state) {
+    std::unordered_set<std::string_view> seen;
+    std::vector<std::string_view> result;
+    for (const auto& word : words) {
+      if (seen.insert(word).second) {
+        result.push_back(word);
+      }
+    }
+    benchmark::DoNotOptimize(result.size());
+  }
+  state.SetItemsProcessed(state.iterations() * words.size());
+}
+BENCHMARK(BM_DistinctWordsUnorderedSet);
+
+void BM_DistinctWords(benchmark::State& state) {
+  const auto words = bench::Words(ROWS / 4, 4);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(utils::Distinct(utils::Map(words, [](const std::string& w) { return std::string_view{w}; })).size());
+  }
+  state.SetItemsProcessed(state.iterations() * words.size());
+}
+BENCHMARK(BM_DistinctWords);
+
+}  // namespace
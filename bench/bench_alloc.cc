@@ -0,0 +1,87 @@
+#include "bench_common.hh"
+
+#include <cstdlib>
+#include <new>
+
+/// Replacement of the global allocation functions that counts the calls of
+/// the benchmark threads for `bench::TAllocationCounter`
+
+namespace {
+
+thread_local u64 Allocations = 0;
+
+void* Allocate(std::size_t size) {
+  Allocations++;
+  if (void* p = std::malloc(size == 0 ? 1 : size)) {
+    return p;
+  }
+  throw std::bad_alloc{};
+}
+
+void* AllocateAligned(std::size_t size, std::align_val_t alignment) {
+  Allocations++;
+  const auto align = static_cast<std::size_t>(alignment);
+  // aligned_alloc requires the size to be a multiple of the alignment
+  if (void* p = std::aligned_alloc(align, (size + align - 1) / align * align)) {
+    return p;
+  }
+  throw std::bad_alloc{};
+}
+
+}  // namespace
+
+namespace bench {
+
+u64 AllocationCount() {
+  return Allocations;
+}
+
+}  // namespace bench
+
+void* operator new(std::size_t size) {
+  return Allocate(size);
+}
+
+void* operator new[](std::size_t size) {
+  return Allocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+  return AllocateAligned(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+  return AllocateAligned(size, alignment);
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept {
+  std::free(p);
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cpputils/common.hh>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+/// Shared helpers of the benchmarks: deterministic input generators and
+/// allocation counting
+namespace bench {
+
+/*******************************************************************************
+*                                 Allocations                                 *
+*******************************************************************************/
+
+/// Number of `operator new` calls made by this thread so far. The global
+/// `operator new` is replaced in bench_alloc.cc to maintain it.
+u64 AllocationCount();
+
+/// Reports the average number of allocations per iteration as the "allocs"
+/// counter. Create it right before the benchmark loop so that the setup is
+/// not counted.
+class TAllocationCounter {
+public:
+  explicit TAllocationCounter(benchmark::State& state) : State{state}, Start{AllocationCount()} {}
+
+  ~TAllocationCounter() {
+    State.counters["allocs"] = benchmark::Counter(
+      static_cast<double>(AllocationCount() - Start),
+      benchmark::Counter::kAvgIterations
+    );
+  }
+
+private:
+  benchmark::State& State;
+  u64 Start;
+};
+
+/*******************************************************************************
+*                                 Generators                                  *
+*******************************************************************************/
+
+/// Inputs are generated from a fixed seed, so that results of different
+/// versions of the library are comparable
+inline constexpr u32 SEED = 1337;
+
+inline std::vector<std::string> Words(std::size_t count, std::size_t maxLength = 12) {
+  std::mt19937 rng{SEED};
+  std::vector<std::string> result;
+  result.reserve(count);
+  for (std::size_t i = 0; i < count; i++) {
+    std::string word(1 + rng() % maxLength, '\0');
+    for (auto& c : word) {
+      c = static_cast<char>('a' + rng() % 26);
+    }
+    result.push_back(std::move(word));
+  }
+  return result;
+}
+
+/// Service log lines like
+///   2024-05-01T12:34:56.789Z INFO [worker-3] GET /api/v1/users/8123 status=200 latency_ms=12.5 host=backend-17
+inline std::string LogLines(std::size_t count) {
+  static const char* LEVELS[] = {"DEBUG", "INFO", "INFO", "INFO", "WARN", "ERROR"};
+  static const char* METHODS[] = {"GET", "GET", "POST", "PUT", "DELETE"};
+  static const char* RESOURCES[] = {"users", "orders", "sessions", "items", "metrics"};
+  static const int STATUSES[] = {200, 200, 200, 201, 204, 304, 400, 404, 500};
+  std::mt19937 rng{SEED};
+  std::string result;
+  for (std::size_t i = 0; i < count; i++) {
+    result += "2024-05-01T12:";
+    result += std::to_string(10 + rng() % 50);
+    result += ':';
+    result += std::to_string(10 + rng() % 50);
+    result += '.';
+    result += std::to_string(100 + rng() % 900);
+    result += "Z ";
+    result += LEVELS[rng() % std::size(LEVELS)];
+    result += " [worker-";
+    result += std::to_string(rng() % 16);
+    result += "] ";
+    result += METHODS[rng() % std::size(METHODS)];
+    result += " /api/v1/";
+    result += RESOURCES[rng() % std::size(RESOURCES)];
+    result += '/';
+    result += std::to_string(rng() % 100000);
+    result += " status=";
+    result += std::to_string(STATUSES[rng() % std::size(STATUSES)]);
+    result += " latency_ms=";
+    result += std::to_string(rng() % 500);
+    result += '.';
+    result += std::to_string(rng() % 10);
+    result += " host=backend-";
+    result += std::to_string(rng() % 32);
+    result += '\n';
+  }
+  return result;
+}
+
+/// CSV with an integer id, a name, a price and a quantity per row
+inline std::string Csv(std::size_t rows) {
+  std::mt19937 rng{SEED};
+  const auto names = Words(64);
+  std::string result;
+  for (std::size_t i = 0; i < rows; i++) {
+    result += std::to_string(i);
+    result += ',';
+    result += names[rng() % names.size()];
+    result += ',';
+    result += std::to_string(rng() % 10000);
+    result += '.';
+    result += std::to_string(10 + rng() % 90);
+    result += ',';
+    result += std::to_string(rng() % 1000);
+    result += '\n';
+  }
+  return result;
+}
+
+inline std::vector<double> Doubles(std::size_t count) {
+  std::mt19937_64 rng{SEED};
+  std::uniform_real_distribution<double> dist{-1000.0, 1000.0};
+  std::vector<double> result(count);
+  for (auto& x : result) {
+    x = dist(rng);
+  }
+  return result;
+}
+
+inline std::vector<int> Ints(std::size_t count, int maxValue = 1000) {
+  std::mt19937 rng{SEED};
+  std::vector<int> result(count);
+  for (auto& x : result) {
+    x = static_cast<int>(rng() % (maxValue + 1));
+  }
+  return result;
+}
+
+/// Random 8x8 GF(2) blocks, one row per byte
+inline std::vector<u64> Gf2Blocks(std::size_t count) {
+  std::mt19937_64 rng{SEED};
+  std::vector<u64> result(count);
+  for (auto& x : result) {
+    x = rng();
+  }
+  return result;
+}
+
+}  // namespace bench
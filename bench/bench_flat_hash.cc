@@ -0,0 +1,155 @@
+#include "bench_common.hh"
+
+#include <cpputils/flat_hash.hh>
+
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+/// 1K keys fit in L1, 64K in L2/L3, 1M only in memory
+void MapSizes(benchmark::internal::Benchmark* b) {
+  b->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 20);
+}
+
+/// Distinct keys, the first `count` are inserted and the rest are misses
+std::vector<u64> Keys(std::size_t count) {
+  std::mt19937_64 rng{bench::SEED};
+  std::vector<u64> result(2 * count);
+  for (auto& key : result) {
+    key = rng();
+  }
+  return result;
+}
+
+template<class TMap>
+TMap FilledMap(const std::vector<u64>& keys, std::size_t count) {
+  TMap map;
+  for (std::size_t i = 0; i < count; i++) {
+    map[keys[i]] = i;
+  }
+  return map;
+}
+
+/*******************************************************************************
+*                                Integer keys                                 *
+*******************************************************************************/
+
+template<class TMap>
+void BM_Insert(benchmark::State& state) {
+  const auto count = static_cast<std::size_t>(state.range(0));
+  const auto keys = Keys(count);
+  bench::TAllocationCounter allocs{state};
+  for (auto _ : state) {
+    TMap map;
+    for (std::size_t i = 0; i < count; i++) {
+      map[keys[i]] = i;
+    }
+    benchmark::DoNotOptimize(map.size());
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK_TEMPLATE(BM_Insert, std::unordered_map<u64, u64>)->Apply(MapSizes);
+BENCHMARK_TEMPLATE(BM_Insert, utils::TFlatHashMap<u64, u64>)->Apply(MapSizes);
+
+template<class TMap>
+void BM_LookupHit(benchmark::State& state) {
+  const auto count = static_cast<std::size_t>(state.range(0));
+  const auto keys = Keys(count);
+  const auto map = FilledMap<TMap>(keys, count);
+  for (auto _ : state) {
+    u64 sum = 0;
+    for (std::size_t i = 0; i < count; i++) {
+      sum += map.find(keys[i])->second;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK_TEMPLATE(BM_LookupHit, std::unordered_map<u64, u64>)->Apply(MapSizes);
+BENCHMARK_TEMPLATE(BM_LookupHit, utils::TFlatHashMap<u64, u64>)->Apply(MapSizes);
+
+template<class TMap>
+void BM_LookupMiss(benchmark::State& state) {
+  const auto count = static_cast<std::size_t>(state.range(0));
+  const auto keys = Keys(count);
+  const auto map = FilledMap<TMap>(keys, count);
+  for (auto _ : state) {
+    std::size_t found = 0;
+    for (std::size_t i = count; i < 2 * count; i++) {
+      found += map.count(keys[i]);
+    }
+    benchmark::DoNotOptimize(found);
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK_TEMPLATE(BM_LookupMiss, std::unordered_map<u64, u64>)->Apply(MapSizes);
+BENCHMARK_TEMPLATE(BM_LookupMiss, utils::TFlatHashMap<u64, u64>)->Apply(MapSizes);
+
+/// Erases everything, the copy of the map is not timed
+template<class TMap>
+void BM_Erase(benchmark::State& state) {
+  const auto count = static_cast<std::size_t>(state.range(0));
+  const auto keys = Keys(count);
+  const auto filled = FilledMap<TMap>(keys, count);
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto map = filled;
+    state.ResumeTiming();
+    for (std::size_t i = 0; i < count; i++) {
+      map.erase(keys[i]);
+    }
+    benchmark::DoNotOptimize(map.size());
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK_TEMPLATE(BM_Erase, std::unordered_map<u64, u64>)->Apply(MapSizes);
+BENCHMARK_TEMPLATE(BM_Erase, utils::TFlatHashMap<u64, u64>)->Apply(MapSizes);
+
+/*******************************************************************************
+*                                 String keys                                 *
+*******************************************************************************/
+
+/// Word counting with lookups by `std::string_view`, which the std map can
+/// only do by building a `std::string` for every lookup
+template<class TMap>
+void BM_CountWords(benchmark::State& state) {
+  const auto words = bench::Words(static_cast<std::size_t>(state.range(0)), 6);
+  std::vector<std::string_view> views(words.begin(), words.end());
+  bench::TAllocationCounter allocs{state};
+  for (auto _ : state) {
+    TMap counts;
+    for (const auto word : views) {
+      if (const auto it = counts.find(std::string(word)); it != counts.end()) {
+        it->second++;
+      } else {
+        counts.emplace(std::string(word), 1);
+      }
+    }
+    benchmark::DoNotOptimize(counts.size());
+  }
+  state.SetItemsProcessed(state.iterations() * words.size());
+}
+BENCHMARK_TEMPLATE(BM_CountWords, std::unordered_map<std::string, u64>)->Apply(MapSizes);
+
+void BM_CountWordsFlat(benchmark::State& state) {
+  const auto words = bench::Words(static_cast<std::size_t>(state.range(0)), 6);
+  std::vector<std::string_view> views(words.begin(), words.end());
+  bench::TAllocationCounter allocs{state};
+  for (auto _ : state) {
+    utils::TFlatHashMap<std::string, u64> counts;
+    for (const auto word : views) {
+      counts[word]++;
+    }
+    benchmark::DoNotOptimize(counts.size());
+  }
+  state.SetItemsProcessed(state.iterations() * words.size());
+}
+BENCHMARK(BM_CountWordsFlat)->Apply(MapSizes);
+
+}  // namespace
@@ -0,0 +1,84 @@
+#include "bench_common.hh"
+
+#include <cpputils/common.hh>
+#include <cpputils/string.hh>
+
+#include <initializer_list>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+/// `utils::Format` as it was before the compile-time engine, kept as a baseline
+template <typename... Args>
+std::string LegacyFormat(std::string_view formatStr, Args&&... args) {
+  const auto toString = [](const auto& x) {
+    std::ostringstream os;
+    os << x;
+    return os.str();
+  };
+  std::initializer_list<std::string> replacements = {toString(std::forward<Args>(args))...};
+  auto currentReplacement = replacements.begin();
+  std::ostringstream result;
+  bool skip{false};
+  for (auto c : formatStr) {
+    if (skip) {
+      skip = false;
+      result << c;
+      continue;
+    }
+    if (c == '%') {
+      result << *currentReplacement;
+      currentReplacement++;
+    } else if (c == '\\') {
+      skip = true;
+    } else {
+      result << c;
+    }
+  }
+  return result.str();
+}
+
+void BM_FormatLegacy(benchmark::State& state) {
+  i64 i = 0;
+  bench::TAllocationCounter allocs{state};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(LegacyFormat("requests{host=\"%\",code=%} % %", "backend-17", 200, i++, 0.125));
+  }
+}
+BENCHMARK(BM_FormatLegacy);
+
+void BM_FormatRuntime(benchmark::State& state) {
+  i64 i = 0;
+  bench::TAllocationCounter allocs{state};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(utils::Format("requests{host=\"%\",code=%} % %", "backend-17", 200, i++, 0.125));
+  }
+}
+BENCHMARK(BM_FormatRuntime);
+
+void BM_FormatCompileTime(benchmark::State& state) {
+  i64 i = 0;
+  bench::TAllocationCounter allocs{state};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(utils::Format(FMT("requests{host=\"%\",code=%} % %"), "backend-17", 200, i++, 0.125));
+  }
+}
+BENCHMARK(BM_FormatCompileTime);
+
+void BM_FormatToReusedBuffer(benchmark::State& state) {
+  i64 i = 0;
+  std::string buffer;
+  bench::TAllocationCounter allocs{state};
+  for (auto _ : state) {
+    buffer.clear();
+    utils::FormatTo(buffer, FMT("requests{host=\"%\",code=%} % %"), "backend-17", 200, i++, 0.125);
+    benchmark::DoNotOptimize(buffer.data());
+  }
+}
+BENCHMARK(BM_FormatToReusedBuffer);
+
+}  // namespace
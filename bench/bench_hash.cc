@@ -0,0 +1,127 @@
+#include "bench_common.hh"
+
+#include <cpputils/hash.hh>
+#include <cpputils/reflect.hh>
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+using utils::detail::EHashKernel;
+
+void InputSizes(benchmark::internal::Benchmark* b) {
+  b->Arg(8)->Arg(64)->Arg(1 << 10)->Arg(1 << 16);
+}
+
+std::string Bytes(std::size_t size) {
+  std::string result;
+  for (const auto& word : bench::Words(size / 4 + 1)) {
+    result += word;
+  }
+  result.resize(size);
+  return result;
+}
+
+/*******************************************************************************
+*                                 Byte hash                                   *
+*******************************************************************************/
+
+void BM_StdHashBytes(benchmark::State& state) {
+  const auto bytes = Bytes(static_cast<std::size_t>(state.range(0)));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(std::hash<std::string_view>{}(bytes));
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_StdHashBytes)->Apply(InputSizes);
+
+void BM_HashBytes(benchmark::State& state) {
+  const auto bytes = Bytes(static_cast<std::size_t>(state.range(0)));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(utils::HashBytes(bytes));
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_HashBytes)->Apply(InputSizes);
+
+void BM_HashBytesScalar(benchmark::State& state) {
+  const auto bytes = Bytes(static_cast<std::size_t>(state.range(0)));
+  const auto& kernels = utils::detail::GetHashKernels(EHashKernel::Scalar);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(kernels.HashLong(bytes.data(), bytes.size(), 0));
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_HashBytesScalar)->Arg(1 << 10)->Arg(1 << 16);
+
+/*******************************************************************************
+*                               Composite keys                                *
+*******************************************************************************/
+
+struct TJoinKey {
+  u32 Customer;
+  u32 Region;
+  u64 Order;
+
+  REFLECT(TJoinKey, Customer, Region, Order);
+
+  bool operator==(const TJoinKey& other) const {
+    return Tie() == other.Tie();
+  }
+};
+
+/// The usual hand-written combination of `std::hash` results
+struct TJoinKeyStdHash {
+  std::size_t operator()(const TJoinKey& key) const {
+    auto hash = std::hash<u32>{}(key.Customer);
+    hash ^= std::hash<u32>{}(key.Region) + 0x9E3779B9 + (hash << 6) + (hash >> 2);
+    hash ^= std::hash<u64>{}(key.Order) + 0x9E3779B9 + (hash << 6) + (hash >> 2);
+    return hash;
+  }
+};
+
+std::vector<TJoinKey> JoinKeys() {
+  const auto ints = bench::Ints(3 << 16, 1 << 20);
+  std::vector<TJoinKey> result;
+  for (std::size_t i = 0; i + 2 < ints.size(); i += 3) {
+    result.push_back({static_cast<u32>(ints[i] % 1000), static_cast<u32>(ints[i + 1] % 16), static_cast<u64>(ints[i + 2])});
+  }
+  return result;
+}
+
+template<class THasher>
+void BM_DedupJoinKeys(benchmark::State& state) {
+  const auto keys = JoinKeys();
+  for (auto _ : state) {
+    std::unordered_set<TJoinKey, THasher> seen;
+    seen.reserve(keys.size());
+    for (const auto& key : keys) {
+      seen.insert(key);
+    }
+    benchmark::DoNotOptimize(seen.size());
+  }
+  state.SetItemsProcessed(state.iterations() * keys.size());
+}
+BENCHMARK_TEMPLATE(BM_DedupJoinKeys, TJoinKeyStdHash);
+BENCHMARK_TEMPLATE(BM_DedupJoinKeys, utils::THash);
+
+void BM_HashStringPairs(benchmark::State& state) {
+  const auto words = bench::Words(1 << 12);
+  for (auto _ : state) {
+    u64 sum = 0;
+    for (std::size_t i = 0; i + 1 < words.size(); i++) {
+      sum += utils::Hash(std::tie(words[i], words[i + 1]));
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * (words.size() - 1));
+}
+BENCHMARK(BM_HashStringPairs);
+
+}  // namespace
@@ -0,0 +1,328 @@
+#include "bench_common.hh"
+
+#include <cpputils/itertools.hh>
+
+#include <algorithm>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+constexpr std::size_t SIZE = 1 << 16;
+
+/*******************************************************************************
+*                                 Map/Filter                                  *
+*******************************************************************************/
+
+void BM_MapSumRawLoop(benchmark::State& state) {
+  const auto values = bench::Doubles(SIZE);
+  for (auto _ : state) {
+    double sum = 0;
+    for (std::size_t i = 0; i < values.size(); i++) {
+      sum += values[i] * 2 + 1;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * SIZE);
+}
+BENCHMARK(BM_MapSumRawLoop);
+
+void BM_MapSum(benchmark::State& state) {
+  const auto values = bench::Doubles(SIZE);
+  for (auto _ : state) {
+    double sum = 0;
+    for (auto x : utils::Map(values, [](double x) { return x * 2 + 1; })) {
+      sum += x;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * SIZE);
+}
+BENCHMARK(BM_MapSum);
+
+void BM_FilterMapSumRawLoop(benchmark::State& state) {
+  const auto values = bench::Ints(SIZE);
+  for (auto _ : state) {
+    i64 sum = 0;
+    for (auto x : values) {
+      if (x % 3 == 0) {
+        sum += static_cast<i64>(x) * x;
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * SIZE);
+}
+BENCHMARK(BM_FilterMapSumRawLoop);
+
+void BM_FilterMapSum(benchmark::State& state) {
+  const auto values = bench::Ints(SIZE);
+  for (auto _ : state) {
+    i64 sum = 0;
+    const auto divisible = utils::Filter(values, [](int x) { return x % 3 == 0; });
+    for (auto x : utils::Map(divisible, [](int x) { return static_cast<i64>(x) * x; })) {
+      sum += x;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * SIZE);
+}
+BENCHMARK(BM_FilterMapSum);
+
+/*******************************************************************************
+*                                     Zip                                     *
+*******************************************************************************/
+
+void BM_ZipDotRawLoop(benchmark::State& state) {
+  const auto a = bench::Doubles(SIZE);
+  const auto b = bench::Doubles(SIZE);
+  const auto c = bench::Doubles(SIZE);
+  for (auto _ : state) {
+    double sum = 0;
+    for (std::size_t i = 0; i < SIZE; i++) {
+      sum += a[i] * b[i] + c[i];
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * SIZE);
+}
+BENCHMARK(BM_ZipDotRawLoop);
+
+void BM_ZipDot(benchmark::State& state) {
+  const auto a = bench::Doubles(SIZE);
+  const auto b = bench::Doubles(SIZE);
+  const auto c = bench::Doubles(SIZE);
+  for (auto _ : state) {
+    double sum = 0;
+    for (const auto& [x, y, z] : utils::Zip(a, b, c)) {
+      sum += x * y + z;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * SIZE);
+}
+BENCHMARK(BM_ZipDot);
+
+/*******************************************************************************
+*                                  ToVector                                   *
+*******************************************************************************/
+
+void BM_StdTransform(benchmark::State& state) {
+  const auto values = bench::Ints(SIZE);
+  bench::TAllocationCounter allocs{state};
+  for (auto _ : state) {
+    std::vector<i64> result(values.size());
+    std::transform(values.begin(), values.end(), result.begin(), [](int x) { return static_cast<i64>(x) * 3; });
+    benchmark::DoNotOptimize(result.data());
+  }
+  state.SetItemsProcessed(state.iterations() * SIZE);
+}
+BENCHMARK(BM_StdTransform);
+
+void BM_MapToVector(benchmark::State& state) {
+  const auto values = bench::Ints(SIZE);
+  bench::TAllocationCounter allocs{state};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(utils::ToVector(utils::Map(values, [](int x) { return static_cast<i64>(x) * 3; })).data());
+  }
+  state.SetItemsProcessed(state.iterations() * SIZE);
+}
+BENCHMARK(BM_MapToVector);
+
+void BM_FilterToVector(benchmark::State& state) {
+  const auto values = bench::Ints(SIZE);
+  bench::TAllocationCounter allocs{state};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(utils::ToVector(utils::Filter(values, [](int x) { return x % 2 == 0; })).data());
+  }
+  state.SetItemsProcessed(state.iterations() * SIZE);
+}
+BENCHMARK(BM_FilterToVector);
+
+/*******************************************************************************
+*                                   Batched                                   *
+*******************************************************************************/
+
+constexpr std::size_t BATCH = 2048;
+
+/// Stands in for a bulk sink (a socket write, a columnar append), which is
+/// an opaque call per invocation
+[[gnu::noinline]] void BulkAppend(std::vector<i64>& sink, const i64* data, std::size_t size) {
+  sink.insert(sink.end(), data, data + size);
+}
+
+void BM_SinkPerElement(benchmark::State& state) {
+  const auto values = bench::Ints(SIZE);
+  std::vector<i64> sink;
+  sink.reserve(SIZE);
+  for (auto _ : state) {
+    sink.clear();
+    for (auto x : utils::Map(values, [](int x) { return static_cast<i64>(x) * 3; })) {
+      BulkAppend(sink, &x, 1);
+    }
+    benchmark::DoNotOptimize(sink.data());
+  }
+  state.SetItemsProcessed(state.iterations() * SIZE);
+}
+BENCHMARK(BM_SinkPerElement);
+
+void BM_SinkBatched(benchmark::State& state) {
+  const auto values = bench::Ints(SIZE);
+  std::vector<i64> sink;
+  sink.reserve(SIZE);
+  bench::TAllocationCounter allocs{state};
+  for (auto _ : state) {
+    sink.clear();
+    for (const auto batch : utils::Batched(utils::Map(values, [](int x) { return static_cast<i64>(x) * 3; }), BATCH)) {
+      BulkAppend(sink, batch.data(), batch.size());
+    }
+    benchmark::DoNotOptimize(sink.data());
+  }
+  state.SetItemsProcessed(state.iterations() * SIZE);
+}
+BENCHMARK(BM_SinkBatched);
+
+/*******************************************************************************
+*                                 Reductions                                  *
+*******************************************************************************/
+
+void BM_FilterSumRawLoop(benchmark::State& state) {
+  const auto values = bench::Doubles(SIZE);
+  for (auto _ : state) {
+    double sum = 0;
+    for (auto x : values) {
+      const auto square = x * x;
+      if (square > 250000) {
+        sum += square;
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * SIZE);
+}
+BENCHMARK(BM_FilterSumRawLoop);
+
+void BM_FilterSum(benchmark::State& state) {
+  const auto values = bench::Doubles(SIZE);
+  for (auto _ : state) {
+    const auto squares = utils::Map(values, [](double x) { return x * x; });
+    benchmark::DoNotOptimize(utils::Sum(utils::Filter(squares, [](double x) { return x > 250000; })));
+  }
+  state.SetItemsProcessed(state.iterations() * SIZE);
+}
+BENCHMARK(BM_FilterSum);
+
+void BM_MinMaxRawLoop(benchmark::State& state) {
+  const auto values = bench::Ints(SIZE);
+  for (auto _ : state) {
+    auto min = values[0];
+    auto max = values[0];
+    for (auto x : values) {
+      if (x < min) {
+        min = x;
+      } else if (max < x) {
+        max = x;
+      }
+    }
+    benchmark::DoNotOptimize(min);
+    benchmark::DoNotOptimize(max);
+  }
+  state.SetItemsProcessed(state.iterations() * SIZE);
+}
+BENCHMARK(BM_MinMaxRawLoop);
+
+void BM_MinMax(benchmark::State& state) {
+  const auto values = bench::Ints(SIZE);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(utils::MinMax(values));
+  }
+  state.SetItemsProcessed(state.iterations() * SIZE);
+}
+BENCHMARK(BM_MinMax);
+
+void BM_CountIfRawLoop(benchmark::State& state) {
+  const auto values = bench::Ints(SIZE);
+  for (auto _ : state) {
+    std::size_t count = 0;
+    for (auto x : values) {
+      if (x % 3 == 0) {
+        count++;
+      }
+    }
+    benchmark::DoNotOptimize(count);
+  }
+  state.SetItemsProcessed(state.iterations() * SIZE);
+}
+BENCHMARK(BM_CountIfRawLoop);
+
+void BM_CountIf(benchmark::State& state) {
+  const auto values = bench::Ints(SIZE);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(utils::CountIf(values, [](int x) { return x % 3 == 0; }));
+  }
+  state.SetItemsProcessed(state.iterations() * SIZE);
+}
+BENCHMARK(BM_CountIf);
+
+/*******************************************************************************
+*                                  Pipelines                                  *
+*******************************************************************************/
+
+/// Six stages with a map over a filter, so that the terminals cannot lower
+/// the chain into an array loop
+const auto PIPELINE =
+  utils::Map([](int x) { return x * 7 + 1; })
+  | utils::Filter([](int x) { return x % 3 != 0; })
+  | utils::Map([](int x) { return static_cast<i64>(x) * x; })
+  | utils::Filter([](i64 x) { return x % 5 != 0; })
+  | utils::Map([](i64 x) { return x >> 2; })
+  | utils::Filter([](i64 x) { return x & 1; });
+
+void BM_PipelineRawLoop(benchmark::State& state) {
+  const auto values = bench::Ints(SIZE);
+  for (auto _ : state) {
+    i64 sum = 0;
+    for (auto v : values) {
+      const int x = v * 7 + 1;
+      if (x % 3 == 0) {
+        continue;
+      }
+      const auto y = static_cast<i64>(x) * x;
+      if (y % 5 == 0) {
+        continue;
+      }
+      const auto z = y >> 2;
+      if (z & 1) {
+        sum += z;
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * SIZE);
+}
+BENCHMARK(BM_PipelineRawLoop);
+
+void BM_PipelinePull(benchmark::State& state) {
+  const auto values = bench::Ints(SIZE);
+  for (auto _ : state) {
+    i64 sum = 0;
+    for (auto x : values | PIPELINE) {
+      sum += x;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * SIZE);
+}
+BENCHMARK(BM_PipelinePull);
+
+void BM_PipelinePush(benchmark::State& state) {
+  const auto values = bench::Ints(SIZE);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(values | PIPELINE | utils::Sum());
+  }
+  state.SetItemsProcessed(state.iterations() * SIZE);
+}
+BENCHMARK(BM_PipelinePush);
+
+}  // namespace
@@ -0,0 +1,333 @@
+#include "bench_common.hh"
+
+#include <cpputils/linalg.hh>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+using utils::gf2::detail::EGf2Kernel;
+
+constexpr std::size_t BLOCKS = 1024;
+
+/// Bit-by-bit reference: c[i][j] = xor over k of a[i][k] & b[k][j]
+u64 Mul8x8Naive(u64 a, u64 b) {
+  u64 c = 0;
+  for (int i = 0; i < 8; i++) {
+    for (int j = 0; j < 8; j++) {
+      u64 bit = 0;
+      for (int k = 0; k < 8; k++) {
+        bit ^= (a >> (i * 8 + k)) & (b >> (k * 8 + j)) & 1;
+      }
+      c |= bit << (i * 8 + j);
+    }
+  }
+  return c;
+}
+
+void BM_Gf2Mul8x8Naive(benchmark::State& state) {
+  const auto blocks = bench::Gf2Blocks(BLOCKS + 1);
+  for (auto _ : state) {
+    u64 acc = 0;
+    for (std::size_t i = 0; i < BLOCKS; i++) {
+      acc ^= Mul8x8Naive(blocks[i], blocks[i + 1]);
+    }
+    benchmark::DoNotOptimize(acc);
+  }
+  state.SetItemsProcessed(state.iterations() * BLOCKS);
+}
+BENCHMARK(BM_Gf2Mul8x8Naive);
+
+void BM_Gf2Mul8x8(benchmark::State& state) {
+  const auto blocks = bench::Gf2Blocks(BLOCKS + 1);
+  for (auto _ : state) {
+    u64 acc = 0;
+    for (std::size_t i = 0; i < BLOCKS; i++) {
+      acc ^= utils::gf2::mul8x8(blocks[i], blocks[i + 1]);
+    }
+    benchmark::DoNotOptimize(acc);
+  }
+  state.SetItemsProcessed(state.iterations() * BLOCKS);
+}
+BENCHMARK(BM_Gf2Mul8x8);
+
+void BM_Gf2Transpose8x8(benchmark::State& state) {
+  const auto blocks = bench::Gf2Blocks(BLOCKS);
+  for (auto _ : state) {
+    u64 acc = 0;
+    for (auto block : blocks) {
+      acc ^= utils::gf2::transpose8x8(block);
+    }
+    benchmark::DoNotOptimize(acc);
+  }
+  state.SetItemsProcessed(state.iterations() * BLOCKS);
+}
+BENCHMARK(BM_Gf2Transpose8x8);
+
+/*******************************************************************************
+*                               Batched kernels                               *
+*******************************************************************************/
+
+template<EGf2Kernel Kernel>
+void BM_Gf2KernelMul(benchmark::State& state) {
+  if (!utils::gf2::detail::IsKernelSupported(Kernel)) {
+    state.SkipWithError("unsupported");
+    return;
+  }
+  const auto& kernels = utils::gf2::detail::GetGf2Kernels(Kernel);
+  const auto a = bench::Gf2Blocks(BLOCKS);
+  const auto b = bench::Gf2Blocks(BLOCKS + 1);
+  std::vector<u64> c(BLOCKS);
+  for (auto _ : state) {
+    kernels.Mul(a.data(), b.data() + 1, c.data(), BLOCKS);
+    benchmark::DoNotOptimize(c.data());
+  }
+  state.SetItemsProcessed(state.iterations() * BLOCKS);
+}
+BENCHMARK_TEMPLATE(BM_Gf2KernelMul, EGf2Kernel::Scalar);
+BENCHMARK_TEMPLATE(BM_Gf2KernelMul, EGf2Kernel::Avx2);
+BENCHMARK_TEMPLATE(BM_Gf2KernelMul, EGf2Kernel::Gfni);
+
+template<EGf2Kernel Kernel>
+void BM_Gf2KernelMulAddConst(benchmark::State& state) {
+  if (!utils::gf2::detail::IsKernelSupported(Kernel)) {
+    state.SkipWithError("unsupported");
+    return;
+  }
+  const auto& kernels = utils::gf2::detail::GetGf2Kernels(Kernel);
+  const auto a = bench::Gf2Blocks(BLOCKS + 1);
+  std::vector<u64> c(BLOCKS);
+  for (auto _ : state) {
+    kernels.MulAddConst(a.data(), a[BLOCKS], c.data(), BLOCKS);
+    benchmark::DoNotOptimize(c.data());
+  }
+  state.SetItemsProcessed(state.iterations() * BLOCKS);
+}
+BENCHMARK_TEMPLATE(BM_Gf2KernelMulAddConst, EGf2Kernel::Scalar);
+BENCHMARK_TEMPLATE(BM_Gf2KernelMulAddConst, EGf2Kernel::Avx2);
+BENCHMARK_TEMPLATE(BM_Gf2KernelMulAddConst, EGf2Kernel::Gfni);
+
+template<EGf2Kernel Kernel>
+void BM_Gf2KernelTranspose(benchmark::State& state) {
+  if (!utils::gf2::detail::IsKernelSupported(Kernel)) {
+    state.SkipWithError("unsupported");
+    return;
+  }
+  const auto& kernels = utils::gf2::detail::GetGf2Kernels(Kernel);
+  auto blocks = bench::Gf2Blocks(BLOCKS);
+  for (auto _ : state) {
+    kernels.Transpose(blocks.data(), blocks.data(), BLOCKS);
+    benchmark::DoNotOptimize(blocks.data());
+  }
+  state.SetItemsProcessed(state.iterations() * BLOCKS);
+}
+BENCHMARK_TEMPLATE(BM_Gf2KernelTranspose, EGf2Kernel::Scalar);
+BENCHMARK_TEMPLATE(BM_Gf2KernelTranspose, EGf2Kernel::Avx2);
+BENCHMARK_TEMPLATE(BM_Gf2KernelTranspose, EGf2Kernel::Gfni);
+
+/*******************************************************************************
+*                               Matrix product                                *
+*******************************************************************************/
+
+/// Random square matrix of `bits` bits per side, a multiple of 8
+utils::gf2::TMatrix64bit RandomMatrix(std::size_t bits, u32 seed) {
+  utils::gf2::TMatrix64bit result(bits, bits);
+  const auto blocks = bench::Gf2Blocks(result.BlockRows() * result.BlockCols() + seed);
+  for (std::size_t i = 0; i < result.BlockRows(); i++) {
+    for (std::size_t j = 0; j < result.BlockCols(); j++) {
+      result.Block(i, j).data = blocks[seed + i * result.BlockCols() + j];
+    }
+  }
+  return result;
+}
+
+utils::gf2::TMatrix64bit RandomColumn(std::size_t bits) {
+  utils::gf2::TMatrix64bit result(bits, 1);
+  const auto blocks = bench::Gf2Blocks(bits);
+  for (std::size_t i = 0; i < bits; i++) {
+    result.Set(i, 0, blocks[i] & 1);
+  }
+  return result;
+}
+
+/// The classic triple loop over blocks
+void BM_Gf2MatMulBlocked(benchmark::State& state) {
+  const auto bits = static_cast<std::size_t>(state.range(0));
+  const auto a = RandomMatrix(bits, 0);
+  const auto b = RandomMatrix(bits, 1);
+  for (auto _ : state) {
+    utils::gf2::TMatrix64bit c(bits, bits);
+    for (std::size_t i = 0; i < a.BlockRows(); i++) {
+      for (std::size_t j = 0; j < b.BlockCols(); j++) {
+        auto sum = utils::gf2::T8x8::zero();
+        for (std::size_t k = 0; k < a.BlockCols(); k++) {
+          sum = utils::gf2::T8x8::add(sum, utils::gf2::T8x8::mul(a.Block(i, k), b.Block(k, j)));
+        }
+        c.Block(i, j) = sum;
+      }
+    }
+    benchmark::DoNotOptimize(c.Block(0, 0).data);
+  }
+}
+BENCHMARK(BM_Gf2MatMulBlocked)->Arg(256)->Arg(1024)->Unit(benchmark::kMillisecond);
+
+void BM_Gf2MatMul(benchmark::State& state) {
+  const auto bits = static_cast<std::size_t>(state.range(0));
+  const auto a = RandomMatrix(bits, 0);
+  const auto b = RandomMatrix(bits, 1);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize((a * b).Block(0, 0).data);
+  }
+}
+BENCHMARK(BM_Gf2MatMul)->Arg(256)->Arg(1024)->Arg(4096)->Unit(benchmark::kMillisecond);
+
+template<EGf2Kernel Kernel>
+void BM_Gf2MatMulBlocks(benchmark::State& state) {
+  if (!utils::gf2::detail::IsKernelSupported(Kernel)) {
+    state.SkipWithError("unsupported");
+    return;
+  }
+  const auto& kernels = utils::gf2::detail::GetGf2Kernels(Kernel);
+  const auto bits = static_cast<std::size_t>(state.range(0));
+  const auto a = RandomMatrix(bits, 0);
+  const auto b = RandomMatrix(bits, 1);
+  utils::gf2::TMatrix64bit c(bits, bits);
+  const auto n = a.BlockRows();
+  for (auto _ : state) {
+    utils::gf2::detail::MulBlocks(kernels, &a.Block(0, 0), &b.Block(0, 0), &c.Block(0, 0), n, n, n);
+    benchmark::DoNotOptimize(c.Block(0, 0).data);
+  }
+}
+BENCHMARK_TEMPLATE(BM_Gf2MatMulBlocks, EGf2Kernel::Avx2)->Arg(256)->Arg(1024)->Arg(4096)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Gf2MatMulBlocks, EGf2Kernel::Gfni)->Arg(256)->Arg(1024)->Arg(4096)->Unit(benchmark::kMillisecond);
+
+void BM_Gf2MatMulM4rm(benchmark::State& state) {
+  const auto bits = static_cast<std::size_t>(state.range(0));
+  const auto a = RandomMatrix(bits, 0);
+  const auto b = RandomMatrix(bits, 1);
+  const auto rowsA = a.ToBitRows();
+  const auto rowsB = b.ToBitRows();
+  for (auto _ : state) {
+    utils::gf2::detail::TBitRows rowsC(rowsA.Rows, rowsB.Words);
+    utils::gf2::detail::MulAddM4rm(rowsA, rowsB, rowsC, 0, rowsC.Rows, 0, rowsC.Words);
+    benchmark::DoNotOptimize(rowsC.Data.data());
+  }
+}
+BENCHMARK(BM_Gf2MatMulM4rm)->Arg(256)->Arg(1024)->Arg(4096)->Unit(benchmark::kMillisecond);
+
+/*******************************************************************************
+*                              Parallel product                               *
+*******************************************************************************/
+
+/// 1, 2, 4, ... threads up to the number of cores
+void ThreadCounts(benchmark::internal::Benchmark* b) {
+  const auto cores = std::max(std::thread::hardware_concurrency(), 1u);
+  for (const long bits : {4096, 8192}) {
+    for (unsigned threads = 1; threads < cores * 2; threads *= 2) {
+      b->Args({bits, std::min(threads, cores)});
+    }
+  }
+}
+
+void BM_Gf2ParallelMul(benchmark::State& state) {
+  const auto bits = static_cast<std::size_t>(state.range(0));
+  const auto a = RandomMatrix(bits, 0);
+  const auto b = RandomMatrix(bits, 1);
+  // the calling thread is one of them
+  utils::TThreadPool pool{static_cast<std::size_t>(state.range(1)) - 1};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(utils::gf2::ParallelMul(a, b, {&pool}).Block(0, 0).data);
+  }
+}
+BENCHMARK(BM_Gf2ParallelMul)->Apply(ThreadCounts)->ArgNames({"bits", "threads"})->Unit(benchmark::kMillisecond)->UseRealTime();
+
+/// Strassen-Winograd below 8192 bits (one level) and 4096 bits (two levels)
+/// on all cores
+void BM_Gf2ParallelMulStrassen(benchmark::State& state) {
+  const auto bits = static_cast<std::size_t>(state.range(0));
+  const auto a = RandomMatrix(bits, 0);
+  const auto b = RandomMatrix(bits, 1);
+  const auto cutoff = static_cast<std::size_t>(state.range(1));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(utils::gf2::ParallelMul(a, b, {nullptr, cutoff}).Block(0, 0).data);
+  }
+}
+BENCHMARK(BM_Gf2ParallelMulStrassen)
+  ->Args({8192, 0})->Args({8192, 8192})->Args({8192, 4096})
+  ->ArgNames({"bits", "cutoff"})->Unit(benchmark::kMillisecond)->UseRealTime();
+
+/*******************************************************************************
+*                                 Elimination                                 *
+*******************************************************************************/
+
+/// Gaussian elimination on a byte per bit, the generic dense layout
+void BM_Gf2SolveDense(benchmark::State& state) {
+  const auto bits = static_cast<std::size_t>(state.range(0));
+  const auto a = RandomMatrix(bits, 0);
+  const auto b = RandomColumn(bits);
+  std::vector<std::vector<std::uint8_t>> initial(bits, std::vector<std::uint8_t>(bits + 1));
+  for (std::size_t i = 0; i < bits; i++) {
+    for (std::size_t j = 0; j < bits; j++) {
+      initial[i][j] = a.Get(i, j);
+    }
+    initial[i][bits] = b.Get(i, 0);
+  }
+  for (auto _ : state) {
+    auto rows = initial;
+    std::size_t rank = 0;
+    for (std::size_t j = 0; j < bits; j++) {
+      auto pivot = rank;
+      while (pivot < bits && rows[pivot][j] == 0) {
+        pivot++;
+      }
+      if (pivot == bits) {
+        continue;
+      }
+      std::swap(rows[pivot], rows[rank]);
+      for (std::size_t i = 0; i < bits; i++) {
+        if (i != rank && rows[i][j] != 0) {
+          for (std::size_t k = j; k <= bits; k++) {
+            rows[i][k] ^= rows[rank][k];
+          }
+        }
+      }
+      rank++;
+    }
+    benchmark::DoNotOptimize(rows[0][bits]);
+  }
+}
+BENCHMARK(BM_Gf2SolveDense)->Arg(1024)->Unit(benchmark::kMillisecond);
+
+void BM_Gf2Solve(benchmark::State& state) {
+  const auto bits = static_cast<std::size_t>(state.range(0));
+  const auto a = RandomMatrix(bits, 0);
+  const auto b = RandomColumn(bits);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(utils::gf2::Solve(a, b).has_value());
+  }
+}
+BENCHMARK(BM_Gf2Solve)->Arg(1024)->Arg(4096)->Arg(10000)->Unit(benchmark::kMillisecond);
+
+void BM_Gf2Rank(benchmark::State& state) {
+  const auto bits = static_cast<std::size_t>(state.range(0));
+  const auto a = RandomMatrix(bits, 0);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(utils::gf2::Rank(a));
+  }
+}
+BENCHMARK(BM_Gf2Rank)->Arg(1024)->Arg(4096)->Arg(10000)->Unit(benchmark::kMillisecond);
+
+void BM_Gf2Inverse(benchmark::State& state) {
+  const auto bits = static_cast<std::size_t>(state.range(0));
+  const auto a = RandomMatrix(bits, 0);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(utils::gf2::Inverse(a).has_value());
+  }
+}
+BENCHMARK(BM_Gf2Inverse)->Arg(1024)->Arg(4096)->Unit(benchmark::kMillisecond);
+
+}  // namespace
@@ -0,0 +1,55 @@
+#include <cpputils/log.hh>
+
+#include <sstream>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+void BM_LogSynchronousStream(benchmark::State& state) {
+  const int fd = ::open("/dev/null", O_WRONLY);
+  i64 i = 0;
+  for (auto _ : state) {
+    std::ostringstream os;
+    os << "request " << i++ << " took " << 0.25 << " ms from " << "backend-17" << '\n';
+    const auto line = os.str();
+    benchmark::DoNotOptimize(::write(fd, line.data(), line.size()));
+  }
+  ::close(fd);
+}
+BENCHMARK(BM_LogSynchronousStream);
+
+void BM_LogAsync(benchmark::State& state) {
+  const int fd = ::open("/dev/null", O_WRONLY);
+  {
+    utils::TLoggerOptions options;
+    options.Overflow = utils::ELogOverflow::Block;
+    utils::TLogger logger{fd, options};
+    utils::TScopedLogger scope{logger};
+    i64 i = 0;
+    for (auto _ : state) {
+      LOG_INFO(FMT("request % took % ms from %"), i++, 0.25, "backend-17");
+    }
+  }
+  ::close(fd);
+}
+BENCHMARK(BM_LogAsync);
+
+void BM_LogFilteredOut(benchmark::State& state) {
+  const int fd = ::open("/dev/null", O_WRONLY);
+  {
+    utils::TLogger logger{fd};
+    utils::TScopedLogger scope{logger};
+    i64 i = 0;
+    for (auto _ : state) {
+      LOG_DEBUG(FMT("request % took % ms from %"), i++, 0.25, "backend-17");
+    }
+  }
+  ::close(fd);
+}
+BENCHMARK(BM_LogFilteredOut);
+
+}  // namespace
@@ -0,0 +1,260 @@
+#include "bench_common.hh"
+
+#include <cpputils/string.hh>
+
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+/*******************************************************************************
+*                                    Split                                    *
+*******************************************************************************/
+
+const std::string& CsvInput() {
+  static const auto csv = bench::Csv(2000);
+  return csv;
+}
+
+/// What one writes without the library
+std::vector<std::string> SplitByHand(std::string_view s, std::string_view separators) {
+  std::vector<std::string> result;
+  std::size_t begin = s.find_first_not_of(separators);
+  while (begin != std::string_view::npos) {
+    const auto end = s.find_first_of(separators, begin);
+    result.emplace_back(s.substr(begin, end == std::string_view::npos ? std::string_view::npos : end - begin));
+    begin = s.find_first_not_of(separators, end);
+  }
+  return result;
+}
+
+void BM_SplitByHand(benchmark::State& state) {
+  const auto& csv = CsvInput();
+  bench::TAllocationCounter allocs{state};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(SplitByHand(csv, ",\n"));
+  }
+  state.SetBytesProcessed(state.iterations() * csv.size());
+}
+BENCHMARK(BM_SplitByHand);
+
+void BM_Split(benchmark::State& state) {
+  const auto& csv = CsvInput();
+  bench::TAllocationCounter allocs{state};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(utils::Split(csv, ",\n"));
+  }
+  state.SetBytesProcessed(state.iterations() * csv.size());
+}
+BENCHMARK(BM_Split);
+
+void BM_SplitView(benchmark::State& state) {
+  const auto& csv = CsvInput();
+  bench::TAllocationCounter allocs{state};
+  for (auto _ : state) {
+    std::size_t length = 0;
+    for (auto token : utils::SplitView(csv, ",\n")) {
+      length += token.size();
+    }
+    benchmark::DoNotOptimize(length);
+  }
+  state.SetBytesProcessed(state.iterations() * csv.size());
+}
+BENCHMARK(BM_SplitView);
+
+void BM_SplitLinesStringstream(benchmark::State& state) {
+  static const auto logs = bench::LogLines(2000);
+  bench::TAllocationCounter allocs{state};
+  for (auto _ : state) {
+    std::istringstream is{logs};
+    std::size_t length = 0;
+    for (std::string line; std::getline(is, line);) {
+      length += line.size();
+    }
+    benchmark::DoNotOptimize(length);
+  }
+  state.SetBytesProcessed(state.iterations() * logs.size());
+}
+BENCHMARK(BM_SplitLinesStringstream);
+
+void BM_SplitLines(benchmark::State& state) {
+  static const auto logs = bench::LogLines(2000);
+  bench::TAllocationCounter allocs{state};
+  for (auto _ : state) {
+    std::size_t length = 0;
+    for (auto line : utils::SplitLines(logs)) {
+      length += line.size();
+    }
+    benchmark::DoNotOptimize(length);
+  }
+  state.SetBytesProcessed(state.iterations() * logs.size());
+}
+BENCHMARK(BM_SplitLines);
+
+/*******************************************************************************
+*                                    Trim                                     *
+*******************************************************************************/
+
+std::vector<std::string> PaddedWords() {
+  auto words = bench::Words(1000, 24);
+  for (std::size_t i = 0; i < words.size(); i++) {
+    words[i] = std::string(i % 5, ' ') + words[i] + std::string(i % 3, '\t');
+  }
+  return words;
+}
+
+void BM_TrimByHand(benchmark::State& state) {
+  const auto words = PaddedWords();
+  bench::TAllocationCounter allocs{state};
+  for (auto _ : state) {
+    for (const auto& word : words) {
+      const auto begin = word.find_first_not_of(" \t\n\r\f\v");
+      const auto end = word.find_last_not_of(" \t\n\r\f\v");
+      benchmark::DoNotOptimize(begin == std::string::npos ? std::string{} : word.substr(begin, end - begin + 1));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * words.size());
+}
+BENCHMARK(BM_TrimByHand);
+
+void BM_Trim(benchmark::State& state) {
+  const auto words = PaddedWords();
+  bench::TAllocationCounter allocs{state};
+  for (auto _ : state) {
+    for (const auto& word : words) {
+      benchmark::DoNotOptimize(utils::Trim(word));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * words.size());
+}
+BENCHMARK(BM_Trim);
+
+/*******************************************************************************
+*                                    Join                                     *
+*******************************************************************************/
+
+void BM_JoinStringstream(benchmark::State& state) {
+  const auto words = bench::Words(1000);
+  bench::TAllocationCounter allocs{state};
+  for (auto _ : state) {
+    std::ostringstream os;
+    for (std::size_t i = 0; i < words.size(); i++) {
+      if (i != 0) {
+        os << ", ";
+      }
+      os << words[i];
+    }
+    benchmark::DoNotOptimize(os.str());
+  }
+  state.SetItemsProcessed(state.iterations() * words.size());
+}
+BENCHMARK(BM_JoinStringstream);
+
+void BM_JoinStrings(benchmark::State& state) {
+  const auto words = bench::Words(1000);
+  bench::TAllocationCounter allocs{state};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(utils::Join(words));
+  }
+  state.SetItemsProcessed(state.iterations() * words.size());
+}
+BENCHMARK(BM_JoinStrings);
+
+void BM_JoinInts(benchmark::State& state) {
+  const auto ints = bench::Ints(1000, 1000000);
+  bench::TAllocationCounter allocs{state};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(utils::Join(ints));
+  }
+  state.SetItemsProcessed(state.iterations() * ints.size());
+}
+BENCHMARK(BM_JoinInts);
+
+/*******************************************************************************
+*                                   Replace                                   *
+*******************************************************************************/
+
+const std::vector<std::pair<std::string_view, std::string_view>> REPLACEMENTS = {
+  {"status=", "s="},
+  {"latency_ms=", "t="},
+  {"backend-", "b"},
+  {"/api/v1/", "/"},
+  {"ERROR", "E"},
+  {"WARN", "W"},
+};
+
+/// One `find`/`replace` pass per pattern, as it is usually written. Unlike
+/// the single-pass replacement it can rescan replaced text, which doesn't
+/// matter for these patterns.
+std::string ReplaceByHand(std::string text) {
+  for (const auto& [from, to] : REPLACEMENTS) {
+    for (auto pos = text.find(from); pos != std::string::npos; pos = text.find(from, pos + to.size())) {
+      text.replace(pos, from.size(), to);
+    }
+  }
+  return text;
+}
+
+void BM_ReplaceByHand(benchmark::State& state) {
+  static const auto logs = bench::LogLines(1000);
+  bench::TAllocationCounter allocs{state};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(ReplaceByHand(logs));
+  }
+  state.SetBytesProcessed(state.iterations() * logs.size());
+}
+BENCHMARK(BM_ReplaceByHand);
+
+void BM_Replace(benchmark::State& state) {
+  static const auto logs = bench::LogLines(1000);
+  bench::TAllocationCounter allocs{state};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(utils::Replace(logs, REPLACEMENTS));
+  }
+  state.SetBytesProcessed(state.iterations() * logs.size());
+}
+BENCHMARK(BM_Replace);
+
+void BM_ReplacerReused(benchmark::State& state) {
+  static const auto logs = bench::LogLines(1000);
+  const utils::TReplacer replacer{REPLACEMENTS};
+  std::string out;
+  bench::TAllocationCounter allocs{state};
+  for (auto _ : state) {
+    out.clear();
+    replacer.ReplaceTo(logs, out);
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetBytesProcessed(state.iterations() * logs.size());
+}
+BENCHMARK(BM_ReplacerReused);
+
+/*******************************************************************************
+*                                   StrCat                                    *
+*******************************************************************************/
+
+void BM_ConcatOperatorPlus(benchmark::State& state) {
+  const std::string host = "backend-17";
+  i64 i = 0;
+  bench::TAllocationCounter allocs{state};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize("host=" + host + " code=" + std::to_string(200) + " id=" + std::to_string(i++));
+  }
+}
+BENCHMARK(BM_ConcatOperatorPlus);
+
+void BM_StrCat(benchmark::State& state) {
+  const std::string host = "backend-17";
+  i64 i = 0;
+  bench::TAllocationCounter allocs{state};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(utils::StrCat("host=", host, " code=", 200, " id=", i++));
+  }
+}
+BENCHMARK(BM_StrCat);
+
+}  // namespace
@@ -30,6 +30,14 @@ if (USE_GTEST)
         )
 endif()
 
+if (USE_BENCHMARK)
+    set(BENCHMARK_ENABLE_TESTING OFF)
+    AddUrlLib(
+        benchmark
+        https://github.com/google/benchmark/archive/refs/heads/main.zip
+        )
+endif()
+
 if(USE_FMT)
     AddUrlLib(
         fmt
@@ -20,7 +20,7 @@ then
     build_dir="./debug"
 elif [ "$1" = "release" ]
 then
-    additional_opts="$additional_opts -DCMAKE_BUILD_TYPE=Release"
+    additional_opts="$additional_opts -DCMAKE_BUILD_TYPE=Release -DCPPUTILS_ENABLE_BENCHMARKS=ON"
     build_dir="./release"
 else
     echo "Please pass the build type (debug or release)"
@@ -0,0 +1,270 @@
+#pragma once
+
+#include <cpputils/common.hh>
+#include <cpputils/hash.hh>
+#include <cpputils/itertools.hh>
+#include <cpputils/platform.hh>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace utils {
+
+/*******************************************************************************
+*                                 Group table                                 *
+*******************************************************************************/
+
+namespace detail {
+
+/// Spreads the bits of weak hashes (`std::hash` of integers is the identity)
+constexpr u64 MixHash(u64 h) {
+  h ^= h >> 32;
+  h *= 0x9E3779B97F4A7C15ull;
+  return h ^ (h >> 29);
+}
+
+/// `std::hash` where the standard library has one, `utils::THash` for the
+/// tuples and pairs that `Zip` produces and for the other keys
+template<class TKey, class = void>
+struct TGroupHash : THash {};
+
+template<class TKey>
+struct TGroupHash<TKey, std::enable_if_t<std::is_default_constructible_v<std::hash<TKey>>>> : std::hash<TKey> {};
+
+/// Insert-only open-addressing table behind the grouping terminals. Slots
+/// are 8 bytes (the high half of the hash and an entry index) probed
+/// linearly at a load factor of at most 1/4, which keeps the second probes
+/// (and their branch mispredictions) rare; the entries are kept densely in
+/// insertion order together with their hashes, so growing never rehashes a
+/// key.
+template<class TKey, class TValue, class THash = TGroupHash<TKey>, class TEqual = std::equal_to<>>
+class TGroupTable {
+public:
+  using TEntry = std::pair<TKey, TValue>;
+
+  explicit TGroupTable(std::size_t expectedKeys = 0) {
+    Entries.reserve(expectedKeys);
+    Hashes.reserve(expectedKeys);
+    Resize(SlotsFor(expectedKeys));
+  }
+
+  u64 Hash(const TKey& key) const {
+    return MixHash(static_cast<u64>(Hasher(key)));
+  }
+
+  /// Brings in the first slot that an insertion with `hash` probes
+  void Prefetch(u64 hash) const {
+    platform::Prefetch(&Slots[hash & Mask]);
+  }
+
+  /// The slots no longer fit in the L2 cache, so prefetching pays off
+  bool IsLarge() const {
+    return Slots.size() * sizeof(TSlot) > LARGE_TABLE_BYTES;
+  }
+
+  /// The value of `key`, created by `makeValue()` if the key is new
+  template<class K, class Fn>
+  TValue& FindOrInsert(K&& key, u64 hash, Fn&& makeValue) {
+    const auto tag = static_cast<u32>(hash >> 32);
+    for (auto i = hash & Mask;; i = (i + 1) & Mask) {
+      const auto slot = Slots[i];
+      if (slot.Index == EMPTY) {
+        return Insert(i, std::forward<K>(key), hash, std::forward<Fn>(makeValue));
+      }
+      if (slot.Tag == tag && Equal(Entries[slot.Index].first, key)) {
+        return Entries[slot.Index].second;
+      }
+    }
+  }
+
+  std::size_t Size() const {
+    return Entries.size();
+  }
+
+  /// The entries in the order of the first insertion of their keys
+  std::vector<TEntry> Release() && {
+    return std::move(Entries);
+  }
+
+private:
+  struct TSlot {
+    u32 Tag;
+    u32 Index;
+  };
+
+  static constexpr u32 EMPTY = std::numeric_limits<u32>::max();
+  static constexpr std::size_t MIN_SLOTS = 16;
+  static constexpr std::size_t MAX_LOAD_INVERSE = 4;
+  static constexpr std::size_t LARGE_TABLE_BYTES = 256 * 1024;
+
+  static std::size_t SlotsFor(std::size_t keys) {
+    std::size_t slots = MIN_SLOTS;
+    while (slots < keys * MAX_LOAD_INVERSE) {
+      slots *= 2;
+    }
+    return slots;
+  }
+
+  /// Inserts into the empty slot `i`, or into a new one after growing
+  template<class K, class Fn>
+  TValue& Insert(u64 i, K&& key, u64 hash, Fn&& makeValue) {
+    if ((Entries.size() + 1) * MAX_LOAD_INVERSE > Slots.size()) {
+      Resize(Slots.size() * 2);
+      for (i = hash & Mask; Slots[i].Index != EMPTY; i = (i + 1) & Mask) {
+      }
+    }
+    Slots[i] = TSlot{static_cast<u32>(hash >> 32), static_cast<u32>(Entries.size())};
+    Entries.emplace_back(std::forward<K>(key), makeValue());
+    Hashes.push_back(hash);
+    return Entries.back().second;
+  }
+
+  void Resize(std::size_t slots) {
+    Slots.assign(slots, TSlot{0, EMPTY});
+    Mask = slots - 1;
+    for (std::size_t index = 0; index < Hashes.size(); index++) {
+      auto i = Hashes[index] & Mask;
+      while (Slots[i].Index != EMPTY) {
+        i = (i + 1) & Mask;
+      }
+      Slots[i] = TSlot{static_cast<u32>(Hashes[index] >> 32), static_cast<u32>(index)};
+    }
+  }
+
+  std::vector<TSlot> Slots;
+  u64 Mask{0};
+  std::vector<TEntry> Entries;
+  std::vector<u64> Hashes;
+  THash Hasher;
+  TEqual Equal;
+};
+
+/// Once the table outgrows the cache, elements are hashed a batch at a time
+/// and the slots of the whole batch are prefetched before the first
+/// insertion, so that the cache misses overlap instead of stalling one
+/// insertion after another
+inline constexpr std::size_t GROUP_BATCH = 16;
+
+template<class TRange, class FnKey>
+using TGroupKeyT = std::decay_t<std::invoke_result_t<FnKey&, const typename TRangeTraits<TRange>::value_type&>>;
+
+/// Calls `apply(key, element, hash)` (or `apply(key, hash)` unless
+/// `WithElements`) in order for every element of `r`, with the batching
+/// described above. Elements are only copied while they wait in a batch.
+template<bool WithElements, class TRange, class TTable, class FnKey, class FnApply>
+void BatchedInsert(const TRange& r, TTable& table, FnKey&& keyFn, FnApply&& apply) {
+  using TKey = TGroupKeyT<TRange, FnKey>;
+  using TElement = typename TRangeTraits<TRange>::value_type;
+  using TPending = std::conditional_t<WithElements, std::pair<TKey, TElement>, TKey>;
+  std::vector<TPending> pending;
+  u64 hashes[GROUP_BATCH];
+  const auto flush = [&] {
+    for (std::size_t i = 0; i < pending.size(); i++) {
+      if constexpr (WithElements) {
+        apply(std::move(pending[i].first), std::move(pending[i].second), hashes[i]);
+      } else {
+        apply(std::move(pending[i]), hashes[i]);
+      }
+    }
+    pending.clear();
+  };
+  PushEach(r, [&](auto&& x) {
+    TKey key = keyFn(x);
+    const auto hash = table.Hash(key);
+    // the table only grows, so nothing is pending while it is small
+    if (!table.IsLarge()) {
+      if constexpr (WithElements) {
+        apply(std::move(key), std::forward<decltype(x)>(x), hash);
+      } else {
+        apply(std::move(key), hash);
+      }
+      return true;
+    }
+    table.Prefetch(hash);
+    hashes[pending.size()] = hash;
+    if constexpr (WithElements) {
+      pending.emplace_back(std::move(key), std::forward<decltype(x)>(x));
+    } else {
+      pending.push_back(std::move(key));
+    }
+    if (pending.size() == GROUP_BATCH) {
+      flush();
+    }
+    return true;
+  });
+  flush();
+}
+
+}  // namespace utils::detail
+
+/*******************************************************************************
+*                                  Grouping                                   *
+*******************************************************************************/
+
+/// Left fold of the elements of every group: `{key, op(...op(init, x1)..., xn)}`
+/// for the distinct `keyFn(x)`, in the order of their first appearance.
+/// `expectedKeys` pre-sizes the table.
+template<class TRange, class FnKey, class T, class Op>
+auto GroupBy(const TRange& r, FnKey keyFn, T init, Op op, std::size_t expectedKeys = 0) {
+  using TKey = detail::TGroupKeyT<TRange, FnKey>;
+  detail::TGroupTable<TKey, T> table{expectedKeys};
+  detail::BatchedInsert<true>(r, table, keyFn, [&](TKey&& key, auto&& x, u64 hash) {
+    auto& acc = table.FindOrInsert(std::move(key), hash, [&init] { return init; });
+    acc = op(std::move(acc), std::forward<decltype(x)>(x));
+  });
+  return std::move(table).Release();
+}
+
+/// The elements of every group, in the order of the first appearance of the
+/// keys and of the elements within a group
+template<class TRange, class FnKey>
+auto GroupBy(const TRange& r, FnKey keyFn, std::size_t expectedKeys = 0) {
+  using TElement = typename detail::TRangeTraits<TRange>::value_type;
+  return GroupBy(
+    r,
+    keyFn,
+    std::vector<TElement>{},
+    [](std::vector<TElement> group, TElement x) {
+      group.push_back(std::move(x));
+      return group;
+    },
+    expectedKeys
+  );
+}
+
+/// Number of elements for every distinct `keyFn(x)`, in the order of the
+/// first appearance of the keys
+template<class TRange, class FnKey>
+auto CountBy(const TRange& r, FnKey keyFn, std::size_t expectedKeys = 0) {
+  using TKey = detail::TGroupKeyT<TRange, FnKey>;
+  detail::TGroupTable<TKey, std::size_t> table{expectedKeys};
+  detail::BatchedInsert<false>(r, table, keyFn, [&table](TKey&& key, u64 hash) {
+    table.FindOrInsert(std::move(key), hash, [] { return std::size_t{0}; })++;
+  });
+  return std::move(table).Release();
+}
+
+/// The first occurrences of the distinct elements, in order
+template<class TRange>
+auto Distinct(const TRange& r, std::size_t expectedKeys = 0) {
+  using TElement = typename detail::TRangeTraits<TRange>::value_type;
+  detail::TGroupTable<TElement, bool> table{expectedKeys};
+  const auto identity = [](const TElement& x) -> const TElement& { return x; };
+  detail::BatchedInsert<false>(r, table, identity, [&table](TElement&& x, u64 hash) {
+    table.FindOrInsert(std::move(x), hash, [] { return true; });
+  });
+  auto entries = std::move(table).Release();
+  std::vector<TElement> result;
+  result.reserve(entries.size());
+  for (auto& entry : entries) {
+    result.push_back(std::move(entry.first));
+  }
+  return result;
+}
+
+}  // namespace utils
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cpputils/common.hh>
+#include <cpputils/flat_hash.hh>
+#include <cpputils/string.hh>
+
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace utils {
+
+/*******************************************************************************
+*                                TStringArena                                 *
+*******************************************************************************/
+
+/// Bump allocator for strings. Everything stored in it lives until `Reset`
+/// (or destruction), which releases all the strings at once and keeps the
+/// blocks for reuse. Views into the arena are never invalidated by further
+/// allocations.
+class TStringArena {
+public:
+  static constexpr std::size_t DEFAULT_BLOCK_SIZE = 16 * 1024;
+
+  explicit TStringArena(std::size_t blockSize = DEFAULT_BLOCK_SIZE);
+
+  TStringArena(const TStringArena&) = delete;
+  TStringArena& operator=(const TStringArena&) = delete;
+  TStringArena(TStringArena&&) = default;
+  TStringArena& operator=(TStringArena&&) = default;
+
+  /// Uninitialized storage for `size` chars
+  char* Allocate(std::size_t size);
+
+  /// Copies `s` into the arena
+  std::string_view Store(std::string_view s);
+
+  void Reset();
+
+  /// Bytes handed out since the last reset
+  std::size_t BytesUsed() const {
+    return Used;
+  }
+
+  /// Bytes owned by the arena, including the unused ones
+  std::size_t BytesReserved() const;
+
+private:
+  struct TBlock {
+    std::unique_ptr<char[]> Data;
+    std::size_t Size;
+  };
+
+  std::size_t BlockSize;
+  std::vector<TBlock> Blocks;
+  /// Oversized allocations, freed on reset
+  std::vector<TBlock> LargeBlocks;
+  std::size_t CurrentBlock{0};
+  char* Current{nullptr};
+  std::size_t Remaining{0};
+  std::size_t Used{0};
+  /// Temporary buffer for results whose size is only known in the end
+  std::string Scratch;
+
+  friend std::string_view Replace(TStringArena& arena, std::string_view text, const TReplacer& replacer);
+};
+
+/*******************************************************************************
+*                              TStringInterner                                *
+*******************************************************************************/
+
+/// Deduplicates strings: equal strings get the same id and the same view,
+/// both stay valid until `Clear`
+class TStringInterner {
+public:
+  using TId = u32;
+
+  TId Intern(std::string_view s);
+
+  std::string_view InternView(std::string_view s) {
+    return Get(Intern(s));
+  }
+
+  std::optional<TId> Find(std::string_view s) const;
+
+  std::string_view Get(TId id) const {
+    return Strings[id];
+  }
+
+  std::size_t Size() const {
+    return Strings.size();
+  }
+
+  void Clear();
+
+private:
+  TStringArena Arena;
+  std::vector<std::string_view> Strings;
+  TFlatHashMap<std::string_view, TId> Ids;
+};
+
+/*******************************************************************************
+*                          Arena-backed string utils                          *
+*******************************************************************************/
+
+inline std::string_view Trim(TStringArena& arena, std::string_view s, const TCharSet& trimmedChars = detail::WS) {
+  const auto begin = FindFirstNotOf(s, trimmedChars);
+  if (begin == std::string_view::npos) {
+    return {};
+  }
+  return arena.Store(s.substr(begin, FindLastNotOf(s, trimmedChars) + 1 - begin));
+}
+
+inline std::vector<std::string_view> Split(TStringArena& arena, std::string_view s, const TCharSet& sepChars = detail::WS) {
+  std::vector<std::string_view> result;
+  for (auto token : SplitView(s, sepChars)) {
+    result.push_back(arena.Store(token));
+  }
+  return result;
+}
+
+std::string_view Replace(TStringArena& arena, std::string_view text, const TReplacer& replacer);
+
+inline std::string_view Replace(TStringArena& arena, std::string_view text, const std::vector<std::pair<std::string_view, std::string_view>>& replacementPairs) {
+  return Replace(arena, text, TReplacer{replacementPairs});
+}
+
+/// `Join` for string-like elements, sized in advance and written straight into the arena
+template<typename Container>
+std::string_view Join(TStringArena& arena, const Container& cont, std::string_view sep = ", ") {
+  std::size_t size = 0;
+  std::size_t count = 0;
+  for (const auto& x : cont) {
+    size += std::string_view{x}.size();
+    count++;
+  }
+  if (count == 0) {
+    return {};
+  }
+  size += (count - 1) * sep.size();
+  char* data = arena.Allocate(size);
+  char* out = data;
+  bool first = true;
+  for (const auto& x : cont) {
+    if (!first) {
+      out = std::copy(sep.begin(), sep.end(), out);
+    }
+    first = false;
+    const std::string_view sv{x};
+    out = std::copy(sv.begin(), sv.end(), out);
+  }
+  return {data, size};
+}
+
+template<typename T>
+std::string_view Join(TStringArena& arena, std::initializer_list<T> l, std::string_view sep = ", ") {
+  return Join(arena, std::vector<std::string_view>(l.begin(), l.end()), sep);
+}
+
+}  // namespace utils
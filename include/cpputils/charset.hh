@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cpputils/common.hh>
+
+#include <array>
+#include <cstdint>
+#include <initializer_list>
+#include <string_view>
+#include <unordered_set>
+
+namespace utils {
+
+/*******************************************************************************
+*                                  TCharSet                                   *
+*******************************************************************************/
+
+/// 256-bit membership table for bytes that can be built at compile time:
+///   constexpr utils::TCharSet SEPARATORS{" ,;"};
+///
+/// The table is stored as two 16-entry nibble tables: for a byte with nibbles
+/// (hi, lo) the bit `hi % 8` of `(hi < 8 ? Low : High)[lo]` tells whether it is
+/// in the set. This is the layout the SIMD kernels look up with `pshufb`.
+struct TCharSet {
+  /// Sets with at most this many characters are scanned with plain byte
+  /// comparisons when no shuffle-capable kernel is available
+  static constexpr std::size_t SMALL_SIZE = 8;
+
+  constexpr TCharSet() = default;
+
+  constexpr TCharSet(char c) {
+    Insert(c);
+  }
+
+  constexpr TCharSet(const char* chars) : TCharSet(std::string_view{chars}) {}
+
+  constexpr TCharSet(std::string_view chars) {
+    for (auto c : chars) {
+      Insert(c);
+    }
+  }
+
+  constexpr TCharSet(std::initializer_list<char> chars) {
+    for (auto c : chars) {
+      Insert(c);
+    }
+  }
+
+  TCharSet(const std::unordered_set<char>& chars) {
+    for (auto c : chars) {
+      Insert(c);
+    }
+  }
+
+  constexpr TCharSet& Insert(char c) {
+    if (Contains(c)) {
+      return *this;
+    }
+    const auto byte = static_cast<unsigned char>(c);
+    auto& table = byte < 0x80 ? Low : High;
+    table[byte & 0x0F] |= static_cast<std::uint8_t>(1u << ((byte >> 4) & 0x07));
+    if (Size < SMALL_SIZE) {
+      Small[Size] = c;
+    }
+    Size++;
+    return *this;
+  }
+
+  constexpr bool Contains(char c) const {
+    const auto byte = static_cast<unsigned char>(c);
+    const auto& table = byte < 0x80 ? Low : High;
+    return (table[byte & 0x0F] >> ((byte >> 4) & 0x07)) & 1;
+  }
+
+  constexpr std::size_t GetSize() const {
+    return Size;
+  }
+
+  constexpr bool IsSmall() const {
+    return Size <= SMALL_SIZE;
+  }
+
+  /// Nibble tables for bytes below and above 0x80 (see the class comment)
+  std::array<std::uint8_t, 16> Low{};
+  std::array<std::uint8_t, 16> High{};
+  /// The first `SMALL_SIZE` inserted characters
+  std::array<char, SMALL_SIZE> Small{};
+  std::size_t Size{0};
+};
+
+/*******************************************************************************
+*                                  Scanning                                   *
+*******************************************************************************/
+
+namespace detail {
+
+enum class ECharSetKernel {
+  Scalar,
+  Sse2,  // byte comparisons, only for small sets
+  Avx2,  // nibble table lookups, 32 bytes per step
+};
+
+bool IsKernelSupported(ECharSetKernel kernel, const TCharSet& set);
+
+/// Index of the first byte of `data` for which `set.Contains(byte) == member`,
+/// or `size` if there is none
+std::size_t ScanCharSet(const char* data, std::size_t size, const TCharSet& set, bool member, ECharSetKernel kernel);
+
+/// Same as above with the best kernel supported by the CPU
+std::size_t ScanCharSet(const char* data, std::size_t size, const TCharSet& set, bool member);
+
+}  // namespace utils::detail
+
+/// `std::string_view::find_first_of` for a `TCharSet`
+inline std::size_t FindFirstOf(std::string_view s, const TCharSet& set, std::size_t pos = 0) {
+  if (pos >= s.size()) {
+    return std::string_view::npos;
+  }
+  const auto i = pos + detail::ScanCharSet(s.data() + pos, s.size() - pos, set, true);
+  return i == s.size() ? std::string_view::npos : i;
+}
+
+/// `std::string_view::find_first_not_of` for a `TCharSet`
+inline std::size_t FindFirstNotOf(std::string_view s, const TCharSet& set, std::size_t pos = 0) {
+  if (pos >= s.size()) {
+    return std::string_view::npos;
+  }
+  const auto i = pos + detail::ScanCharSet(s.data() + pos, s.size() - pos, set, false);
+  return i == s.size() ? std::string_view::npos : i;
+}
+
+/// `std::string_view::find_last_not_of` for a `TCharSet`. Scans byte by byte:
+/// it is meant for trimming where only a few trailing bytes are visited.
+inline std::size_t FindLastNotOf(std::string_view s, const TCharSet& set) {
+  for (auto i = s.size(); i > 0; i--) {
+    if (!set.Contains(s[i - 1])) {
+      return i - 1;
+    }
+  }
+  return std::string_view::npos;
+}
+
+}  // namespace utils
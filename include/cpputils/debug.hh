@@ -1,10 +1,11 @@
 #pragma once
 
 #include <cpputils/common.hh>
+#include <cpputils/string.hh>
 
-#include <exception>
+#include <stdexcept>
 
 #define EXPECT(cond, message) \
   if (!(cond)) { \
-    throw std::runtime_error(::utils::Format(__FILE__ ":% %", __LINE__, message)); \
+    throw std::runtime_error(::utils::Format(FMT(__FILE__ ":% %"), __LINE__, message)); \
   }
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cpputils/common.hh>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace utils {
+
+/*******************************************************************************
+*                                 Text kernels                                *
+*******************************************************************************/
+
+namespace detail {
+
+enum class ETextKernel {
+  Scalar,
+  Sse42,  // 16 bytes per step
+  Avx2,   // 32 bytes per step
+};
+
+/// Byte-level transforms over raw buffers. Case mapping only touches ASCII
+/// letters, bytes above 0x7F are passed through unchanged.
+struct TTextKernels {
+  bool (*IsAscii)(const char* data, std::size_t size);
+  /// Well-formed UTF-8: no overlong forms, surrogates or code points above
+  /// U+10FFFF, no truncated sequences
+  bool (*IsValidUtf8)(const char* data, std::size_t size);
+  /// Number of bytes that are not continuation bytes
+  std::size_t (*CountCodePoints)(const char* data, std::size_t size);
+  /// `in` and `out` are either the same buffer or don't overlap
+  void (*ToLower)(const char* in, char* out, std::size_t size);
+  void (*ToUpper)(const char* in, char* out, std::size_t size);
+  /// Index of the first position where the lowercased bytes differ, or `size`
+  std::size_t (*MismatchIgnoreCase)(const char* a, const char* b, std::size_t size);
+};
+
+bool IsKernelSupported(ETextKernel kernel);
+
+const TTextKernels& GetTextKernels(ETextKernel kernel);
+
+/// The best kernels supported by the CPU
+const TTextKernels& GetTextKernels();
+
+}  // namespace utils::detail
+
+/*******************************************************************************
+*                               Classification                                *
+*******************************************************************************/
+
+inline bool IsAscii(std::string_view s) {
+  return detail::GetTextKernels().IsAscii(s.data(), s.size());
+}
+
+inline bool IsValidUtf8(std::string_view s) {
+  return detail::GetTextKernels().IsValidUtf8(s.data(), s.size());
+}
+
+/// Number of code points in a valid UTF-8 string
+inline std::size_t CountCodePoints(std::string_view s) {
+  return detail::GetTextKernels().CountCodePoints(s.data(), s.size());
+}
+
+/*******************************************************************************
+*                                Case mapping                                 *
+*******************************************************************************/
+
+/// ASCII-only case mapping, multibyte UTF-8 sequences are left intact
+inline void ToLowerInPlace(std::string& s) {
+  detail::GetTextKernels().ToLower(s.data(), s.data(), s.size());
+}
+
+inline void ToUpperInPlace(std::string& s) {
+  detail::GetTextKernels().ToUpper(s.data(), s.data(), s.size());
+}
+
+inline std::string ToLower(std::string_view s) {
+  std::string result(s.size(), '\0');
+  detail::GetTextKernels().ToLower(s.data(), result.data(), s.size());
+  return result;
+}
+
+inline std::string ToUpper(std::string_view s) {
+  std::string result(s.size(), '\0');
+  detail::GetTextKernels().ToUpper(s.data(), result.data(), s.size());
+  return result;
+}
+
+/*******************************************************************************
+*                            Case-insensitive keys                            *
+*******************************************************************************/
+
+inline bool EqualsIgnoreCase(std::string_view a, std::string_view b) {
+  return a.size() == b.size() && detail::GetTextKernels().MismatchIgnoreCase(a.data(), b.data(), a.size()) == a.size();
+}
+
+/// Three-way comparison of the lowercased strings: negative, zero or positive
+int CompareIgnoreCase(std::string_view a, std::string_view b);
+
+/// Hash of the lowercased string, `EqualsIgnoreCase` strings hash equally
+u64 HashIgnoreCase(std::string_view s);
+
+/// Functors for case-insensitive unordered containers:
+///   std::unordered_map<std::string, int, THashIgnoreCase, TEqualIgnoreCase>
+struct THashIgnoreCase {
+  std::size_t operator()(std::string_view s) const {
+    return static_cast<std::size_t>(HashIgnoreCase(s));
+  }
+};
+
+struct TEqualIgnoreCase {
+  bool operator()(std::string_view a, std::string_view b) const {
+    return EqualsIgnoreCase(a, b);
+  }
+};
+
+}  // namespace utils
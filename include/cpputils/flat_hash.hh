@@ -0,0 +1,757 @@
+#pragma once
+
+#include <cpputils/common.hh>
+#include <cpputils/platform.hh>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#if CPPUTILS_X86 && defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace utils {
+
+/*******************************************************************************
+*                               Control bytes                                 *
+*******************************************************************************/
+
+namespace detail {
+
+/// Every slot has a control byte: `CONTROL_EMPTY` or the low 7 bits of the
+/// hash of its key. Lookups compare a whole group of control bytes with one
+/// instruction and only look at the slots whose bytes match.
+inline constexpr std::size_t CONTROL_GROUP = 16;
+inline constexpr std::uint8_t CONTROL_EMPTY = 0x80;
+
+struct TControlGroup {
+#if CPPUTILS_X86 && defined(__SSE2__)
+  explicit TControlGroup(const std::uint8_t* control)
+    : Bytes{_mm_loadu_si128(reinterpret_cast<const __m128i*>(control))} {}
+
+  /// Bit `i` is set if byte `i` equals `tag`
+  u32 Match(std::uint8_t tag) const {
+    return static_cast<u32>(_mm_movemask_epi8(_mm_cmpeq_epi8(Bytes, _mm_set1_epi8(static_cast<char>(tag)))));
+  }
+
+  u32 MatchEmpty() const {
+    // only the empty byte has the high bit set
+    return static_cast<u32>(_mm_movemask_epi8(Bytes));
+  }
+
+  __m128i Bytes;
+#else
+  explicit TControlGroup(const std::uint8_t* control) {
+    std::memcpy(Bytes, control, CONTROL_GROUP);
+  }
+
+  u32 Match(std::uint8_t tag) const {
+    u32 result = 0;
+    for (std::size_t i = 0; i < CONTROL_GROUP; i++) {
+      result |= static_cast<u32>(Bytes[i] == tag) << i;
+    }
+    return result;
+  }
+
+  u32 MatchEmpty() const {
+    return Match(CONTROL_EMPTY);
+  }
+
+  std::uint8_t Bytes[CONTROL_GROUP];
+#endif
+};
+
+inline unsigned LowestBit(u32 mask) {
+  return static_cast<unsigned>(__builtin_ctz(mask));
+}
+
+/// Spreads the bits of weak hashes (`std::hash` of integers is the identity)
+/// over the position and the control byte
+constexpr u64 MixFlatHash(u64 h) {
+  h ^= h >> 32;
+  h *= 0x9E3779B97F4A7C15ull;
+  return h ^ (h >> 29);
+}
+
+template<class T, class = void>
+inline constexpr bool IsTransparent = false;
+
+template<class T>
+inline constexpr bool IsTransparent<T, std::void_t<typename T::is_transparent>> = true;
+
+/// `std::hash`, except that strings are hashed as `std::string_view`, so
+/// that string maps can be searched with views without a copy
+template<class TKey>
+struct TFlatHash : std::hash<TKey> {};
+
+struct TStringFlatHash {
+  using is_transparent = void;
+
+  std::size_t operator()(std::string_view s) const {
+    return std::hash<std::string_view>{}(s);
+  }
+};
+
+template<>
+struct TFlatHash<std::string> : TStringFlatHash {};
+
+template<>
+struct TFlatHash<std::string_view> : TStringFlatHash {};
+
+/*******************************************************************************
+*                               TFlatHashTable                                *
+*******************************************************************************/
+
+/// Open addressing with linear probing at slot granularity, scanned a group
+/// of control bytes at a time. A key lies between its home slot and the next
+/// empty slot, which erasure preserves by shifting the following slots back
+/// instead of leaving tombstones. The first `CONTROL_GROUP - 1` control bytes
+/// are mirrored past the end, so that a group can be loaded at any slot.
+template<class TKey, class TValue, class TKeyOf, class THash, class TEqual>
+class TFlatHashTable {
+public:
+  static constexpr bool is_transparent = IsTransparent<THash> && IsTransparent<TEqual>;
+
+  /// Any key type if both the hash and the equality are transparent,
+  /// otherwise keys are converted to `TKey` first
+  template<class K>
+  using TEnableLookup = std::enable_if_t<is_transparent || std::is_convertible_v<const K&, TKey>, int>;
+
+  template<bool Const>
+  class TIterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = TValue;
+    using difference_type = std::ptrdiff_t;
+    using reference = std::conditional_t<Const, const TValue&, TValue&>;
+    using pointer = std::conditional_t<Const, const TValue*, TValue*>;
+
+    TIterator() = default;
+
+    /// Iterators convert to const iterators
+    template<bool OtherConst, std::enable_if_t<Const && !OtherConst, int> = 0>
+    TIterator(const TIterator<OtherConst>& other) : Table{other.Table}, Index{other.Index} {}
+
+    reference operator*() const {
+      return Table->Slots[Index];
+    }
+
+    pointer operator->() const {
+      return &Table->Slots[Index];
+    }
+
+    TIterator& operator++() {
+      Index = Table->NextFull(Index + 1);
+      return *this;
+    }
+
+    TIterator operator++(int) {
+      auto result = *this;
+      ++*this;
+      return result;
+    }
+
+    friend bool operator==(const TIterator& lhs, const TIterator& rhs) {
+      return lhs.Index == rhs.Index;
+    }
+    friend bool operator!=(const TIterator& lhs, const TIterator& rhs) {
+      return !(lhs == rhs);
+    }
+
+  private:
+    friend TFlatHashTable;
+    template<bool> friend class TIterator;
+
+    using TTable = std::conditional_t<Const, const TFlatHashTable, TFlatHashTable>;
+
+    TIterator(TTable* table, std::size_t index) : Table{table}, Index{index} {}
+
+    TTable* Table{nullptr};
+    std::size_t Index{0};
+  };
+
+  using iterator = TIterator<false>;
+  using const_iterator = TIterator<true>;
+
+  TFlatHashTable() = default;
+
+  TFlatHashTable(const TFlatHashTable& other) : Hasher{other.Hasher}, Equal{other.Equal} {
+    Reserve(other.Size);
+    for (auto it = other.Begin(); it != other.End(); ++it) {
+      InsertUnique(*it);
+    }
+  }
+
+  TFlatHashTable(TFlatHashTable&& other) noexcept {
+    Swap(other);
+  }
+
+  TFlatHashTable& operator=(TFlatHashTable other) noexcept {
+    Swap(other);
+    return *this;
+  }
+
+  ~TFlatHashTable() {
+    DestroyAll();
+    Deallocate(Control, Slots, Capacity);
+  }
+
+  void Swap(TFlatHashTable& other) noexcept {
+    std::swap(Control, other.Control);
+    std::swap(Slots, other.Slots);
+    std::swap(Capacity, other.Capacity);
+    std::swap(Size, other.Size);
+    std::swap(Hasher, other.Hasher);
+    std::swap(Equal, other.Equal);
+  }
+
+  iterator Begin() {
+    return iterator{this, NextFull(0)};
+  }
+
+  const_iterator Begin() const {
+    return const_iterator{this, NextFull(0)};
+  }
+
+  iterator End() {
+    return iterator{this, Capacity};
+  }
+
+  const_iterator End() const {
+    return const_iterator{this, Capacity};
+  }
+
+  std::size_t GetSize() const {
+    return Size;
+  }
+
+  std::size_t GetCapacity() const {
+    return Capacity;
+  }
+
+  /// Room for `count` elements without rehashing
+  void Reserve(std::size_t count) {
+    if (count > GrowthLimit(Capacity)) {
+      Rehash(CapacityFor(count));
+    }
+  }
+
+  void Clear() {
+    DestroyAll();
+    if (Capacity != 0) {
+      std::memset(Control, CONTROL_EMPTY, Capacity + CONTROL_GROUP - 1);
+    }
+    Size = 0;
+  }
+
+  /// Index of the slot with `key`, or `Capacity`
+  template<class K>
+  std::size_t Find(const K& key) const {
+    if (Capacity == 0) {
+      return 0;
+    }
+    const auto& lookup = LookupKey(key);
+    return FindIndex(lookup, Hash(lookup));
+  }
+
+  /// The slot of `key` and whether it was just created by
+  /// `construct(void* slot)`
+  template<class K, class Fn>
+  std::pair<std::size_t, bool> FindOrInsert(const K& key, Fn&& construct) {
+    const auto& lookup = LookupKey(key);
+    const auto hash = Hash(lookup);
+    if (Capacity != 0) {
+      if (const auto index = FindIndex(lookup, hash); index != Capacity) {
+        return {index, false};
+      }
+    }
+    if (Size + 1 > GrowthLimit(Capacity)) {
+      Rehash(Capacity == 0 ? MIN_CAPACITY : Capacity * 2);
+    }
+    const auto index = FindEmpty(hash);
+    construct(static_cast<void*>(Slots + index));
+    SetControl(index, Tag(hash));
+    Size++;
+    return {index, true};
+  }
+
+  template<class K>
+  std::size_t EraseKey(const K& key) {
+    const auto index = Find(key);
+    if (index == Capacity) {
+      return 0;
+    }
+    EraseAt(index);
+    return 1;
+  }
+
+  /// Destroys the element and shifts the rest of its cluster back
+  void EraseAt(std::size_t index) {
+    Slots[index].~TValue();
+    Size--;
+    auto hole = index;
+    for (auto i = (index + 1) & Mask(); Control[i] != CONTROL_EMPTY; i = (i + 1) & Mask()) {
+      const auto home = Home(Hash(TKeyOf{}(Slots[i])));
+      // the element may move to the hole if the hole is between its home
+      // and its slot
+      if (((i - home) & Mask()) >= ((i - hole) & Mask())) {
+        new (Slots + hole) TValue(std::move(Slots[i]));
+        Slots[i].~TValue();
+        SetControl(hole, Control[i]);
+        hole = i;
+      }
+    }
+    SetControl(hole, CONTROL_EMPTY);
+  }
+
+  iterator MakeIterator(std::size_t index) {
+    return iterator{this, index};
+  }
+
+  const_iterator MakeIterator(std::size_t index) const {
+    return const_iterator{this, index};
+  }
+
+  static std::size_t IndexOf(const_iterator it) {
+    return it.Index;
+  }
+
+private:
+  static constexpr std::size_t MIN_CAPACITY = CONTROL_GROUP;
+
+  /// Maximum load factor of 3/4: linear probing clusters grow quickly above it
+  static constexpr std::size_t GrowthLimit(std::size_t capacity) {
+    return capacity - capacity / 4;
+  }
+
+  static std::size_t CapacityFor(std::size_t count) {
+    std::size_t capacity = MIN_CAPACITY;
+    while (GrowthLimit(capacity) < count) {
+      capacity *= 2;
+    }
+    return capacity;
+  }
+
+  template<class K>
+  static decltype(auto) LookupKey(const K& key) {
+    if constexpr (is_transparent || std::is_same_v<K, TKey>) {
+      return (key);
+    } else {
+      return TKey(key);
+    }
+  }
+
+  template<class K>
+  u64 Hash(const K& key) const {
+    return MixFlatHash(static_cast<u64>(Hasher(key)));
+  }
+
+  static std::uint8_t Tag(u64 hash) {
+    return static_cast<std::uint8_t>(hash & 0x7F);
+  }
+
+  std::size_t Mask() const {
+    return Capacity - 1;
+  }
+
+  std::size_t Home(u64 hash) const {
+    return (hash >> 7) & Mask();
+  }
+
+  template<class K>
+  std::size_t FindIndex(const K& key, u64 hash) const {
+    const auto tag = Tag(hash);
+    for (auto pos = Home(hash);; pos = (pos + CONTROL_GROUP) & Mask()) {
+      const TControlGroup group{Control + pos};
+      for (auto match = group.Match(tag); match != 0; match &= match - 1) {
+        const auto index = (pos + LowestBit(match)) & Mask();
+        if (Equal(TKeyOf{}(Slots[index]), key)) {
+          return index;
+        }
+      }
+      if (group.MatchEmpty() != 0) {
+        return Capacity;
+      }
+    }
+  }
+
+  std::size_t FindEmpty(u64 hash) const {
+    for (auto pos = Home(hash);; pos = (pos + CONTROL_GROUP) & Mask()) {
+      if (const auto empty = TControlGroup{Control + pos}.MatchEmpty(); empty != 0) {
+        return (pos + LowestBit(empty)) & Mask();
+      }
+    }
+  }
+
+  void SetControl(std::size_t index, std::uint8_t value) {
+    Control[index] = value;
+    if (index < CONTROL_GROUP - 1) {
+      Control[Capacity + index] = value;
+    }
+  }
+
+  std::size_t NextFull(std::size_t index) const {
+    while (index < Capacity && Control[index] == CONTROL_EMPTY) {
+      index++;
+    }
+    return index;
+  }
+
+  template<class T>
+  void InsertUnique(T&& value) {
+    const auto hash = Hash(TKeyOf{}(value));
+    const auto index = FindEmpty(hash);
+    new (Slots + index) TValue(std::forward<T>(value));
+    SetControl(index, Tag(hash));
+    Size++;
+  }
+
+  void Rehash(std::size_t capacity) {
+    auto* oldControl = Control;
+    auto* oldSlots = Slots;
+    const auto oldCapacity = Capacity;
+    Control = new std::uint8_t[capacity + CONTROL_GROUP - 1];
+    std::memset(Control, CONTROL_EMPTY, capacity + CONTROL_GROUP - 1);
+    Slots = std::allocator<TValue>{}.allocate(capacity);
+    Capacity = capacity;
+    Size = 0;
+    for (std::size_t i = 0; i < oldCapacity; i++) {
+      if (oldControl[i] != CONTROL_EMPTY) {
+        InsertUnique(std::move(oldSlots[i]));
+        oldSlots[i].~TValue();
+      }
+    }
+    Deallocate(oldControl, oldSlots, oldCapacity);
+  }
+
+  void DestroyAll() {
+    if constexpr (!std::is_trivially_destructible_v<TValue>) {
+      for (std::size_t i = 0; i < Capacity; i++) {
+        if (Control[i] != CONTROL_EMPTY) {
+          Slots[i].~TValue();
+        }
+      }
+    }
+  }
+
+  static void Deallocate(std::uint8_t* control, TValue* slots, std::size_t capacity) {
+    if (capacity != 0) {
+      delete[] control;
+      std::allocator<TValue>{}.deallocate(slots, capacity);
+    }
+  }
+
+  std::uint8_t* Control{nullptr};
+  TValue* Slots{nullptr};
+  std::size_t Capacity{0};
+  std::size_t Size{0};
+  THash Hasher;
+  TEqual Equal;
+};
+
+struct TMapKeyOf {
+  template<class TPair>
+  const auto& operator()(const TPair& pair) const {
+    return pair.first;
+  }
+};
+
+struct TSetKeyOf {
+  template<class TKey>
+  const TKey& operator()(const TKey& key) const {
+    return key;
+  }
+};
+
+}  // namespace utils::detail
+
+/*******************************************************************************
+*                                TFlatHashMap                                 *
+*******************************************************************************/
+
+/// Open-addressing hash map with the interface of `std::unordered_map` minus
+/// the bucket API. Elements are stored inline, so unlike the std map any
+/// insertion or erasure invalidates iterators and references (but `reserve`
+/// guarantees that insertions up to the reserved size don't move anything).
+/// Elements are `std::pair<TKey, TValue>`; don't modify the keys in place.
+/// String keys can be looked up with `std::string_view`.
+template<
+  class TKey,
+  class TValue,
+  class THash = detail::TFlatHash<TKey>,
+  class TEqual = std::equal_to<>
+>
+class TFlatHashMap {
+  using TTable = detail::TFlatHashTable<TKey, std::pair<TKey, TValue>, detail::TMapKeyOf, THash, TEqual>;
+
+  template<class K>
+  using TEnableLookup = typename TTable::template TEnableLookup<K>;
+
+public:
+  using key_type = TKey;
+  using mapped_type = TValue;
+  using value_type = std::pair<TKey, TValue>;
+  using size_type = std::size_t;
+  using iterator = typename TTable::iterator;
+  using const_iterator = typename TTable::const_iterator;
+
+  TFlatHashMap() = default;
+
+  TFlatHashMap(std::initializer_list<value_type> values) {
+    reserve(values.size());
+    for (const auto& value : values) {
+      insert(value);
+    }
+  }
+
+  iterator begin() {
+    return Table.Begin();
+  }
+
+  const_iterator begin() const {
+    return Table.Begin();
+  }
+
+  iterator end() {
+    return Table.End();
+  }
+
+  const_iterator end() const {
+    return Table.End();
+  }
+
+  size_type size() const {
+    return Table.GetSize();
+  }
+
+  bool empty() const {
+    return size() == 0;
+  }
+
+  /// Number of slots, of which at most 3/4 are used
+  size_type capacity() const {
+    return Table.GetCapacity();
+  }
+
+  /// No rehashing and no reallocation until there are more than `count`
+  /// elements
+  void reserve(size_type count) {
+    Table.Reserve(count);
+  }
+
+  void clear() {
+    Table.Clear();
+  }
+
+  void swap(TFlatHashMap& other) noexcept {
+    Table.Swap(other.Table);
+  }
+
+  template<class K, TEnableLookup<K> = 0>
+  iterator find(const K& key) {
+    return Table.MakeIterator(Table.Find(key));
+  }
+
+  template<class K, TEnableLookup<K> = 0>
+  const_iterator find(const K& key) const {
+    return Table.MakeIterator(Table.Find(key));
+  }
+
+  template<class K, TEnableLookup<K> = 0>
+  bool contains(const K& key) const {
+    return find(key) != end();
+  }
+
+  template<class K, TEnableLookup<K> = 0>
+  size_type count(const K& key) const {
+    return contains(key) ? 1 : 0;
+  }
+
+  template<class K, TEnableLookup<K> = 0>
+  TValue& at(const K& key) {
+    const auto it = find(key);
+    if (it == end()) {
+      throw std::out_of_range("TFlatHashMap::at: no such key");
+    }
+    return it->second;
+  }
+
+  template<class K, TEnableLookup<K> = 0>
+  const TValue& at(const K& key) const {
+    const auto it = find(key);
+    if (it == end()) {
+      throw std::out_of_range("TFlatHashMap::at: no such key");
+    }
+    return it->second;
+  }
+
+  /// Constructs the value from `args` only if the key is absent. A key of
+  /// another type (`std::string_view` for `std::string`) is converted only
+  /// when it is inserted.
+  template<class K, class... TArgs, TEnableLookup<std::decay_t<K>> = 0>
+  std::pair<iterator, bool> try_emplace(K&& key, TArgs&&... args) {
+    const auto [index, inserted] = Table.FindOrInsert(key, [&](void* slot) {
+      new (slot) value_type(
+        std::piecewise_construct,
+        std::forward_as_tuple(std::forward<K>(key)),
+        std::forward_as_tuple(std::forward<TArgs>(args)...)
+      );
+    });
+    return {Table.MakeIterator(index), inserted};
+  }
+
+  std::pair<iterator, bool> insert(const value_type& value) {
+    return try_emplace(value.first, value.second);
+  }
+
+  std::pair<iterator, bool> insert(value_type&& value) {
+    return try_emplace(std::move(value.first), std::move(value.second));
+  }
+
+  template<class K, class V>
+  std::pair<iterator, bool> emplace(K&& key, V&& value) {
+    return try_emplace(TKey(std::forward<K>(key)), std::forward<V>(value));
+  }
+
+  template<class K, class V, TEnableLookup<std::decay_t<K>> = 0>
+  std::pair<iterator, bool> insert_or_assign(K&& key, V&& value) {
+    auto result = try_emplace(std::forward<K>(key), std::forward<V>(value));
+    if (!result.second) {
+      result.first->second = std::forward<V>(value);
+    }
+    return result;
+  }
+
+  template<class K, TEnableLookup<std::decay_t<K>> = 0>
+  TValue& operator[](K&& key) {
+    return try_emplace(std::forward<K>(key)).first->second;
+  }
+
+  template<class K, TEnableLookup<K> = 0>
+  size_type erase(const K& key) {
+    return Table.EraseKey(key);
+  }
+
+  /// Erasure moves elements, so unlike the std map this doesn't return the
+  /// next iterator
+  void erase(const_iterator it) {
+    Table.EraseAt(TTable::IndexOf(it));
+  }
+
+private:
+  TTable Table;
+};
+
+/*******************************************************************************
+*                                TFlatHashSet                                 *
+*******************************************************************************/
+
+/// The set counterpart of `TFlatHashMap`, with the same invalidation rules
+template<class TKey, class THash = detail::TFlatHash<TKey>, class TEqual = std::equal_to<>>
+class TFlatHashSet {
+  using TTable = detail::TFlatHashTable<TKey, TKey, detail::TSetKeyOf, THash, TEqual>;
+
+  template<class K>
+  using TEnableLookup = typename TTable::template TEnableLookup<K>;
+
+public:
+  using key_type = TKey;
+  using value_type = TKey;
+  using size_type = std::size_t;
+  using iterator = typename TTable::const_iterator;
+  using const_iterator = typename TTable::const_iterator;
+
+  TFlatHashSet() = default;
+
+  TFlatHashSet(std::initializer_list<TKey> keys) {
+    reserve(keys.size());
+    for (const auto& key : keys) {
+      insert(key);
+    }
+  }
+
+  const_iterator begin() const {
+    return Table.Begin();
+  }
+
+  const_iterator end() const {
+    return Table.End();
+  }
+
+  size_type size() const {
+    return Table.GetSize();
+  }
+
+  bool empty() const {
+    return size() == 0;
+  }
+
+  size_type capacity() const {
+    return Table.GetCapacity();
+  }
+
+  void reserve(size_type count) {
+    Table.Reserve(count);
+  }
+
+  void clear() {
+    Table.Clear();
+  }
+
+  void swap(TFlatHashSet& other) noexcept {
+    Table.Swap(other.Table);
+  }
+
+  template<class K, TEnableLookup<K> = 0>
+  const_iterator find(const K& key) const {
+    return Table.MakeIterator(Table.Find(key));
+  }
+
+  template<class K, TEnableLookup<K> = 0>
+  bool contains(const K& key) const {
+    return find(key) != end();
+  }
+
+  template<class K, TEnableLookup<K> = 0>
+  size_type count(const K& key) const {
+    return contains(key) ? 1 : 0;
+  }
+
+  /// A key of another type is converted only when it is inserted
+  template<class K, TEnableLookup<std::decay_t<K>> = 0>
+  std::pair<const_iterator, bool> insert(K&& key) {
+    const auto [index, inserted] = Table.FindOrInsert(key, [&](void* slot) {
+      new (slot) TKey(std::forward<K>(key));
+    });
+    return {Table.MakeIterator(index), inserted};
+  }
+
+  template<class... TArgs>
+  std::pair<const_iterator, bool> emplace(TArgs&&... args) {
+    return insert(TKey(std::forward<TArgs>(args)...));
+  }
+
+  template<class K, TEnableLookup<K> = 0>
+  size_type erase(const K& key) {
+    return Table.EraseKey(key);
+  }
+
+  void erase(const_iterator it) {
+    Table.EraseAt(TTable::IndexOf(it));
+  }
+
+private:
+  TTable Table;
+};
+
+}  // namespace utils
@@ -0,0 +1,219 @@
+#pragma once
+
+#include <cpputils/itertools.hh>
+
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#define CPPUTILS_HAS_COROUTINES 1
+#else
+#define CPPUTILS_HAS_COROUTINES 0
+#endif
+
+namespace utils {
+
+/*******************************************************************************
+*                                 Frame pool                                  *
+*******************************************************************************/
+
+namespace detail {
+
+/// Coroutine frames come from thread-local free lists of 64-byte size
+/// classes, so a generator that is created and destroyed in a loop reuses
+/// the same frame. Frames larger than `MAX_POOLED_FRAME` go straight to
+/// `operator new`. A frame may be freed on another thread than the one that
+/// allocated it.
+inline constexpr std::size_t FRAME_SIZE_CLASS = 64;
+inline constexpr std::size_t MAX_POOLED_FRAME = 4096;
+
+void* AllocateFrame(std::size_t size);
+void DeallocateFrame(void* frame, std::size_t size) noexcept;
+
+}  // namespace utils::detail
+
+#if CPPUTILS_HAS_COROUTINES
+
+/*******************************************************************************
+*                                  Generator                                  *
+*******************************************************************************/
+
+/// Lazy single-pass range produced by a coroutine:
+///
+///   utils::Generator<int> Iota(int n) {
+///     for (int i = 0; i < n; i++) {
+///       co_yield i;
+///     }
+///   }
+///
+/// Like a container (and unlike a view) it owns its state, so adaptors refer
+/// to it and it must outlive them: `Map(Iota(3), f)` dangles. It can be
+/// iterated only once, `begin()` runs the coroutine up to the first
+/// `co_yield`. Exceptions thrown by the coroutine are rethrown from
+/// `begin()` and `++`.
+template<class T>
+class Generator {
+public:
+  using value_type = std::remove_cv_t<std::remove_reference_t<T>>;
+  using reference = std::conditional_t<std::is_reference_v<T>, T, const value_type&>;
+
+  struct promise_type {
+    Generator get_return_object() {
+      return Generator{std::coroutine_handle<promise_type>::from_promise(*this)};
+    }
+
+    std::suspend_always initial_suspend() noexcept {
+      return {};
+    }
+
+    std::suspend_always final_suspend() noexcept {
+      return {};
+    }
+
+    /// The yielded object outlives the suspension, since it is destroyed at
+    /// the end of the `co_yield` full-expression
+    std::suspend_always yield_value(std::remove_reference_t<reference>& value) noexcept {
+      Value = std::addressof(value);
+      return {};
+    }
+
+    std::suspend_always yield_value(std::remove_reference_t<reference>&& value) noexcept {
+      Value = std::addressof(value);
+      return {};
+    }
+
+    void return_void() noexcept {}
+
+    void unhandled_exception() {
+      Exception = std::current_exception();
+    }
+
+    /// Generators never await anything but their own suspensions
+    template<class U>
+    std::suspend_never await_transform(U&&) = delete;
+
+    static void* operator new(std::size_t size) {
+      return detail::AllocateFrame(size);
+    }
+
+    static void operator delete(void* frame, std::size_t size) noexcept {
+      detail::DeallocateFrame(frame, size);
+    }
+
+    std::add_pointer_t<reference> Value{nullptr};
+    std::exception_ptr Exception;
+    bool Started{false};
+  };
+
+  using THandle = std::coroutine_handle<promise_type>;
+
+  struct TIterator {
+    using iterator_category = std::input_iterator_tag;
+    using value_type = typename Generator::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::add_pointer_t<typename Generator::reference>;
+    using reference = typename Generator::reference;
+
+    TIterator() = default;
+
+    explicit TIterator(THandle handle) : Handle{handle} {}
+
+    TIterator& operator++() {
+      Resume(Handle);
+      return *this;
+    }
+
+    void operator++(int) {
+      ++*this;
+    }
+
+    reference operator*() const {
+      return static_cast<reference>(*Handle.promise().Value);
+    }
+
+    pointer operator->() const {
+      return Handle.promise().Value;
+    }
+
+    friend bool operator==(const TIterator &lhs, const TIterator &rhs) {
+      return lhs.Handle == rhs.Handle;
+    }
+    friend bool operator==(const TIterator &lhs, const detail::TSentinel&) {
+      return lhs.Handle.done();
+    }
+    friend bool operator==(const detail::TSentinel&, const TIterator &rhs) {
+      return rhs.Handle.done();
+    }
+    friend bool operator!=(const TIterator &lhs, const TIterator &rhs) {
+      return !(lhs == rhs);
+    }
+    friend bool operator!=(const TIterator &lhs, const detail::TSentinel &rhs) {
+      return !(lhs == rhs);
+    }
+    friend bool operator!=(const detail::TSentinel &lhs, const TIterator &rhs) {
+      return !(lhs == rhs);
+    }
+  private:
+    THandle Handle{};
+  };
+
+  using iterator = TIterator;
+
+  Generator(Generator&& other) noexcept : Handle{std::exchange(other.Handle, {})} {}
+
+  Generator& operator=(Generator&& other) noexcept {
+    if (this != &other) {
+      Destroy();
+      Handle = std::exchange(other.Handle, {});
+    }
+    return *this;
+  }
+
+  Generator(const Generator&) = delete;
+  Generator& operator=(const Generator&) = delete;
+
+  ~Generator() {
+    Destroy();
+  }
+
+  /// `const` so that `MakeView` and the adaptors accept generators, even
+  /// though it resumes the coroutine on the first call
+  TIterator begin() const {
+    if (!Handle.promise().Started) {
+      Handle.promise().Started = true;
+      Resume(Handle);
+    }
+    return TIterator{Handle};
+  }
+
+  detail::TSentinel end() const {
+    return detail::Sentinel;
+  }
+
+private:
+  explicit Generator(THandle handle) : Handle{handle} {}
+
+  static void Resume(THandle handle) {
+    handle.resume();
+    if (auto& exception = handle.promise().Exception) {
+      std::rethrow_exception(std::exchange(exception, {}));
+    }
+  }
+
+  void Destroy() {
+    if (Handle) {
+      Handle.destroy();
+    }
+  }
+
+  THandle Handle;
+};
+
+#endif  // CPPUTILS_HAS_COROUTINES
+
+}  // namespace utils
@@ -0,0 +1,229 @@
+#pragma once
+
+#include <cpputils/common.hh>
+#include <cpputils/itertools.hh>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace utils {
+
+/*******************************************************************************
+*                                 Byte hash                                   *
+*******************************************************************************/
+
+namespace detail {
+
+enum class EHashKernel {
+  Scalar,
+  Avx2,  // 64 bytes per step in two registers
+};
+
+/// Hashes of inputs longer than `HASH_SHORT_INPUT` bytes. All kernels
+/// return the same values, so hashes don't depend on the CPU.
+struct THashKernels {
+  u64 (*HashLong)(const char* data, std::size_t size, u64 seed);
+};
+
+bool IsKernelSupported(EHashKernel kernel);
+
+const THashKernels& GetHashKernels(EHashKernel kernel);
+
+/// The best kernels supported by the CPU
+const THashKernels& GetHashKernels();
+
+inline constexpr std::size_t HASH_SHORT_INPUT = 16;
+
+inline constexpr u64 HASH_PRIME0 = 0xA0761D6478BD642Full;
+inline constexpr u64 HASH_PRIME1 = 0xE7037ED1A0B428DBull;
+
+__extension__ typedef unsigned __int128 TUint128;
+
+/// Folded 128-bit product, the mixing step of wyhash
+inline u64 MulFold(u64 a, u64 b) {
+  const auto product = static_cast<TUint128>(a) * b;
+  return static_cast<u64>(product) ^ static_cast<u64>(product >> 64);
+}
+
+inline u64 HashCombine(u64 hash, u64 value) {
+  return MulFold(hash ^ HASH_PRIME0, value ^ HASH_PRIME1);
+}
+
+inline u64 Read32(const char* p) {
+  u32 result;
+  std::memcpy(&result, p, sizeof(result));
+  return result;
+}
+
+}  // namespace utils::detail
+
+/// Non-cryptographic 64-bit hash of a byte string: wyhash for short inputs,
+/// SIMD-friendly parallel lanes in the style of XXH3 for long ones.
+/// Not stable across versions of the library, don't persist it.
+inline u64 HashBytes(const void* data, std::size_t size, u64 seed = 0) {
+  const auto* p = static_cast<const char*>(data);
+  if (size > detail::HASH_SHORT_INPUT) {
+    return detail::GetHashKernels().HashLong(p, size, seed);
+  }
+  u64 a = 0;
+  u64 b = 0;
+  if (size >= 4) {
+    // two possibly overlapping words from each end
+    const auto middle = (size >> 3) << 2;
+    a = (detail::Read32(p) << 32) | detail::Read32(p + middle);
+    b = (detail::Read32(p + size - 4) << 32) | detail::Read32(p + size - 4 - middle);
+  } else if (size > 0) {
+    const auto byte = [p](std::size_t i) { return static_cast<u64>(static_cast<unsigned char>(p[i])); };
+    a = (byte(0) << 16) | (byte(size >> 1) << 8) | byte(size - 1);
+  }
+  seed ^= detail::MulFold(seed ^ detail::HASH_PRIME0, detail::HASH_PRIME1);
+  return detail::MulFold(
+    detail::MulFold(a ^ detail::HASH_PRIME1, b ^ seed) ^ detail::HASH_PRIME0 ^ size,
+    detail::HASH_PRIME1
+  );
+}
+
+inline u64 HashBytes(std::string_view s, u64 seed = 0) {
+  return HashBytes(s.data(), s.size(), seed);
+}
+
+/*******************************************************************************
+*                                Value hash                                   *
+*******************************************************************************/
+
+namespace detail {
+
+/// Values whose bytes are the value: integers, enums, pointers and structs
+/// of them without padding
+template<class T>
+inline constexpr bool IsHashedAsBytes = std::is_trivially_copyable_v<T> && std::has_unique_object_representations_v<T>;
+
+template<class T, class = void>
+inline constexpr bool HasTie = false;
+
+template<class T>
+inline constexpr bool HasTie<T, std::void_t<decltype(std::declval<const T&>().Tie())>> = true;
+
+template<class T, class = void>
+inline constexpr bool IsHashedRange = false;
+
+template<class T>
+inline constexpr bool IsHashedRange<T, std::void_t<decltype(std::begin(std::declval<const T&>()))>> = true;
+
+template<class T, class = void>
+inline constexpr bool IsTupleLike = false;
+
+template<class T>
+inline constexpr bool IsTupleLike<T, std::void_t<decltype(std::tuple_size<T>::value)>> = true;
+
+template<class T>
+u64 HashValue(const T& value, u64 seed);
+
+template<class TTuple, std::size_t... Is>
+u64 HashTuple(const TTuple& tuple, u64 seed, std::index_sequence<Is...>) {
+  u64 hash = seed ^ sizeof...(Is);
+  ((hash = HashCombine(hash, HashValue(std::get<Is>(tuple), seed))), ...);
+  return hash;
+}
+
+/// Elements of non-contiguous ranges are staged here, so that a list or a
+/// view hashes like a vector with the same elements
+inline constexpr std::size_t HASH_STAGE_BYTES = 512;
+
+template<class TRange>
+u64 HashRange(const TRange& r, u64 seed) {
+  using TValue = typename TRangeTraits<TRange>::value_type;
+  if constexpr (IsContiguous<TRange> && IsHashedAsBytes<TValue>) {
+    return HashBytes(std::data(r), std::size(r) * sizeof(TValue), seed);
+  } else if constexpr (IsHashedAsBytes<TValue> && std::is_default_constructible_v<TValue>) {
+    constexpr auto STAGE_SIZE = std::max<std::size_t>(HASH_STAGE_BYTES / sizeof(TValue), 1);
+    std::array<TValue, STAGE_SIZE> stage;
+    std::vector<TValue> overflow;
+    std::size_t count = 0;
+    for (auto&& x : r) {
+      if (count < STAGE_SIZE) {
+        stage[count++] = x;
+      } else {
+        if (overflow.empty()) {
+          overflow.assign(stage.begin(), stage.end());
+        }
+        overflow.push_back(x);
+      }
+    }
+    return overflow.empty()
+      ? HashBytes(stage.data(), count * sizeof(TValue), seed)
+      : HashBytes(overflow.data(), overflow.size() * sizeof(TValue), seed);
+  } else {
+    u64 hash = seed;
+    std::size_t count = 0;
+    for (auto&& x : r) {
+      hash = HashCombine(hash, HashValue(x, seed));
+      count++;
+    }
+    return HashCombine(hash, count);
+  }
+}
+
+template<class T>
+u64 HashValue(const T& value, u64 seed) {
+  // views are trivially copyable too, so ranges go before the bytes
+  if constexpr (std::is_array_v<T> && std::is_same_v<std::remove_cv_t<std::remove_extent_t<T>>, char>) {
+    // All `N` chars: a fixed-size field need not be terminated. Only the
+    // terminating zero of a literal is dropped, so it hashes like a string.
+    constexpr auto N = std::extent_v<T>;
+    return HashBytes(std::string_view{value, value[N - 1] == '\0' ? N - 1 : N}, seed);
+  } else if constexpr (!std::is_array_v<T> && std::is_convertible_v<const T&, std::string_view>) {
+    return HashBytes(std::string_view{value}, seed);
+  } else if constexpr (IsHashedRange<T>) {
+    return HashRange(value, seed);
+  } else if constexpr (IsHashedAsBytes<T>) {
+    return HashBytes(&value, sizeof(T), seed);
+  } else if constexpr (std::is_floating_point_v<T> && sizeof(T) <= sizeof(u64)) {
+    // 0.0 == -0.0
+    const T normalized = value == 0 ? T{0} : value;
+    return HashBytes(&normalized, sizeof(T), seed);
+  } else if constexpr (HasTie<T>) {
+    return HashValue(value.Tie(), seed);
+  } else if constexpr (IsTupleLike<T>) {
+    return HashTuple(value, seed, std::make_index_sequence<std::tuple_size_v<T>>{});
+  } else {
+    return HashCombine(seed, std::hash<T>{}(value));
+  }
+}
+
+}  // namespace utils::detail
+
+/// Hash of any value built from integers, floats, strings, ranges (including
+/// itertools views), pairs, tuples and `REFLECT` structs, falling back to
+/// `std::hash` for everything else:
+///   - strings, `std::string_view` and C strings are hashed as their chars;
+///   - values without padding (integers, packed structs of them) are hashed
+///     as their bytes;
+///   - a range is hashed as the sequence of its elements, whatever the
+///     container, so a vector, a list and a `Map` view of the same numbers
+///     hash equally;
+///   - `REFLECT` structs are hashed field by field unless they have no
+///     padding.
+template<class T>
+u64 Hash(const T& value, u64 seed = 0) {
+  return detail::HashValue(value, seed);
+}
+
+/// `Hash` as the hasher of standard containers:
+///   std::unordered_set<std::pair<int, std::string>, utils::THash>
+struct THash {
+  template<class T>
+  std::size_t operator()(const T& value) const {
+    return static_cast<std::size_t>(Hash(value));
+  }
+};
+
+}  // namespace utils
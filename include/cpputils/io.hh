@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cpputils/common.hh>
+#include <cpputils/string.hh>
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace utils {
+
+/*******************************************************************************
+*                                  ReadFile                                   *
+*******************************************************************************/
+
+/// Read-only contents of a file. Regular files are memory-mapped, anything
+/// that can't be mapped (pipes, character devices, procfs files) is read in
+/// large blocks instead.
+class TFileContents {
+public:
+  TFileContents() = default;
+  ~TFileContents();
+
+  TFileContents(const TFileContents&) = delete;
+  TFileContents& operator=(const TFileContents&) = delete;
+  TFileContents(TFileContents&& other) noexcept;
+  TFileContents& operator=(TFileContents&& other) noexcept;
+
+  std::string_view View() const {
+    return {Data, Size};
+  }
+
+  operator std::string_view() const {
+    return View();
+  }
+
+  const char* data() const {
+    return Data;
+  }
+
+  std::size_t size() const {
+    return Size;
+  }
+
+  const char* begin() const {
+    return Data;
+  }
+
+  const char* end() const {
+    return Data + Size;
+  }
+
+  bool IsMapped() const {
+    return Mapped;
+  }
+
+private:
+  friend TFileContents ReadFile(const std::string& path);
+
+  const char* Data{nullptr};
+  std::size_t Size{0};
+  bool Mapped{false};
+  std::string Buffer;
+};
+
+/// Throws `std::runtime_error` if the file can't be read
+TFileContents ReadFile(const std::string& path);
+
+/*******************************************************************************
+*                                  ReadLines                                  *
+*******************************************************************************/
+
+namespace detail {
+
+/// `SplitLines` over a file it keeps alive, copies share the contents
+struct TFileLinesView : TSplitView {
+  explicit TFileLinesView(std::shared_ptr<const TFileContents> file)
+    : TSplitView{file->View(), '\n', true}, File{std::move(file)} {}
+
+private:
+  std::shared_ptr<const TFileContents> File;
+};
+
+}  // namespace utils::detail
+
+/// Lazy range of the lines of a file as `std::string_view`s pointing into
+/// the mapping. It is an itertools view, so it can be fed to `Map`/`Filter`
+/// directly.
+inline detail::TFileLinesView ReadLines(const std::string& path) {
+  return detail::TFileLinesView{std::make_shared<const TFileContents>(ReadFile(path))};
+}
+
+/*******************************************************************************
+*                                  WriteFile                                  *
+*******************************************************************************/
+
+enum class EWriteMode {
+  Truncate,
+  Append,
+  /// Writes to a temporary file next to the target and renames it over the
+  /// target on `Close`, so readers see either the old or the new contents.
+  /// The mode of an existing target is kept.
+  Atomic,
+};
+
+/// Buffered file writer. Small writes are collected in a buffer and written
+/// with a single syscall, large ones bypass it. Errors are reported with
+/// `std::runtime_error`.
+class TFileWriter {
+public:
+  static constexpr std::size_t DEFAULT_BUFFER_SIZE = 64 * 1024;
+
+  explicit TFileWriter(const std::string& path, EWriteMode mode = EWriteMode::Truncate, std::size_t bufferSize = DEFAULT_BUFFER_SIZE);
+
+  /// An atomic writer that wasn't closed leaves the target untouched
+  ~TFileWriter();
+
+  TFileWriter(const TFileWriter&) = delete;
+  TFileWriter& operator=(const TFileWriter&) = delete;
+
+  void Write(std::string_view data);
+
+  template<class T>
+  TFileWriter& operator<<(const T& x) {
+    AppendValue(*this, x);
+    return *this;
+  }
+
+  /// Buffer requirements of `AppendValue`/`FormatTo`
+  void append(const char* s, std::size_t count) {
+    Write({s, count});
+  }
+
+  void push_back(char c) {
+    if (Buffer.size() >= BufferSize) {
+      Flush();
+    }
+    Buffer.push_back(c);
+  }
+
+  void Flush();
+
+  /// Flushes, syncs and closes the file. In atomic mode this is the point
+  /// where the target is replaced.
+  void Close();
+
+private:
+  std::string Path;
+  std::string TemporaryPath;
+  EWriteMode Mode;
+  std::size_t BufferSize;
+  std::string Buffer;
+  int Fd{-1};
+};
+
+void WriteFile(const std::string& path, std::string_view data, EWriteMode mode = EWriteMode::Truncate);
+
+}  // namespace utils
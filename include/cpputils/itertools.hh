@@ -4,9 +4,15 @@
 
 #include <cpputils/meta.hh>
 
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <string>
 #include <type_traits>
 #include <tuple>
 #include <iterator>
+#include <optional>
 #include <vector>
 #include <utility>
 
@@ -17,16 +23,146 @@ namespace detail {
 /// Marker for lightweight, non-owning ranges, that must only be stored as values
 struct TViewTag {};
 
-template<typename TRange>
+/*******************************************************************************
+*                              Iterator traits                                *
+*******************************************************************************/
+
+/// `iterator_category` of `TIt`, iterators without traits are treated as
+/// input iterators
+template<class TIt, class = void>
+struct TIteratorCategory {
+  using type = std::input_iterator_tag;
+};
+
+template<class TIt>
+struct TIteratorCategory<TIt, std::void_t<typename std::iterator_traits<TIt>::iterator_category>> {
+  using type = typename std::iterator_traits<TIt>::iterator_category;
+};
+
+template<class TIt>
+using TIteratorCategoryT = typename TIteratorCategory<TIt>::type;
+
+template<class TIt, class = void>
+struct TIteratorDifference {
+  using type = std::ptrdiff_t;
+};
+
+template<class TIt>
+struct TIteratorDifference<TIt, std::void_t<typename std::iterator_traits<TIt>::difference_type>> {
+  using type = typename std::iterator_traits<TIt>::difference_type;
+};
+
+template<class TIt>
+using TIteratorDifferenceT = typename TIteratorDifference<TIt>::type;
+
+/// `value_type` of `TIt`, or the decayed type of `*it` for iterators without
+/// traits. Zip iterators dereference to tuples of references, so the two
+/// differ.
+template<class TIt, class = void>
+struct TIteratorValue {
+  using type = std::decay_t<decltype(*std::declval<TIt>())>;
+};
+
+template<class TIt>
+struct TIteratorValue<TIt, std::void_t<typename std::iterator_traits<TIt>::value_type>> {
+  using type = typename std::iterator_traits<TIt>::value_type;
+};
+
+template<class TIt>
+using TIteratorValueT = typename TIteratorValue<TIt>::type;
+
+template<class TIt, class TCategory>
+inline constexpr bool IsIteratorOf = std::is_base_of_v<TCategory, TIteratorCategoryT<TIt>>;
+
+/// The strongest standard category that all of `TIts` satisfy. Views compute
+/// their elements, so they are at most random access.
+template<class... TIts>
+using TCommonIteratorCategory =
+  std::conditional_t<(IsIteratorOf<TIts, std::random_access_iterator_tag> && ...), std::random_access_iterator_tag,
+  std::conditional_t<(IsIteratorOf<TIts, std::bidirectional_iterator_tag> && ...), std::bidirectional_iterator_tag,
+  std::conditional_t<(IsIteratorOf<TIts, std::forward_iterator_tag> && ...), std::forward_iterator_tag,
+  std::input_iterator_tag>>>;
+
+template<class TRange, class = void>
+inline constexpr bool HasSizeMember = false;
+
+template<class TRange>
+inline constexpr bool HasSizeMember<TRange, std::void_t<decltype(std::declval<const TRange&>().size())>> = true;
+
+template<class TRange>
 struct TRangeTraits {
   using iterator = std::decay_t<decltype(std::begin(std::declval<TRange>()))>;
-  using value_type = std::decay_t<decltype(*std::declval<iterator>())>;
+  using value_type = TIteratorValueT<iterator>;
+  using iterator_category = TIteratorCategoryT<iterator>;
+  using difference_type = TIteratorDifferenceT<iterator>;
 
   using TEnd = std::decay_t<decltype(std::end(std::declval<TRange>()))>;
 
   static constexpr bool is_view = std::is_base_of_v<TViewTag, std::decay_t<TRange>>;
+  /// `end()` is an iterator rather than a sentinel, as STL algorithms require
+  static constexpr bool is_common = std::is_same_v<iterator, TEnd>;
+  static constexpr bool is_random_access = is_common && IsIteratorOf<iterator, std::random_access_iterator_tag>;
+  /// The number of elements is known without iterating
+  static constexpr bool is_sized = HasSizeMember<std::decay_t<TRange>> || is_random_access;
+};
+
+template<class TRange>
+constexpr std::size_t RangeSize(const TRange& r) {
+  static_assert(TRangeTraits<TRange>::is_sized, "The size of the range is unknown");
+  if constexpr (HasSizeMember<TRange>) {
+    return static_cast<std::size_t>(r.size());
+  } else {
+    return static_cast<std::size_t>(std::end(r) - std::begin(r));
+  }
+}
+
+/// Arithmetic and ordering of random-access view iterators, implemented with
+/// the `Advance(n)` and `DistanceTo(other)` members of `TIterator`. The
+/// operators are only instantiated when used, so it is safe to inherit from
+/// it whatever the category of the nested iterators is.
+template<class TIterator, class TDifference>
+struct TRandomAccessOps {
+  friend constexpr TIterator& operator+=(TIterator& it, TDifference n) {
+    it.Advance(n);
+    return it;
+  }
+  friend constexpr TIterator& operator-=(TIterator& it, TDifference n) {
+    it.Advance(-n);
+    return it;
+  }
+  friend constexpr TIterator operator+(TIterator it, TDifference n) {
+    return it += n;
+  }
+  friend constexpr TIterator operator+(TDifference n, TIterator it) {
+    return it += n;
+  }
+  friend constexpr TIterator operator-(TIterator it, TDifference n) {
+    return it -= n;
+  }
+  friend constexpr TDifference operator-(const TIterator& lhs, const TIterator& rhs) {
+    return rhs.DistanceTo(lhs);
+  }
+  friend constexpr bool operator<(const TIterator& lhs, const TIterator& rhs) {
+    return lhs.DistanceTo(rhs) > 0;
+  }
+  friend constexpr bool operator>(const TIterator& lhs, const TIterator& rhs) {
+    return rhs < lhs;
+  }
+  friend constexpr bool operator<=(const TIterator& lhs, const TIterator& rhs) {
+    return !(rhs < lhs);
+  }
+  friend constexpr bool operator>=(const TIterator& lhs, const TIterator& rhs) {
+    return !(lhs < rhs);
+  }
 };
 
+/// Decomposition of views over contiguous memory for the terminals, see below
+template<class TRange, class = void>
+struct TLowering;
+
+/// Push-based loops of the terminals, see below
+template<class TView>
+struct TPushLoop;
 
 /// Helper type for sentinel `.end()` iterator
 struct TSentinel {};
@@ -47,6 +183,11 @@ struct TRangeView : TViewTag {
     return e;
   }
 
+  template<class TIt = iterator, std::enable_if_t<std::is_same_v<TIt, TEnd> && IsIteratorOf<TIt, std::random_access_iterator_tag>, int> = 0>
+  constexpr std::size_t size() const {
+    return static_cast<std::size_t>(e - b);
+  }
+
 private:
   iterator b;
   TEnd e;
@@ -63,6 +204,8 @@ template<class TNestedView, class Fn>
 struct TMappedView : TViewTag {
   struct TIterator;
   friend TIterator;
+  template<class, class> friend struct TLowering;
+  template<class> friend struct TPushLoop;
 
   using TNestedIterator = typename TRangeTraits<TNestedView>::iterator;
 
@@ -77,21 +220,58 @@ struct TMappedView : TViewTag {
 
   constexpr TMappedView(TNestedView r, Fn mapper) : NestedView{r}, Mapper{mapper} {}
 
-  struct TIterator {
-    using iterator_category = std::input_iterator_tag;
+  /// Has the category of the nested iterator, so mapping a random-access
+  /// range keeps it random-access
+  struct TIterator : TRandomAccessOps<TIterator, TIteratorDifferenceT<TNestedIterator>> {
+    using iterator_category = TCommonIteratorCategory<TNestedIterator>;
+    using value_type = typename TMappedView::value_type;
+    using difference_type = TIteratorDifferenceT<TNestedIterator>;
+    using pointer = void;
+    using reference = value_type;
+
+    constexpr TIterator() = default;
 
     constexpr TIterator(const TMappedView* r, TNestedIterator begin)
       : UnderlyingRange{r}, NestedIterator{begin} {}
 
-    constexpr TIterator operator++() {
+    constexpr TIterator& operator++() {
       ++NestedIterator;
       return *this;
     }
 
-    constexpr value_type operator*() {
+    constexpr TIterator operator++(int) {
+      auto result = *this;
+      ++NestedIterator;
+      return result;
+    }
+
+    constexpr TIterator& operator--() {
+      --NestedIterator;
+      return *this;
+    }
+
+    constexpr TIterator operator--(int) {
+      auto result = *this;
+      --NestedIterator;
+      return result;
+    }
+
+    constexpr value_type operator*() const {
         return UnderlyingRange->Mapper(*NestedIterator);
     }
 
+    constexpr value_type operator[](difference_type n) const {
+        return UnderlyingRange->Mapper(NestedIterator[n]);
+    }
+
+    constexpr void Advance(difference_type n) {
+      NestedIterator += n;
+    }
+
+    constexpr difference_type DistanceTo(const TIterator& other) const {
+      return other.NestedIterator - NestedIterator;
+    }
+
     friend constexpr bool operator==(const TIterator &lhs, const TIterator &rhs) {
       return lhs.UnderlyingRange == rhs.UnderlyingRange && lhs.NestedIterator == rhs.NestedIterator;
     }
@@ -112,18 +292,28 @@ struct TMappedView : TViewTag {
     }
   private:
     constexpr bool IsEnd() const { return NestedIterator == std::end(UnderlyingRange->NestedView); }
-    const TMappedView* UnderlyingRange;
-    TNestedIterator NestedIterator;
+    const TMappedView* UnderlyingRange{nullptr};
+    TNestedIterator NestedIterator{};
   };
 
   constexpr TIterator begin() const {
-    return TIterator(this, NestedView.begin());
+    return TIterator(this, std::begin(NestedView));
   }
 
-  constexpr TSentinel end() const {
-    return Sentinel;
+  /// An iterator when the nested range has one, so that STL algorithms accept
+  /// the view
+  constexpr auto end() const {
+    if constexpr (TRangeTraits<TNestedView>::is_common) {
+      return TIterator(this, std::end(NestedView));
+    } else {
+      return Sentinel;
+    }
   }
 
+  template<class TView = TNestedView, std::enable_if_t<TRangeTraits<TView>::is_sized, int> = 0>
+  constexpr std::size_t size() const {
+    return RangeSize(NestedView);
+  }
 
 private:
   TNestedView NestedView;
@@ -137,26 +327,77 @@ TMappedView(TView, Fn) -> TMappedView<std::decay_t<TView>, std::decay_t<Fn>>;
 *                                Zipped range                                 *
 *******************************************************************************/
 
+/// Iterates over several ranges in lockstep until the shortest one ends.
+/// Iterators keep their own copies of the end iterators, so a step is an
+/// increment of every iterator plus comparisons that stop at the first
+/// exhausted range. Over random-access ranges `end()` is an iterator and the
+/// loop condition compares just the first iterators, like an index loop.
 template<class... TViews>
 struct TZippedView : TViewTag {
-  struct TIterator {
+  using difference_type = std::common_type_t<typename TRangeTraits<TViews>::difference_type...>;
+
+  /// Zip stays random-access and sized when all of its inputs are. Its size
+  /// is the size of the shortest input.
+  static constexpr bool is_random_access = (TRangeTraits<TViews>::is_random_access && ...);
+  static constexpr bool is_sized = (TRangeTraits<TViews>::is_sized && ...);
+
+  struct TIterator : TRandomAccessOps<TIterator, difference_type> {
     friend TZippedView;
-    using value_type = std::tuple<typename TRangeTraits<TViews>::value_type...>;
 
     using TIteratorTuple = std::tuple<typename TRangeTraits<TViews>::iterator...>;
     using TEndTuple = std::tuple<typename TRangeTraits<TViews>::TEnd...>;
 
-    constexpr TIterator operator++() {
-      IteratorTuple = utils::meta::TransformTuple(IteratorTuple, [](auto x) { return ++x; });
+    using iterator_category = TCommonIteratorCategory<typename TRangeTraits<TViews>::iterator...>;
+    using value_type = std::tuple<typename TRangeTraits<TViews>::value_type...>;
+    using difference_type = typename TZippedView::difference_type;
+    using pointer = void;
+    /// References to the elements of the inputs (or values for inputs that
+    /// compute their elements, like `Map`)
+    using reference = std::tuple<decltype(*std::declval<const typename TRangeTraits<TViews>::iterator&>())...>;
+
+    constexpr TIterator() = default;
+
+    constexpr TIterator& operator++() {
+      std::apply([](auto&... it) { (++it, ...); }, Iterators);
+      return *this;
+    }
+
+    constexpr TIterator operator++(int) {
+      auto result = *this;
+      ++*this;
+      return result;
+    }
+
+    constexpr TIterator& operator--() {
+      std::apply([](auto&... it) { (--it, ...); }, Iterators);
       return *this;
     }
 
-    constexpr value_type operator*() {
-      return utils::meta::TransformTuple(IteratorTuple, [](auto x) { return *x; });
+    constexpr TIterator operator--(int) {
+      auto result = *this;
+      --*this;
+      return result;
+    }
+
+    constexpr reference operator*() const {
+      return std::apply([](const auto&... it) { return reference{*it...}; }, Iterators);
+    }
+
+    constexpr reference operator[](difference_type n) const {
+      return *(*this + n);
+    }
+
+    constexpr void Advance(difference_type n) {
+      std::apply([n](auto&... it) { ((it += n), ...); }, Iterators);
+    }
+
+    /// The iterators move in lockstep, so the first one is representative
+    constexpr difference_type DistanceTo(const TIterator& other) const {
+      return std::get<0>(other.Iterators) - std::get<0>(Iterators);
     }
 
     friend constexpr bool operator==(const TIterator &lhs, const TIterator &rhs) {
-      return lhs.IsEnd() or rhs.IsEnd();
+      return std::get<0>(lhs.Iterators) == std::get<0>(rhs.Iterators);
     }
     friend constexpr bool operator==(const TIterator &lhs, const TSentinel&) {
       return lhs.IsEnd();
@@ -175,19 +416,19 @@ struct TZippedView : TViewTag {
     }
 
   private:
-    template<class... TBegins>
-    constexpr TIterator(const TZippedView* r, TBegins... begins) : IteratorTuple{begins...}, UnderlyingView{r} {}
+    constexpr TIterator(TIteratorTuple iterators, TEndTuple ends) : Iterators{iterators}, Ends{ends} {}
 
     constexpr bool IsEnd() const {
-      return utils::meta::ReduceTuple(
-        utils::meta::ApplyBinOp(IteratorTuple, UnderlyingView->storage, [] (auto x, auto y) { return x == std::end(y); }),
-        false,
-        std::bit_or{}
-      );
+      return IsEndImpl(std::index_sequence_for<TViews...>{});
+    }
+
+    template<size_t... Is>
+    constexpr bool IsEndImpl(std::index_sequence<Is...>) const {
+      return ((std::get<Is>(Iterators) == std::get<Is>(Ends)) || ...);
     }
 
-    TIteratorTuple IteratorTuple;
-    const TZippedView* UnderlyingView;
+    TIteratorTuple Iterators{};
+    TEndTuple Ends{};
   };
 
   using iterator = TIterator;
@@ -196,18 +437,29 @@ struct TZippedView : TViewTag {
   constexpr TZippedView(TViews... rs) : storage{std::move(rs)...} {}
 
   constexpr TIterator begin() const {
-    return BeginImpl<>(std::index_sequence_for<TViews...>{});
+    return std::apply(
+      [](const auto&... views) { return TIterator{{std::begin(views)...}, {std::end(views)...}}; },
+      storage
+    );
   }
 
-  constexpr TSentinel end() const {
-    return Sentinel;
+  /// For random-access inputs the end iterator points `size()` elements past
+  /// the beginning of every input, otherwise iteration stops at the first
+  /// exhausted input
+  constexpr auto end() const {
+    if constexpr (is_random_access) {
+      return begin() + static_cast<difference_type>(size());
+    } else {
+      return Sentinel;
+    }
   }
 
-private:
-  template<size_t... Is>
-  constexpr TIterator BeginImpl(std::index_sequence<Is...>) const {
-    return TIterator{this, std::begin(std::get<Is>(storage))...};
+  template<bool Sized = is_sized, std::enable_if_t<Sized, int> = 0>
+  constexpr std::size_t size() const {
+    return std::apply([](const auto&... views) { return std::min({RangeSize(views)...}); }, storage);
   }
+
+private:
   std::tuple<TViews...> storage;
 };
 
@@ -218,6 +470,8 @@ template<class TNestedView, class Fn>
 struct TFilteredView : TViewTag {
   struct TIterator;
   friend TIterator;
+  template<class, class> friend struct TLowering;
+  template<class> friend struct TPushLoop;
 
   using TNestedIterator = typename TRangeTraits<TNestedView>::iterator;
 
@@ -226,8 +480,20 @@ struct TFilteredView : TViewTag {
 
   TFilteredView(TNestedView r, Fn filter) : NestedView{r}, Filter{filter} {}
 
+  /// Forward at best: stepping back would need to look for the previous
+  /// match without running past the beginning
   struct TIterator {
-    using iterator_category = std::input_iterator_tag;
+    using iterator_category = std::conditional_t<
+      IsIteratorOf<TNestedIterator, std::forward_iterator_tag>,
+      std::forward_iterator_tag,
+      std::input_iterator_tag
+    >;
+    using value_type = typename TFilteredView::value_type;
+    using difference_type = TIteratorDifferenceT<TNestedIterator>;
+    using pointer = void;
+    using reference = value_type;
+
+    constexpr TIterator() = default;
 
     constexpr TIterator(const TFilteredView* r, TNestedIterator begin)
       : UnderlyingRange{r}, NestedIterator{begin} {
@@ -236,13 +502,19 @@ struct TFilteredView : TViewTag {
       }
     }
 
-    constexpr TIterator operator++() {
+    constexpr TIterator& operator++() {
       ++NestedIterator;
       SeekNext();
       return *this;
     }
 
-    constexpr value_type operator*() {
+    constexpr TIterator operator++(int) {
+      auto result = *this;
+      ++*this;
+      return result;
+    }
+
+    constexpr value_type operator*() const {
         return *NestedIterator;
     }
 
@@ -273,16 +545,20 @@ struct TFilteredView : TViewTag {
       }
     }
 
-    const TFilteredView* UnderlyingRange;
-    TNestedIterator NestedIterator;
+    const TFilteredView* UnderlyingRange{nullptr};
+    TNestedIterator NestedIterator{};
   };
 
   constexpr TIterator begin() const {
-    return TIterator(this, NestedView.begin());
+    return TIterator(this, std::begin(NestedView));
   }
 
-  constexpr TSentinel end() const {
-    return Sentinel;
+  constexpr auto end() const {
+    if constexpr (TRangeTraits<TNestedView>::is_common) {
+      return TIterator(this, std::end(NestedView));
+    } else {
+      return Sentinel;
+    }
   }
 
 
@@ -297,44 +573,1476 @@ TFilteredView(TView, Fn) -> TFilteredView<std::decay_t<TView>, std::decay_t<Fn>>
 }  // namespace utils::detail
 
 /*******************************************************************************
-*                             Itertools interface                             *
+*                                    TSpan                                    *
 *******************************************************************************/
 
+/// Non-owning view of a contiguous array, a minimal `std::span` for C++17.
+/// It is a view itself, so it composes with the other adaptors.
+template<class T>
+struct TSpan : detail::TViewTag {
+  using element_type = T;
+  using value_type = std::remove_cv_t<T>;
+  using iterator = T*;
+
+  constexpr TSpan() = default;
+  constexpr TSpan(T* data, std::size_t size) : Data{data}, Size{size} {}
+  constexpr TSpan(T* first, T* last) : Data{first}, Size{static_cast<std::size_t>(last - first)} {}
+
+  constexpr T* begin() const {
+    return Data;
+  }
+
+  constexpr T* end() const {
+    return Data + Size;
+  }
+
+  constexpr T* data() const {
+    return Data;
+  }
+
+  constexpr std::size_t size() const {
+    return Size;
+  }
+
+  constexpr bool empty() const {
+    return Size == 0;
+  }
+
+  constexpr T& operator[](std::size_t i) const {
+    return Data[i];
+  }
+
+private:
+  T* Data{nullptr};
+  std::size_t Size{0};
+};
+
+namespace detail {
+
+/// Ranges that expose their storage with `std::data` and `std::size`
+template<class TRange, class = void>
+inline constexpr bool IsContiguous = false;
+
 template<class TRange>
-auto MakeView(const TRange& c) {
-  if constexpr (detail::TRangeTraits<TRange>::is_view) {
-    return c;
+inline constexpr bool IsContiguous<
+  TRange,
+  std::void_t<decltype(std::data(std::declval<const TRange&>())), decltype(std::size(std::declval<const TRange&>()))>
+> = std::is_pointer_v<decltype(std::data(std::declval<const TRange&>()))>;
+
+/// Advances `it` by up to `n` steps without passing `end`, in one step for
+/// random-access iterators
+template<class TIt, class TEnd>
+constexpr void AdvanceBounded(TIt& it, std::size_t n, const TEnd& end) {
+  if constexpr (std::is_same_v<TIt, TEnd> && IsIteratorOf<TIt, std::random_access_iterator_tag>) {
+    it += static_cast<TIteratorDifferenceT<TIt>>(std::min(n, static_cast<std::size_t>(end - it)));
   } else {
-    return detail::TRangeView{std::begin(c), std::end(c)};
+    for (; n > 0 && it != end; n--) {
+      ++it;
+    }
   }
 }
 
-template<class TRange, class Fn>
-auto Map(const TRange& r, Fn mapper) {
-  return detail::TMappedView{MakeView(r), mapper};
-}
+/*******************************************************************************
+*                                Chunked range                                *
+*******************************************************************************/
 
-template<class... TRanges>
-auto Zip(const TRanges&... ranges) {
-  return detail::TZippedView(MakeView(ranges)...);
-}
+/// Consecutive non-overlapping subranges of `Size` elements, the last one may
+/// be shorter. Subranges of pointer ranges are `TSpan`s.
+template<class TNestedView>
+struct TChunkedView : TViewTag {
+  using TNestedIterator = typename TRangeTraits<TNestedView>::iterator;
+  using TNestedEnd = typename TRangeTraits<TNestedView>::TEnd;
 
-template<class TRange, class Fn>
-auto Filter(const TRange& r, Fn filter) {
-  return detail::TFilteredView{MakeView(r), filter};
-}
+  using value_type = std::conditional_t<
+    std::is_pointer_v<TNestedIterator>,
+    TSpan<std::remove_pointer_t<TNestedIterator>>,
+    TRangeView<TNestedIterator, TNestedIterator>
+  >;
+
+  constexpr TChunkedView(TNestedView r, std::size_t size) : NestedView{r}, Size{size} {}
+
+  struct TIterator {
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = typename TChunkedView::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = value_type;
+
+    constexpr TIterator() = default;
+
+    constexpr TIterator(TNestedIterator begin, TNestedEnd end, std::size_t size)
+      : Begin{begin}, ChunkEnd{begin}, End{end}, Size{size} {
+      AdvanceBounded(ChunkEnd, Size, End);
+    }
+
+    constexpr TIterator& operator++() {
+      Begin = ChunkEnd;
+      AdvanceBounded(ChunkEnd, Size, End);
+      return *this;
+    }
+
+    constexpr TIterator operator++(int) {
+      auto result = *this;
+      ++*this;
+      return result;
+    }
+
+    constexpr value_type operator*() const {
+      return value_type{Begin, ChunkEnd};
+    }
+
+    friend constexpr bool operator==(const TIterator &lhs, const TIterator &rhs) {
+      return lhs.Begin == rhs.Begin;
+    }
+    friend constexpr bool operator==(const TIterator &lhs, const TSentinel&) {
+      return lhs.IsEnd();
+    }
+    friend constexpr bool operator==(const TSentinel&, const TIterator &rhs) {
+      return rhs.IsEnd();
+    }
+    friend constexpr bool operator!=(const TIterator &lhs, const TIterator &rhs) {
+      return !(lhs == rhs);
+    }
+    friend constexpr bool operator!=(const TIterator &lhs, const TSentinel &rhs) {
+      return !(lhs == rhs);
+    }
+    friend constexpr bool operator!=(const TSentinel &lhs, const TIterator &rhs) {
+      return !(lhs == rhs);
+    }
+  private:
+    constexpr bool IsEnd() const { return Begin == End; }
+
+    TNestedIterator Begin{};
+    TNestedIterator ChunkEnd{};
+    TNestedEnd End{};
+    std::size_t Size{0};
+  };
+
+  using iterator = TIterator;
+
+  constexpr TIterator begin() const {
+    return TIterator(std::begin(NestedView), std::end(NestedView), Size);
+  }
+
+  constexpr TSentinel end() const {
+    return Sentinel;
+  }
+
+  template<class TView = TNestedView, std::enable_if_t<TRangeTraits<TView>::is_sized, int> = 0>
+  constexpr std::size_t size() const {
+    // rounded up without `n + Size - 1`, which overflows for huge sizes
+    const auto n = RangeSize(NestedView);
+    return n / Size + (n % Size != 0);
+  }
+
+private:
+  TNestedView NestedView;
+  std::size_t Size;
+};
+
+template<class TView>
+TChunkedView(TView, std::size_t) -> TChunkedView<std::decay_t<TView>>;
 
 /*******************************************************************************
-*                                 ToContainer                                 *
+*                               Windowed range                                *
 *******************************************************************************/
 
-template<class TRange>
-auto ToVector(const TRange& c) {
-  std::vector<typename detail::TRangeTraits<TRange>::value_type> result;
-  for (auto v : c) {
-    result.emplace_back(std::move(v));
+/// All subranges of `Size` consecutive elements, each one shifted by one
+/// element from the previous one
+template<class TNestedView>
+struct TWindowedView : TViewTag {
+  using TNestedIterator = typename TRangeTraits<TNestedView>::iterator;
+  using TNestedEnd = typename TRangeTraits<TNestedView>::TEnd;
+
+  using value_type = typename TChunkedView<TNestedView>::value_type;
+
+  constexpr TWindowedView(TNestedView r, std::size_t size) : NestedView{r}, Size{size} {}
+
+  struct TIterator {
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = typename TWindowedView::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = value_type;
+
+    constexpr TIterator() = default;
+
+    constexpr TIterator(TNestedIterator begin, TNestedEnd end, std::size_t size)
+      : Begin{begin}, WindowEnd{begin}, End{end} {
+      for (std::size_t i = 0; i < size; i++) {
+        if (WindowEnd == End) {
+          Done = true;
+          break;
+        }
+        ++WindowEnd;
+      }
+    }
+
+    constexpr TIterator& operator++() {
+      if (WindowEnd == End) {
+        Done = true;
+      } else {
+        ++Begin;
+        ++WindowEnd;
+      }
+      return *this;
+    }
+
+    constexpr TIterator operator++(int) {
+      auto result = *this;
+      ++*this;
+      return result;
+    }
+
+    constexpr value_type operator*() const {
+      return value_type{Begin, WindowEnd};
+    }
+
+    friend constexpr bool operator==(const TIterator &lhs, const TIterator &rhs) {
+      return lhs.Done == rhs.Done && (lhs.Done || lhs.Begin == rhs.Begin);
+    }
+    friend constexpr bool operator==(const TIterator &lhs, const TSentinel&) {
+      return lhs.Done;
+    }
+    friend constexpr bool operator==(const TSentinel&, const TIterator &rhs) {
+      return rhs.Done;
+    }
+    friend constexpr bool operator!=(const TIterator &lhs, const TIterator &rhs) {
+      return !(lhs == rhs);
+    }
+    friend constexpr bool operator!=(const TIterator &lhs, const TSentinel &rhs) {
+      return !(lhs == rhs);
+    }
+    friend constexpr bool operator!=(const TSentinel &lhs, const TIterator &rhs) {
+      return !(lhs == rhs);
+    }
+  private:
+    TNestedIterator Begin{};
+    TNestedIterator WindowEnd{};
+    TNestedEnd End{};
+    bool Done{false};
+  };
+
+  using iterator = TIterator;
+
+  constexpr TIterator begin() const {
+    return TIterator(std::begin(NestedView), std::end(NestedView), Size);
   }
-  return result;
+
+  constexpr TSentinel end() const {
+    return Sentinel;
+  }
+
+  template<class TView = TNestedView, std::enable_if_t<TRangeTraits<TView>::is_sized, int> = 0>
+  constexpr std::size_t size() const {
+    const auto nested = RangeSize(NestedView);
+    return nested < Size ? 0 : nested - Size + 1;
+  }
+
+private:
+  TNestedView NestedView;
+  std::size_t Size;
+};
+
+template<class TView>
+TWindowedView(TView, std::size_t) -> TWindowedView<std::decay_t<TView>>;
+
+/*******************************************************************************
+*                              Enumerated range                               *
+*******************************************************************************/
+
+/// Pairs every element with its index as `std::tuple<std::size_t, T>`
+template<class TNestedView>
+struct TEnumeratedView : TViewTag {
+  using TNestedIterator = typename TRangeTraits<TNestedView>::iterator;
+
+  using value_type = std::tuple<std::size_t, typename TRangeTraits<TNestedView>::value_type>;
+
+  constexpr TEnumeratedView(TNestedView r) : NestedView{r} {}
+
+  struct TIterator : TRandomAccessOps<TIterator, TIteratorDifferenceT<TNestedIterator>> {
+    using iterator_category = TCommonIteratorCategory<TNestedIterator>;
+    using value_type = typename TEnumeratedView::value_type;
+    using difference_type = TIteratorDifferenceT<TNestedIterator>;
+    using pointer = void;
+    using reference = std::tuple<std::size_t, decltype(*std::declval<const TNestedIterator&>())>;
+
+    constexpr TIterator() = default;
+
+    constexpr TIterator(std::size_t index, TNestedIterator it) : Index{index}, NestedIterator{it} {}
+
+    constexpr TIterator& operator++() {
+      ++Index;
+      ++NestedIterator;
+      return *this;
+    }
+
+    constexpr TIterator operator++(int) {
+      auto result = *this;
+      ++*this;
+      return result;
+    }
+
+    constexpr TIterator& operator--() {
+      --Index;
+      --NestedIterator;
+      return *this;
+    }
+
+    constexpr TIterator operator--(int) {
+      auto result = *this;
+      --*this;
+      return result;
+    }
+
+    constexpr reference operator*() const {
+      return reference{Index, *NestedIterator};
+    }
+
+    constexpr reference operator[](difference_type n) const {
+      return *(*this + n);
+    }
+
+    constexpr void Advance(difference_type n) {
+      Index += n;
+      NestedIterator += n;
+    }
+
+    constexpr difference_type DistanceTo(const TIterator& other) const {
+      return other.NestedIterator - NestedIterator;
+    }
+
+    template<class TEnd>
+    constexpr bool IsAt(const TEnd& end) const {
+      return NestedIterator == end;
+    }
+
+    friend constexpr bool operator==(const TIterator &lhs, const TIterator &rhs) {
+      return lhs.NestedIterator == rhs.NestedIterator;
+    }
+    friend constexpr bool operator!=(const TIterator &lhs, const TIterator &rhs) {
+      return !(lhs == rhs);
+    }
+  private:
+    std::size_t Index{0};
+    TNestedIterator NestedIterator{};
+  };
+
+  /// Compares the nested iterator with the nested end
+  struct TEnd {
+    typename TRangeTraits<TNestedView>::TEnd End;
+
+    friend constexpr bool operator==(const TIterator &lhs, const TEnd& rhs) {
+      return lhs.IsAt(rhs.End);
+    }
+    friend constexpr bool operator==(const TEnd& lhs, const TIterator &rhs) {
+      return rhs.IsAt(lhs.End);
+    }
+    friend constexpr bool operator!=(const TIterator &lhs, const TEnd &rhs) {
+      return !(lhs == rhs);
+    }
+    friend constexpr bool operator!=(const TEnd &lhs, const TIterator &rhs) {
+      return !(lhs == rhs);
+    }
+  };
+
+  using iterator = TIterator;
+
+  constexpr TIterator begin() const {
+    return TIterator(0, std::begin(NestedView));
+  }
+
+  constexpr auto end() const {
+    if constexpr (TRangeTraits<TNestedView>::is_random_access) {
+      return TIterator(RangeSize(NestedView), std::end(NestedView));
+    } else {
+      return TEnd{std::end(NestedView)};
+    }
+  }
+
+  template<class TView = TNestedView, std::enable_if_t<TRangeTraits<TView>::is_sized, int> = 0>
+  constexpr std::size_t size() const {
+    return RangeSize(NestedView);
+  }
+
+private:
+  TNestedView NestedView;
+};
+
+template<class TView>
+TEnumeratedView(TView) -> TEnumeratedView<std::decay_t<TView>>;
+
+/*******************************************************************************
+*                               Take/Drop range                               *
+*******************************************************************************/
+
+/// The first `Count` elements. Over random-access ranges the iterators are
+/// the nested ones.
+template<class TNestedView>
+struct TTakeView : TViewTag {
+  template<class> friend struct TPushLoop;
+
+  using TNestedIterator = typename TRangeTraits<TNestedView>::iterator;
+  using TNestedEnd = typename TRangeTraits<TNestedView>::TEnd;
+
+  using value_type = typename TRangeTraits<TNestedView>::value_type;
+
+  constexpr TTakeView(TNestedView r, std::size_t count) : NestedView{r}, Count{count} {}
+
+  struct TCountedIterator {
+    using iterator_category = std::conditional_t<
+      IsIteratorOf<TNestedIterator, std::forward_iterator_tag>,
+      std::forward_iterator_tag,
+      std::input_iterator_tag
+    >;
+    using value_type = typename TTakeView::value_type;
+    using difference_type = TIteratorDifferenceT<TNestedIterator>;
+    using pointer = void;
+    using reference = decltype(*std::declval<const TNestedIterator&>());
+
+    constexpr TCountedIterator() = default;
+
+    constexpr TCountedIterator(TNestedIterator it, TNestedEnd end, std::size_t remaining)
+      : NestedIterator{it}, End{end}, Remaining{remaining} {}
+
+    constexpr TCountedIterator& operator++() {
+      ++NestedIterator;
+      --Remaining;
+      return *this;
+    }
+
+    constexpr TCountedIterator operator++(int) {
+      auto result = *this;
+      ++*this;
+      return result;
+    }
+
+    constexpr reference operator*() const {
+      return *NestedIterator;
+    }
+
+    friend constexpr bool operator==(const TCountedIterator &lhs, const TCountedIterator &rhs) {
+      return lhs.NestedIterator == rhs.NestedIterator;
+    }
+    friend constexpr bool operator==(const TCountedIterator &lhs, const TSentinel&) {
+      return lhs.IsEnd();
+    }
+    friend constexpr bool operator==(const TSentinel&, const TCountedIterator &rhs) {
+      return rhs.IsEnd();
+    }
+    friend constexpr bool operator!=(const TCountedIterator &lhs, const TCountedIterator &rhs) {
+      return !(lhs == rhs);
+    }
+    friend constexpr bool operator!=(const TCountedIterator &lhs, const TSentinel &rhs) {
+      return !(lhs == rhs);
+    }
+    friend constexpr bool operator!=(const TSentinel &lhs, const TCountedIterator &rhs) {
+      return !(lhs == rhs);
+    }
+  private:
+    constexpr bool IsEnd() const { return Remaining == 0 || NestedIterator == End; }
+
+    TNestedIterator NestedIterator{};
+    TNestedEnd End{};
+    std::size_t Remaining{0};
+  };
+
+  using iterator = std::conditional_t<TRangeTraits<TNestedView>::is_random_access, TNestedIterator, TCountedIterator>;
+
+  constexpr iterator begin() const {
+    if constexpr (TRangeTraits<TNestedView>::is_random_access) {
+      return std::begin(NestedView);
+    } else {
+      return TCountedIterator(std::begin(NestedView), std::end(NestedView), Count);
+    }
+  }
+
+  constexpr auto end() const {
+    if constexpr (TRangeTraits<TNestedView>::is_random_access) {
+      return std::begin(NestedView) + static_cast<TIteratorDifferenceT<TNestedIterator>>(size());
+    } else {
+      return Sentinel;
+    }
+  }
+
+  template<class TView = TNestedView, std::enable_if_t<TRangeTraits<TView>::is_sized, int> = 0>
+  constexpr std::size_t size() const {
+    return std::min(Count, RangeSize(NestedView));
+  }
+
+private:
+  TNestedView NestedView;
+  std::size_t Count;
+};
+
+template<class TView>
+TTakeView(TView, std::size_t) -> TTakeView<std::decay_t<TView>>;
+
+/// Everything but the first `Count` elements. The iterators are the nested
+/// ones; `begin()` skips the elements on every call, in one step for
+/// random-access ranges.
+template<class TNestedView>
+struct TDropView : TViewTag {
+  template<class> friend struct TPushLoop;
+
+  using iterator = typename TRangeTraits<TNestedView>::iterator;
+  using value_type = typename TRangeTraits<TNestedView>::value_type;
+
+  constexpr TDropView(TNestedView r, std::size_t count) : NestedView{r}, Count{count} {}
+
+  constexpr iterator begin() const {
+    auto it = std::begin(NestedView);
+    AdvanceBounded(it, Count, std::end(NestedView));
+    return it;
+  }
+
+  constexpr auto end() const {
+    return std::end(NestedView);
+  }
+
+  template<class TView = TNestedView, std::enable_if_t<TRangeTraits<TView>::is_sized, int> = 0>
+  constexpr std::size_t size() const {
+    const auto nested = RangeSize(NestedView);
+    return nested - std::min(Count, nested);
+  }
+
+private:
+  TNestedView NestedView;
+  std::size_t Count;
+};
+
+template<class TView>
+TDropView(TView, std::size_t) -> TDropView<std::decay_t<TView>>;
+
+/*******************************************************************************
+*                                Chained range                                *
+*******************************************************************************/
+
+/// The elements of all ranges one after another, as values of their common
+/// type
+template<class... TViews>
+struct TChainedView : TViewTag {
+  static constexpr std::size_t COUNT = sizeof...(TViews);
+
+  using value_type = std::common_type_t<typename TRangeTraits<TViews>::value_type...>;
+
+  struct TIterator {
+    friend TChainedView;
+
+    using TIteratorTuple = std::tuple<typename TRangeTraits<TViews>::iterator...>;
+    using TEndTuple = std::tuple<typename TRangeTraits<TViews>::TEnd...>;
+
+    using iterator_category = std::conditional_t<
+      (IsIteratorOf<typename TRangeTraits<TViews>::iterator, std::forward_iterator_tag> && ...),
+      std::forward_iterator_tag,
+      std::input_iterator_tag
+    >;
+    using value_type = typename TChainedView::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = value_type;
+
+    constexpr TIterator() = default;
+
+    constexpr TIterator& operator++() {
+      Increment<0>();
+      SkipExhausted();
+      return *this;
+    }
+
+    constexpr TIterator operator++(int) {
+      auto result = *this;
+      ++*this;
+      return result;
+    }
+
+    constexpr value_type operator*() const {
+      return Dereference<0>();
+    }
+
+    friend constexpr bool operator==(const TIterator &lhs, const TIterator &rhs) {
+      return lhs.Active == rhs.Active && (lhs.Active == COUNT || lhs.Iterators == rhs.Iterators);
+    }
+    friend constexpr bool operator==(const TIterator &lhs, const TSentinel&) {
+      return lhs.Active == COUNT;
+    }
+    friend constexpr bool operator==(const TSentinel&, const TIterator &rhs) {
+      return rhs.Active == COUNT;
+    }
+    friend constexpr bool operator!=(const TIterator &lhs, const TIterator &rhs) {
+      return !(lhs == rhs);
+    }
+    friend constexpr bool operator!=(const TIterator &lhs, const TSentinel &rhs) {
+      return !(lhs == rhs);
+    }
+    friend constexpr bool operator!=(const TSentinel &lhs, const TIterator &rhs) {
+      return !(lhs == rhs);
+    }
+
+  private:
+    constexpr TIterator(TIteratorTuple iterators, TEndTuple ends) : Iterators{iterators}, Ends{ends} {
+      SkipExhausted();
+    }
+
+    template<std::size_t I>
+    constexpr void Increment() {
+      if constexpr (I < COUNT) {
+        if (Active == I) {
+          ++std::get<I>(Iterators);
+        } else {
+          Increment<I + 1>();
+        }
+      }
+    }
+
+    template<std::size_t I>
+    constexpr bool ActiveExhausted() const {
+      if constexpr (I < COUNT) {
+        return Active == I ? std::get<I>(Iterators) == std::get<I>(Ends) : ActiveExhausted<I + 1>();
+      } else {
+        return false;
+      }
+    }
+
+    template<std::size_t I>
+    constexpr value_type Dereference() const {
+      if constexpr (I + 1 < COUNT) {
+        return Active == I ? value_type(*std::get<I>(Iterators)) : Dereference<I + 1>();
+      } else {
+        return *std::get<I>(Iterators);
+      }
+    }
+
+    constexpr void SkipExhausted() {
+      while (Active < COUNT && ActiveExhausted<0>()) {
+        Active++;
+      }
+    }
+
+    TIteratorTuple Iterators{};
+    TEndTuple Ends{};
+    /// Index of the range being iterated, `COUNT` at the end
+    std::size_t Active{0};
+  };
+
+  using iterator = TIterator;
+
+  constexpr TChainedView(TViews... rs) : storage{std::move(rs)...} {}
+
+  constexpr TIterator begin() const {
+    return std::apply(
+      [](const auto&... views) { return TIterator{{std::begin(views)...}, {std::end(views)...}}; },
+      storage
+    );
+  }
+
+  constexpr TSentinel end() const {
+    return Sentinel;
+  }
+
+  template<bool Sized = (TRangeTraits<TViews>::is_sized && ...), std::enable_if_t<Sized, int> = 0>
+  constexpr std::size_t size() const {
+    return std::apply([](const auto&... views) { return (RangeSize(views) + ...); }, storage);
+  }
+
+private:
+  std::tuple<TViews...> storage;
+};
+
+template<class... TViews>
+TChainedView(TViews...) -> TChainedView<std::decay_t<TViews>...>;
+
+/*******************************************************************************
+*                               Batched range                                 *
+*******************************************************************************/
+
+/// Batches of a non-contiguous range: up to `Size` elements are copied into a
+/// buffer owned by the iterator, which is reused for every batch. A batch is
+/// valid until the iterator is advanced.
+template<class TNestedView>
+struct TStagedBatchedView : TViewTag {
+  using TNestedIterator = typename TRangeTraits<TNestedView>::iterator;
+  using TNestedEnd = typename TRangeTraits<TNestedView>::TEnd;
+  using TElement = typename TRangeTraits<TNestedView>::value_type;
+
+  using value_type = TSpan<const TElement>;
+
+  constexpr TStagedBatchedView(TNestedView r, std::size_t size) : NestedView{r}, Size{size} {}
+
+  struct TIterator {
+    using iterator_category = std::input_iterator_tag;
+    using value_type = typename TStagedBatchedView::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = value_type;
+
+    TIterator() = default;
+
+    TIterator(TNestedIterator begin, TNestedEnd end, std::size_t size)
+      : NestedIterator{begin}, End{end}, Size{size} {
+      Buffer.reserve(Size);
+      Fill();
+    }
+
+    TIterator& operator++() {
+      Fill();
+      return *this;
+    }
+
+    value_type operator*() const {
+      return value_type{Buffer.data(), Buffer.size()};
+    }
+
+    friend bool operator==(const TIterator &lhs, const TIterator &rhs) {
+      return lhs.NestedIterator == rhs.NestedIterator && lhs.Buffer.size() == rhs.Buffer.size();
+    }
+    friend bool operator==(const TIterator &lhs, const TSentinel&) {
+      return lhs.Buffer.empty();
+    }
+    friend bool operator==(const TSentinel&, const TIterator &rhs) {
+      return rhs.Buffer.empty();
+    }
+    friend bool operator!=(const TIterator &lhs, const TIterator &rhs) {
+      return !(lhs == rhs);
+    }
+    friend bool operator!=(const TIterator &lhs, const TSentinel &rhs) {
+      return !(lhs == rhs);
+    }
+    friend bool operator!=(const TSentinel &lhs, const TIterator &rhs) {
+      return !(lhs == rhs);
+    }
+  private:
+    void Fill() {
+      Buffer.clear();
+      for (; Buffer.size() < Size && NestedIterator != End; ++NestedIterator) {
+        Buffer.push_back(*NestedIterator);
+      }
+    }
+
+    TNestedIterator NestedIterator{};
+    TNestedEnd End{};
+    std::size_t Size{0};
+    std::vector<TElement> Buffer;
+  };
+
+  using iterator = TIterator;
+
+  TIterator begin() const {
+    return TIterator(std::begin(NestedView), std::end(NestedView), Size);
+  }
+
+  constexpr TSentinel end() const {
+    return Sentinel;
+  }
+
+  template<class TView = TNestedView, std::enable_if_t<TRangeTraits<TView>::is_sized, int> = 0>
+  constexpr std::size_t size() const {
+    // rounded up without `n + Size - 1`, which overflows for huge sizes
+    const auto n = RangeSize(NestedView);
+    return n / Size + (n % Size != 0);
+  }
+
+private:
+  TNestedView NestedView;
+  std::size_t Size;
+};
+
+template<class TView>
+TStagedBatchedView(TView, std::size_t) -> TStagedBatchedView<std::decay_t<TView>>;
+
+inline void CheckPositiveSize(std::size_t size, const char* adaptor) {
+  if (size == 0) {
+    throw std::invalid_argument(std::string{adaptor} + ": the size must be positive");
+  }
+}
+
+}  // namespace utils::detail
+
+/*******************************************************************************
+*                             Itertools interface                             *
+*******************************************************************************/
+
+template<class TRange>
+auto MakeView(const TRange& c) {
+  if constexpr (detail::TRangeTraits<TRange>::is_view) {
+    return c;
+  } else {
+    return detail::TRangeView{std::begin(c), std::end(c)};
+  }
+}
+
+template<class TRange, class Fn>
+auto Map(const TRange& r, Fn mapper) {
+  return detail::TMappedView{MakeView(r), mapper};
+}
+
+template<class... TRanges>
+auto Zip(const TRanges&... ranges) {
+  return detail::TZippedView(MakeView(ranges)...);
+}
+
+template<class TRange, class Fn>
+auto Filter(const TRange& r, Fn filter) {
+  return detail::TFilteredView{MakeView(r), filter};
+}
+
+/// Consecutive subranges of `size` elements, the last one may be shorter
+template<class TRange>
+auto Chunk(const TRange& r, std::size_t size) {
+  detail::CheckPositiveSize(size, "Chunk");
+  return detail::TChunkedView{MakeView(r), size};
+}
+
+/// Sliding windows of `size` consecutive elements
+template<class TRange>
+auto Window(const TRange& r, std::size_t size) {
+  detail::CheckPositiveSize(size, "Window");
+  return detail::TWindowedView{MakeView(r), size};
+}
+
+/// `(index, element)` tuples, the element is a reference when `r` yields one
+template<class TRange>
+auto Enumerate(const TRange& r) {
+  return detail::TEnumeratedView{MakeView(r)};
+}
+
+template<class TRange>
+auto Take(const TRange& r, std::size_t count) {
+  return detail::TTakeView{MakeView(r), count};
+}
+
+template<class TRange>
+auto Drop(const TRange& r, std::size_t count) {
+  return detail::TDropView{MakeView(r), count};
+}
+
+template<class... TRanges>
+auto Chain(const TRanges&... ranges) {
+  return detail::TChainedView(MakeView(ranges)...);
+}
+
+/// Batches of up to `size` elements as `TSpan<const T>`, for consumers that
+/// work on contiguous memory. Spans over contiguous ranges point into the
+/// range itself, other ranges are copied batch by batch into a buffer that
+/// is reused for the whole iteration.
+template<class TRange>
+auto Batched(const TRange& r, std::size_t size) {
+  detail::CheckPositiveSize(size, "Batched");
+  if constexpr (detail::IsContiguous<TRange>) {
+    using TElement = std::remove_pointer_t<decltype(std::data(r))>;
+    return detail::TChunkedView{TSpan<TElement>{std::data(r), std::size(r)}, size};
+  } else {
+    return detail::TStagedBatchedView{MakeView(r), size};
+  }
+}
+
+/*******************************************************************************
+*                                  Pipelines                                  *
+*******************************************************************************/
+
+namespace detail {
+
+/// Adaptor or terminal waiting for its range: `r | closure` is
+/// `closure.Apply(r)`. Closures compose, `Map(f) | Filter(g)` is a closure
+/// too. The views keep referring to `r`, so a temporary container must be
+/// consumed by a terminal within the same expression.
+template<class Fn>
+struct TPipeClosure {
+  Fn Apply;
+};
+
+template<class Fn>
+TPipeClosure(Fn) -> TPipeClosure<Fn>;
+
+template<class TRange, class Fn>
+constexpr auto operator|(const TRange& r, const TPipeClosure<Fn>& closure) {
+  return closure.Apply(r);
+}
+
+template<class Fn1, class Fn2>
+constexpr auto operator|(const TPipeClosure<Fn1>& first, const TPipeClosure<Fn2>& second) {
+  return TPipeClosure{[first, second](const auto& r) { return second.Apply(first.Apply(r)); }};
+}
+
+/// Calls `sink(element)` for every element until the sink returns false and
+/// tells whether the sink consumed everything. Maps, filters, takes and drops
+/// are unwrapped into nested sinks at compile time, so the terminals run a
+/// single loop over the innermost source instead of pulling every element
+/// through each layer of iterators.
+template<class TView>
+struct TPushLoop {
+  template<class TSink>
+  static constexpr bool Run(const TView& view, TSink&& sink) {
+    for (auto&& x : view) {
+      if (!sink(std::forward<decltype(x)>(x))) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+template<class TNestedView, class Fn>
+struct TPushLoop<TMappedView<TNestedView, Fn>> {
+  template<class TSink>
+  static constexpr bool Run(const TMappedView<TNestedView, Fn>& view, TSink&& sink) {
+    return TPushLoop<TNestedView>::Run(view.NestedView, [&view, &sink](auto&& x) {
+      return sink(view.Mapper(std::forward<decltype(x)>(x)));
+    });
+  }
+};
+
+template<class TNestedView, class Fn>
+struct TPushLoop<TFilteredView<TNestedView, Fn>> {
+  template<class TSink>
+  static constexpr bool Run(const TFilteredView<TNestedView, Fn>& view, TSink&& sink) {
+    return TPushLoop<TNestedView>::Run(view.NestedView, [&view, &sink](auto&& x) {
+      return !view.Filter(x) || sink(std::forward<decltype(x)>(x));
+    });
+  }
+};
+
+template<class TNestedView>
+struct TPushLoop<TTakeView<TNestedView>> {
+  template<class TSink>
+  static constexpr bool Run(const TTakeView<TNestedView>& view, TSink&& sink) {
+    auto remaining = view.Count;
+    if (remaining == 0) {
+      return true;
+    }
+    bool stopped = false;
+    TPushLoop<TNestedView>::Run(view.NestedView, [&remaining, &stopped, &sink](auto&& x) {
+      if (!sink(std::forward<decltype(x)>(x))) {
+        stopped = true;
+        return false;
+      }
+      return --remaining != 0;
+    });
+    return !stopped;
+  }
+};
+
+template<class TView>
+inline constexpr bool HasMap = false;
+
+template<class TNestedView, class Fn>
+inline constexpr bool HasMap<TMappedView<TNestedView, Fn>> = true;
+
+template<class TNestedView, class Fn>
+inline constexpr bool HasMap<TFilteredView<TNestedView, Fn>> = HasMap<TNestedView>;
+
+template<class TNestedView>
+inline constexpr bool HasMap<TTakeView<TNestedView>> = HasMap<TNestedView>;
+
+template<class TNestedView>
+inline constexpr bool HasMap<TDropView<TNestedView>> = HasMap<TNestedView>;
+
+/// Whether a filter of the view looks at mapped elements, so that pulling an
+/// element out of it calls the mapper for every element the filter skips
+template<class TView>
+inline constexpr bool HasFilterOverMap = false;
+
+template<class TNestedView, class Fn>
+inline constexpr bool HasFilterOverMap<TFilteredView<TNestedView, Fn>> =
+  HasMap<TNestedView> || HasFilterOverMap<TNestedView>;
+
+template<class TNestedView, class Fn>
+inline constexpr bool HasFilterOverMap<TMappedView<TNestedView, Fn>> = HasFilterOverMap<TNestedView>;
+
+template<class TNestedView>
+inline constexpr bool HasFilterOverMap<TTakeView<TNestedView>> = HasFilterOverMap<TNestedView>;
+
+template<class TNestedView>
+inline constexpr bool HasFilterOverMap<TDropView<TNestedView>> = HasFilterOverMap<TNestedView>;
+
+/// `begin()` skips the dropped elements without mapping them, and a filter
+/// below every map only evaluates its predicate on them. The drop is folded
+/// into the sinks only when a filter over a map has to map them anyway.
+template<class TNestedView>
+struct TPushLoop<TDropView<TNestedView>> {
+  template<class TSink>
+  static constexpr bool Run(const TDropView<TNestedView>& view, TSink&& sink) {
+    if constexpr (!HasFilterOverMap<TNestedView>) {
+      for (auto&& x : view) {
+        if (!sink(std::forward<decltype(x)>(x))) {
+          return false;
+        }
+      }
+      return true;
+    } else {
+      auto skipped = view.Count;
+      return TPushLoop<TNestedView>::Run(view.NestedView, [&skipped, &sink](auto&& x) {
+        if (skipped != 0) {
+          skipped--;
+          return true;
+        }
+        return sink(std::forward<decltype(x)>(x));
+      });
+    }
+  }
+};
+
+template<class TRange, class TSink>
+constexpr bool PushEach(const TRange& r, TSink&& sink) {
+  return TPushLoop<TRange>::Run(r, std::forward<TSink>(sink));
+}
+
+}  // namespace utils::detail
+
+/// Pipe forms of the adaptors: `r | Filter(f) | Map(g) | Take(10)`
+template<class Fn>
+auto Map(Fn mapper) {
+  return detail::TPipeClosure{[mapper](const auto& r) { return Map(r, mapper); }};
+}
+
+template<class Fn>
+auto Filter(Fn filter) {
+  return detail::TPipeClosure{[filter](const auto& r) { return Filter(r, filter); }};
+}
+
+inline auto Chunk(std::size_t size) {
+  return detail::TPipeClosure{[size](const auto& r) { return Chunk(r, size); }};
+}
+
+inline auto Window(std::size_t size) {
+  return detail::TPipeClosure{[size](const auto& r) { return Window(r, size); }};
+}
+
+inline auto Enumerate() {
+  return detail::TPipeClosure{[](const auto& r) { return Enumerate(r); }};
+}
+
+inline auto Take(std::size_t count) {
+  return detail::TPipeClosure{[count](const auto& r) { return Take(r, count); }};
+}
+
+inline auto Drop(std::size_t count) {
+  return detail::TPipeClosure{[count](const auto& r) { return Drop(r, count); }};
+}
+
+inline auto Batched(std::size_t size) {
+  return detail::TPipeClosure{[size](const auto& r) { return Batched(r, size); }};
+}
+
+/*******************************************************************************
+*                                 ToContainer                                 *
+*******************************************************************************/
+
+/// Reserves the exact size upfront when the range is sized
+template<class TRange>
+auto ToVector(const TRange& c) {
+  std::vector<typename detail::TRangeTraits<TRange>::value_type> result;
+  if constexpr (detail::TRangeTraits<TRange>::is_sized) {
+    result.reserve(detail::RangeSize(c));
+  }
+  detail::PushEach(c, [&result](auto&& v) {
+    result.emplace_back(std::forward<decltype(v)>(v));
+    return true;
+  });
+  return result;
+}
+
+/// Calls `fn` on every element, in a single loop over the source
+template<class TRange, class Fn>
+void ForEach(const TRange& r, Fn fn) {
+  detail::PushEach(r, [&fn](auto&& v) {
+    fn(std::forward<decltype(v)>(v));
+    return true;
+  });
+}
+
+/*******************************************************************************
+*                                 Reductions                                  *
+*******************************************************************************/
+
+namespace detail {
+
+/// Pointers and `std::vector` iterators of arithmetic types
+template<class TIt, class TValue = TIteratorValueT<TIt>, bool = std::is_arithmetic_v<TValue> && !std::is_same_v<TValue, bool>>
+inline constexpr bool IsContiguousIterator = std::is_pointer_v<TIt>;
+
+template<class TIt, class TValue>
+inline constexpr bool IsContiguousIterator<TIt, TValue, true> =
+  std::is_pointer_v<TIt>
+  || std::is_same_v<TIt, typename std::vector<TValue>::iterator>
+  || std::is_same_v<TIt, typename std::vector<TValue>::const_iterator>;
+
+struct TIdentityTransform {
+  template<class T>
+  constexpr const T& operator()(const T& x) const {
+    return x;
+  }
+};
+
+struct TAlwaysTrue {
+  template<class T>
+  constexpr bool operator()(const T&) const {
+    return true;
+  }
+};
+
+/// Splits `Filter*(Map*(source))` over contiguous memory into the memory
+/// (`Source`), the composition of the maps (`Transform`) and the conjunction
+/// of the filters applied to the transformed value (`Predicate`), so that
+/// terminals run one flat loop over an array. A `Map` over a `Filter` is not
+/// lowered: its function would run on the rejected elements as well.
+template<class TRange, class>
+struct TLowering {
+  static constexpr bool is_lowered = false;
+};
+
+template<class TRange>
+struct TLowering<TRange, std::enable_if_t<IsContiguous<TRange>>> {
+  static constexpr bool is_lowered = true;
+  static constexpr bool is_filtered = false;
+  using TElement = std::remove_cv_t<std::remove_pointer_t<decltype(std::data(std::declval<const TRange&>()))>>;
+
+  static TSpan<const TElement> Source(const TRange& r) {
+    return {std::data(r), std::size(r)};
+  }
+
+  static TIdentityTransform Transform(const TRange&) {
+    return {};
+  }
+
+  static TAlwaysTrue Predicate(const TRange&) {
+    return {};
+  }
+};
+
+template<class TIt>
+struct TLowering<TRangeView<TIt, TIt>, std::enable_if_t<IsContiguousIterator<TIt>>> {
+  static constexpr bool is_lowered = true;
+  static constexpr bool is_filtered = false;
+  using TElement = TIteratorValueT<TIt>;
+
+  static TSpan<const TElement> Source(const TRangeView<TIt, TIt>& r) {
+    if (r.begin() == r.end()) {
+      return {};
+    }
+    return {&*r.begin(), r.size()};
+  }
+
+  static TIdentityTransform Transform(const TRangeView<TIt, TIt>&) {
+    return {};
+  }
+
+  static TAlwaysTrue Predicate(const TRangeView<TIt, TIt>&) {
+    return {};
+  }
+};
+
+template<class TNestedView, class Fn>
+struct TLowering<
+  TMappedView<TNestedView, Fn>,
+  std::enable_if_t<TLowering<TNestedView>::is_lowered && !TLowering<TNestedView>::is_filtered>
+> {
+  using TNested = TLowering<TNestedView>;
+  static constexpr bool is_lowered = true;
+  static constexpr bool is_filtered = false;
+  using TElement = typename TNested::TElement;
+
+  static auto Source(const TMappedView<TNestedView, Fn>& r) {
+    return TNested::Source(r.NestedView);
+  }
+
+  static auto Transform(const TMappedView<TNestedView, Fn>& r) {
+    return [inner = TNested::Transform(r.NestedView), &mapper = r.Mapper](const TElement& x) {
+      return mapper(inner(x));
+    };
+  }
+
+  static TAlwaysTrue Predicate(const TMappedView<TNestedView, Fn>&) {
+    return {};
+  }
+};
+
+template<class TNestedView, class Fn>
+struct TLowering<TFilteredView<TNestedView, Fn>, std::enable_if_t<TLowering<TNestedView>::is_lowered>> {
+  using TNested = TLowering<TNestedView>;
+  static constexpr bool is_lowered = true;
+  static constexpr bool is_filtered = true;
+  using TElement = typename TNested::TElement;
+
+  static auto Source(const TFilteredView<TNestedView, Fn>& r) {
+    return TNested::Source(r.NestedView);
+  }
+
+  static auto Transform(const TFilteredView<TNestedView, Fn>& r) {
+    return TNested::Transform(r.NestedView);
+  }
+
+  static auto Predicate(const TFilteredView<TNestedView, Fn>& r) {
+    return [inner = TNested::Predicate(r.NestedView), &filter = r.Filter](const auto& x) {
+      return inner(x) && static_cast<bool>(filter(x));
+    };
+  }
+};
+
+/// The unrolled kernels below only pay off for arithmetic elements
+template<class TRange>
+inline constexpr bool IsArithmeticLowering =
+  TLowering<TRange>::is_lowered && std::is_arithmetic_v<typename TRangeTraits<TRange>::value_type>;
+
+/// Independent accumulators of the unrolled loops: enough to hide the latency
+/// of a floating-point addition and for the compiler to fill a vector register
+inline constexpr std::size_t REDUCE_LANES = 8;
+
+/// Calls `fn(lane, value, keep)` for the elements of the lowered range
+/// starting from `first`, where `keep` tells whether the filters accept the
+/// value. Elements go round-robin over `REDUCE_LANES` lanes in unrolled
+/// steps, the tail goes to lane zero.
+template<class TRange, class Fn>
+void ForEachLowered(const TRange& r, std::size_t first, Fn&& fn) {
+  using TValue = typename TRangeTraits<TRange>::value_type;
+  const auto source = TLowering<TRange>::Source(r);
+  const auto transform = TLowering<TRange>::Transform(r);
+  const auto predicate = TLowering<TRange>::Predicate(r);
+  const auto* data = source.data();
+  const auto size = source.size();
+  auto i = first;
+  for (; i + REDUCE_LANES <= size; i += REDUCE_LANES) {
+    for (std::size_t lane = 0; lane < REDUCE_LANES; lane++) {
+      const TValue value = transform(data[i + lane]);
+      fn(lane, value, predicate(value));
+    }
+  }
+  for (; i < size; i++) {
+    const TValue value = transform(data[i]);
+    fn(0, value, predicate(value));
+  }
+}
+
+/// Arithmetic sums are computed in the promoted type, so `char`s add up as
+/// `int`s
+template<class T>
+using TSumT = std::conditional_t<std::is_arithmetic_v<T>, decltype(std::declval<T>() + std::declval<T>()), T>;
+
+}  // namespace utils::detail
+
+/// Sum of the elements, `T{}` for an empty range. Views over contiguous
+/// arithmetic data are summed in `detail::REDUCE_LANES` interleaved partial
+/// sums, so floating-point results may differ from a sequential loop in the
+/// last bits.
+template<class TRange>
+auto Sum(const TRange& r) {
+  using TSum = detail::TSumT<typename detail::TRangeTraits<TRange>::value_type>;
+  const auto view = MakeView(r);
+  using TView = std::decay_t<decltype(view)>;
+  if constexpr (detail::IsArithmeticLowering<TView>) {
+    TSum lanes[detail::REDUCE_LANES] = {};
+    detail::ForEachLowered(view, 0, [&lanes](std::size_t lane, auto value, bool keep) {
+      lanes[lane] += keep ? static_cast<TSum>(value) : TSum{};
+    });
+    TSum sum{};
+    for (const auto lane : lanes) {
+      sum += lane;
+    }
+    return sum;
+  } else {
+    TSum sum{};
+    detail::PushEach(view, [&sum](auto&& x) {
+      sum += x;
+      return true;
+    });
+    return sum;
+  }
+}
+
+template<class T>
+struct TMinMax {
+  T Min;
+  T Max;
+};
+
+/// The smallest and the largest element (the first ones among equal), or
+/// nothing for an empty range. The result is unspecified if there are NaNs.
+template<class TRange>
+auto MinMax(const TRange& r) {
+  using TValue = typename detail::TRangeTraits<TRange>::value_type;
+  std::optional<TMinMax<TValue>> result;
+  const auto view = MakeView(r);
+  using TView = std::decay_t<decltype(view)>;
+  if constexpr (detail::IsArithmeticLowering<TView>) {
+    // the first accepted element seeds all lanes, the rest is branch-free
+    const auto source = detail::TLowering<TView>::Source(view);
+    const auto transform = detail::TLowering<TView>::Transform(view);
+    const auto predicate = detail::TLowering<TView>::Predicate(view);
+    std::size_t first = 0;
+    for (; first < source.size(); first++) {
+      const TValue value = transform(source[first]);
+      if (predicate(value)) {
+        result.emplace(TMinMax<TValue>{value, value});
+        break;
+      }
+    }
+    if (!result) {
+      return result;
+    }
+    TValue mins[detail::REDUCE_LANES];
+    TValue maxs[detail::REDUCE_LANES];
+    std::fill(std::begin(mins), std::end(mins), result->Min);
+    std::fill(std::begin(maxs), std::end(maxs), result->Max);
+    detail::ForEachLowered(view, first + 1, [&mins, &maxs](std::size_t lane, TValue value, bool keep) {
+      mins[lane] = keep && value < mins[lane] ? value : mins[lane];
+      maxs[lane] = keep && maxs[lane] < value ? value : maxs[lane];
+    });
+    for (std::size_t lane = 0; lane < detail::REDUCE_LANES; lane++) {
+      result->Min = std::min(result->Min, mins[lane]);
+      result->Max = std::max(result->Max, maxs[lane]);
+    }
+  } else {
+    detail::PushEach(view, [&result](auto&& x) {
+      if (!result) {
+        result.emplace(TMinMax<TValue>{x, x});
+      } else if (x < result->Min) {
+        result->Min = x;
+      } else if (result->Max < x) {
+        result->Max = x;
+      }
+      return true;
+    });
+  }
+  return result;
+}
+
+/// Number of elements, without iterating when the range is sized
+template<class TRange>
+std::size_t Count(const TRange& r) {
+  const auto view = MakeView(r);
+  using TView = std::decay_t<decltype(view)>;
+  if constexpr (detail::TRangeTraits<TView>::is_sized) {
+    return detail::RangeSize(view);
+  } else if constexpr (detail::IsArithmeticLowering<TView>) {
+    std::size_t lanes[detail::REDUCE_LANES] = {};
+    detail::ForEachLowered(view, 0, [&lanes](std::size_t lane, const auto&, bool keep) {
+      lanes[lane] += keep;
+    });
+    std::size_t count = 0;
+    for (const auto lane : lanes) {
+      count += lane;
+    }
+    return count;
+  } else {
+    std::size_t count = 0;
+    detail::PushEach(view, [&count](auto&&) {
+      count++;
+      return true;
+    });
+    return count;
+  }
+}
+
+template<class TRange, class Fn>
+std::size_t CountIf(const TRange& r, Fn predicate) {
+  return Count(Filter(r, predicate));
+}
+
+/// Left fold of the elements with `op(T, element)`, in order
+template<class TRange, class T, class Op>
+T Reduce(const TRange& r, T init, Op op) {
+  const auto view = MakeView(r);
+  using TView = std::decay_t<decltype(view)>;
+  if constexpr (detail::TLowering<TView>::is_lowered) {
+    const auto source = detail::TLowering<TView>::Source(view);
+    const auto transform = detail::TLowering<TView>::Transform(view);
+    const auto predicate = detail::TLowering<TView>::Predicate(view);
+    for (const auto& x : source) {
+      auto&& value = transform(x);
+      if (predicate(value)) {
+        init = op(std::move(init), std::forward<decltype(value)>(value));
+      }
+    }
+  } else {
+    detail::PushEach(view, [&init, &op](auto&& x) {
+      init = op(std::move(init), std::forward<decltype(x)>(x));
+      return true;
+    });
+  }
+  return init;
+}
+
+/// Whether `predicate` holds for some element. Views over contiguous
+/// arithmetic data are checked `detail::REDUCE_LANES` elements at a time, so
+/// `predicate` may be called on a few elements past the first match.
+template<class TRange, class Fn>
+bool Any(const TRange& r, Fn predicate) {
+  const auto view = MakeView(r);
+  using TView = std::decay_t<decltype(view)>;
+  if constexpr (detail::IsArithmeticLowering<TView>) {
+    using TValue = typename detail::TRangeTraits<TView>::value_type;
+    const auto source = detail::TLowering<TView>::Source(view);
+    const auto transform = detail::TLowering<TView>::Transform(view);
+    const auto filter = detail::TLowering<TView>::Predicate(view);
+    std::size_t i = 0;
+    for (; i + detail::REDUCE_LANES <= source.size(); i += detail::REDUCE_LANES) {
+      bool found = false;
+      for (std::size_t lane = 0; lane < detail::REDUCE_LANES; lane++) {
+        const TValue value = transform(source[i + lane]);
+        found |= filter(value) && static_cast<bool>(predicate(value));
+      }
+      if (found) {
+        return true;
+      }
+    }
+    for (; i < source.size(); i++) {
+      const TValue value = transform(source[i]);
+      if (filter(value) && predicate(value)) {
+        return true;
+      }
+    }
+    return false;
+  } else {
+    return !detail::PushEach(view, [&predicate](auto&& x) { return !predicate(x); });
+  }
+}
+
+/// Whether `predicate` holds for every element, true for an empty range
+template<class TRange, class Fn>
+bool All(const TRange& r, Fn predicate) {
+  return !Any(r, [&predicate](const auto& x) { return !predicate(x); });
+}
+
+/// Pipe forms of the terminals: `r | Map(f) | Sum()`
+inline auto ToVector() {
+  return detail::TPipeClosure{[](const auto& r) { return ToVector(r); }};
+}
+
+template<class Fn>
+auto ForEach(Fn fn) {
+  return detail::TPipeClosure{[fn](const auto& r) { ForEach(r, fn); }};
+}
+
+inline auto Sum() {
+  return detail::TPipeClosure{[](const auto& r) { return Sum(r); }};
+}
+
+inline auto MinMax() {
+  return detail::TPipeClosure{[](const auto& r) { return MinMax(r); }};
+}
+
+inline auto Count() {
+  return detail::TPipeClosure{[](const auto& r) { return Count(r); }};
+}
+
+template<class Fn>
+auto CountIf(Fn predicate) {
+  return detail::TPipeClosure{[predicate](const auto& r) { return CountIf(r, predicate); }};
+}
+
+template<class T, class Op>
+auto Reduce(T init, Op op) {
+  return detail::TPipeClosure{[init, op](const auto& r) { return Reduce(r, init, op); }};
+}
+
+template<class Fn>
+auto Any(Fn predicate) {
+  return detail::TPipeClosure{[predicate](const auto& r) { return Any(r, predicate); }};
+}
+
+template<class Fn>
+auto All(Fn predicate) {
+  return detail::TPipeClosure{[predicate](const auto& r) { return All(r, predicate); }};
 }
 
 }  // namespace utils
@@ -1,138 +1,709 @@
 #pragma once
 
+#include <cpputils/common.hh>
 #include <cpputils/debug.hh>
+#include <cpputils/parallel.hh>
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
+#include <optional>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace utils {
 
 namespace gf2 {
 
-uint64_t mul8x8 (uint64_t A, uint64_t B) {
-    // https://stackoverflow.com/a/55307540
-
-    static const uint64_t ROW = 0x00000000000000FF;  // lowest row
-    static const uint64_t COL = 0x0101010101010101;  // rightmost column
-
-    uint64_t C = 0;
-
-    // TODO: according to godbolt, unroll pragma should unroll all of this
-    for (int i=0; i<8; ++i) {
-        uint64_t p = COL & (A>>i);
-        uint64_t r = ROW & (B>>i*8);
-        C ^= (p*r);
-    }
-    return C;
+/*******************************************************************************
+*                                   Blocks                                    *
+*******************************************************************************/
+
+/// Square bit matrices packed row by row: bit `c` of row `r` is bit
+/// `r * DIM + c` of the data. Addition is XOR, multiplication is the matrix
+/// product over GF(2).
+
+inline u64 mul8x8(u64 A, u64 B) {
+  // https://stackoverflow.com/a/55307540
+  constexpr u64 ROW = 0x00000000000000FF;  // lowest row
+  constexpr u64 COL = 0x0101010101010101;  // rightmost column
+
+  u64 C = 0;
+  for (int i = 0; i < 8; ++i) {
+    const u64 p = COL & (A >> i);
+    const u64 r = ROW & (B >> i * 8);
+    C ^= p * r;
+  }
+  return C;
 }
 
-uint16_t mul4x4 (uint16_t A, uint16_t B) {
-    static const uint16_t ROW = 0x000F;  // lowest row
-    static const uint16_t COL = 0x1111;  // rightmost column
-
-    uint16_t C = 0;
+inline uint16_t mul4x4(uint16_t A, uint16_t B) {
+  constexpr uint16_t ROW = 0x000F;  // lowest row
+  constexpr uint16_t COL = 0x1111;  // rightmost column
+
+  uint16_t C = 0;
+  for (int i = 0; i < 4; ++i) {
+    const auto p = static_cast<uint16_t>(COL & (A >> i));
+    const auto r = static_cast<uint16_t>(ROW & (B >> i * 4));
+    C ^= static_cast<uint16_t>(p * r);
+  }
+  return C;
+}
 
-    for (int i = 0; i < 4; ++i) {
-        uint16_t p = COL & (A>>i);
-        uint16_t r = ROW & (B>>i*4);
-        C ^= (p*r);
-    }
-    return C;
+/// Swaps the off-diagonal 4x4, 2x2 and 1x1 sub-blocks in three steps
+inline u64 transpose8x8(u64 A) {
+  u64 t = (A ^ (A >> 7)) & 0x00AA00AA00AA00AAull;
+  A ^= t ^ (t << 7);
+  t = (A ^ (A >> 14)) & 0x0000CCCC0000CCCCull;
+  A ^= t ^ (t << 14);
+  t = (A ^ (A >> 28)) & 0x00000000F0F0F0F0ull;
+  A ^= t ^ (t << 28);
+  return A;
 }
 
-uint64_t transpose8x8(uint64_t A) {
-    uint64_t C = 0;
-    for (int i = 0; i < 8; ++i) {
-        C |= (A & (0x0101010101010101ull << (i*8))) >> (i*8);
-    }
-    return C;
+inline uint16_t transpose4x4(uint16_t A) {
+  uint16_t t = (A ^ (A >> 3)) & 0x0A0A;
+  A ^= static_cast<uint16_t>(t ^ (t << 3));
+  t = (A ^ (A >> 6)) & 0x00CC;
+  A ^= static_cast<uint16_t>(t ^ (t << 6));
+  return A;
 }
 
 struct T4x4 {
+  static constexpr std::size_t DIM = 4;
+  using TData = uint16_t;
 
-    static T4x4 mul(T4x4 A, T4x4 B) {
-        return T4x4{mul4x4(A.data, B.data)};
-    }
+  static T4x4 mul(T4x4 A, T4x4 B) {
+    return T4x4{mul4x4(A.data, B.data)};
+  }
 
-    static T4x4 add(T4x4 A, T4x4 B) {
-        return T4x4{static_cast<uint16_t>(A.data ^ B.data)};
-    }
+  static T4x4 add(T4x4 A, T4x4 B) {
+    return T4x4{static_cast<uint16_t>(A.data ^ B.data)};
+  }
 
-    static T4x4 zero() {
-        return T4x4{};
-    }
+  static T4x4 zero() {
+    return T4x4{};
+  }
 
-    static T4x4 all_ones() {
-        return T4x4{0xFFFF};
-    }
+  static T4x4 all_ones() {
+    return T4x4{0xFFFF};
+  }
+
+  static T4x4 transpose(T4x4 A) {
+    return T4x4{transpose4x4(A.data)};
+  }
 
-    uint16_t data{0};
+  uint16_t data{0};
 };
 
 struct T8x8 {
+  static constexpr std::size_t DIM = 8;
+  using TData = u64;
 
-    static T8x8 mul(T8x8 A, T8x8 B) {
-        return T8x8{mul8x8(A.data, B.data)};
-    }
+  static T8x8 mul(T8x8 A, T8x8 B) {
+    return T8x8{mul8x8(A.data, B.data)};
+  }
 
-    static T8x8 add(T8x8 A, T8x8 B) {
-        return T8x8{A.data ^ B.data};
-    }
+  static T8x8 add(T8x8 A, T8x8 B) {
+    return T8x8{A.data ^ B.data};
+  }
 
-    static T8x8 zero() {
-        return T8x8{};
-    }
+  static T8x8 zero() {
+    return T8x8{};
+  }
 
-    static T8x8 all_ones() {
-        return T8x8{0xFFFFFFFFFFFFFFFFull};
-    }
+  static T8x8 all_ones() {
+    return T8x8{0xFFFFFFFFFFFFFFFFull};
+  }
 
-    static T8x8 transpose(T8x8 A) {
+  static T8x8 transpose(T8x8 A) {
+    return T8x8{transpose8x8(A.data)};
+  }
 
-    }
+  u64 data{0};
+};
+
+/*******************************************************************************
+*                               Block kernels                                 *
+*******************************************************************************/
+
+namespace detail {
+
+enum class EGf2Kernel {
+  Scalar,
+  Avx2,  // 4 blocks per step, rows of `b` selected with vpshufb
+  Gfni,  // 4 blocks per step, a product is one vgf2p8affineqb
+};
+
+/// Batched operations on arrays of 8x8 blocks (`T8x8::data`). All kernels
+/// return the same bits.
+struct TGf2Kernels {
+  /// c[i] = a[i] * b[i]
+  void (*Mul)(const u64* a, const u64* b, u64* c, std::size_t count);
+  /// c[i] ^= a[i] * b
+  void (*MulAddConst)(const u64* a, u64 b, u64* c, std::size_t count);
+  /// out[i] = transpose(in[i]), `in` and `out` may be the same array
+  void (*Transpose)(const u64* in, u64* out, std::size_t count);
+};
+
+bool IsKernelSupported(EGf2Kernel kernel);
+
+const TGf2Kernels& GetGf2Kernels(EGf2Kernel kernel);
+
+/// The best kernels supported by the CPU
+const TGf2Kernels& GetGf2Kernels();
+
+/// Whether `MulBlocks` beats `MulAddM4rm` with the kernels of this CPU
+bool PreferBlockMul();
+
+/// `c = a * b` for row-major grids of `n x m` and `m x p` blocks, as sums
+/// of block products computed by `kernels.MulAddConst`
+void MulBlocks(
+  const TGf2Kernels& kernels,
+  const T8x8* a,
+  const T8x8* b,
+  T8x8* c,
+  std::size_t n,
+  std::size_t m,
+  std::size_t p
+);
+
+/*******************************************************************************
+*                                 Bit rows                                    *
+*******************************************************************************/
+
+/// Row-major bit matrix with every row padded to whole words, the layout of
+/// the row-oriented algorithms (multiplication, elimination)
+struct TBitRows {
+  TBitRows(std::size_t rows, std::size_t words) : Rows{rows}, Words{words}, Data(rows * words) {}
+
+  u64* Row(std::size_t i) {
+    return Data.data() + i * Words;
+  }
 
-    uint64_t data{0};
+  const u64* Row(std::size_t i) const {
+    return Data.data() + i * Words;
+  }
+
+  std::size_t Rows;
+  std::size_t Words;
+  std::vector<u64> Data;
 };
 
+/// Bits of `b` combined per table: tables of 2^8 rows are built in 256 row
+/// XORs and each of them replaces 8 row XORs
+inline constexpr std::size_t M4RM_BITS = 8;
+/// One table per byte of a word of `a`, so that a row of `c` is updated
+/// once per 64 bits of `a`
+inline constexpr std::size_t M4RM_TABLES = 64 / M4RM_BITS;
+/// Words of a table row: 8 tables of 256 rows of 8 words take 128 KiB,
+/// which stays in L2 while the rows of `a` stream by
+inline constexpr std::size_t M4RM_TILE_WORDS = 8;
+/// Rows of `c` updated per set of tables: 2048 rows of a tile are 128 KiB
+/// too, and rebuilding the tables for every chunk costs about a tenth of
+/// using them
+inline constexpr std::size_t M4RM_ROW_CHUNK = 2048;
+
+/// `c += a * b` over the rows `[rowBegin, rowEnd)` and the words
+/// `[wordBegin, wordEnd)` of `c` with the Method of Four Russians: for every
+/// byte of `a`'s columns, all 256 combinations of the corresponding 8 rows of
+/// `b` are precomputed in Gray code order (one row XOR each), and every row
+/// of `c` takes one table row per byte instead of eight rows of `b`.
+/// Rows of `b` past its end count as zero.
+void MulAddM4rm(
+  const TBitRows& a,
+  const TBitRows& b,
+  TBitRows& c,
+  std::size_t rowBegin,
+  std::size_t rowEnd,
+  std::size_t wordBegin,
+  std::size_t wordEnd
+);
+
+/// `MulBlocks` with the blocks of `c` split into tiles and computed on
+/// `pool` (`GetThreadPool()` if null)
+void ParallelMulBlocks(
+  const TGf2Kernels& kernels,
+  const T8x8* a,
+  const T8x8* b,
+  T8x8* c,
+  std::size_t n,
+  std::size_t m,
+  std::size_t p,
+  TThreadPool* pool
+);
+
+/// `c += a * b` with `MulAddM4rm` on tiles of rows and words of `c` computed
+/// on `pool` (`GetThreadPool()` if null)
+void ParallelMulAddM4rm(const TBitRows& a, const TBitRows& b, TBitRows& c, TThreadPool* pool);
+
+}  // namespace utils::gf2::detail
+
+/*******************************************************************************
+*                                  TMatrix                                    *
+*******************************************************************************/
+
+/// Dense GF(2) matrix of any size stored as a row-major grid of blocks. The
+/// bits of the edge blocks outside of the matrix are always zero, so that
+/// whole blocks can be added and multiplied without masking.
 template<class TBlock>
-struct TMatrix {
-    // TODO: rows -> blockRows, cols -> blockCols, cut out the unused rightmost and bottommost bits with appropriate masks!!!
-
-    TMatrix& operator*=(const TMatrix& other) {
-        // inplace multiplication can be only done if `other` is square
-        EXPECT(cols == other.rows, Format("Incompatible matrices: lhs.cols = %, rhs.rows = %", cols, other.cols));
-        EXPECT(other.IsSquare(), Format("rhs must be square, but the shape is (%, %)", other.rows, other.cols));
-        // TODO: the algorithm is incorrect yet! Because rows and cols are about the blocks, not about actual matrix size
-        assert (cols == other.rows);
-        for (uint64_t i = 0; i < rows; i++) {
-            for (uint64_t j = 0; j < cols; j++) {
-                TBlock C = TBlock::zero();
-                for (uint64_t k = 0; k < cols; k++) {
-                    C = TBlock::add(C, TBlock::mul(blocks[i][k], other.blocks[k][j]));
-                }
-                blocks[i * cols + j] = C;
-            }
+class TMatrix {
+public:
+  static constexpr std::size_t BLOCK_DIM = TBlock::DIM;
+
+  TMatrix() = default;
+
+  /// Zero matrix
+  TMatrix(std::size_t rows, std::size_t cols)
+    : RowCount{rows}
+    , ColCount{cols}
+    , BlockRowCount{(rows + BLOCK_DIM - 1) / BLOCK_DIM}
+    , BlockColCount{(cols + BLOCK_DIM - 1) / BLOCK_DIM}
+    , Blocks(BlockRowCount * BlockColCount, TBlock::zero())
+  {}
+
+  static TMatrix Identity(std::size_t size) {
+    TMatrix result(size, size);
+    for (std::size_t i = 0; i < size; i++) {
+      result.Set(i, i, true);
+    }
+    return result;
+  }
+
+  std::size_t Rows() const {
+    return RowCount;
+  }
+
+  std::size_t Cols() const {
+    return ColCount;
+  }
+
+  std::size_t BlockRows() const {
+    return BlockRowCount;
+  }
+
+  std::size_t BlockCols() const {
+    return BlockColCount;
+  }
+
+  bool IsSquare() const {
+    return RowCount == ColCount;
+  }
+
+  bool Get(std::size_t row, std::size_t col) const {
+    return (Block(row / BLOCK_DIM, col / BLOCK_DIM).data >> BitIndex(row, col)) & 1;
+  }
+
+  void Set(std::size_t row, std::size_t col, bool value) {
+    EXPECT(row < RowCount && col < ColCount, Format(FMT("Bit (%, %) is out of the matrix"), row, col));
+    auto& data = Block(row / BLOCK_DIM, col / BLOCK_DIM).data;
+    const auto bit = static_cast<typename TBlock::TData>(typename TBlock::TData{1} << BitIndex(row, col));
+    data = static_cast<typename TBlock::TData>(value ? data | bit : data & ~bit);
+  }
+
+  /// Blocks at the right and bottom edges must keep the bits outside of the
+  /// matrix zero
+  TBlock& Block(std::size_t blockRow, std::size_t blockCol) {
+    return Blocks[blockRow * BlockColCount + blockCol];
+  }
+
+  const TBlock& Block(std::size_t blockRow, std::size_t blockCol) const {
+    return Blocks[blockRow * BlockColCount + blockCol];
+  }
+
+  TMatrix& operator^=(const TMatrix& other) {
+    return Elementwise(other, [](auto a, auto b) { return a ^ b; });
+  }
+
+  TMatrix& operator&=(const TMatrix& other) {
+    return Elementwise(other, [](auto a, auto b) { return a & b; });
+  }
+
+  TMatrix& operator|=(const TMatrix& other) {
+    return Elementwise(other, [](auto a, auto b) { return a | b; });
+  }
+
+  /// `other` doesn't have to be square, the shape becomes `(Rows(), other.Cols())`
+  TMatrix& operator*=(const TMatrix& other) {
+    return *this = *this * other;
+  }
+
+  friend TMatrix operator^(TMatrix a, const TMatrix& b) {
+    return a ^= b;
+  }
+
+  friend TMatrix operator&(TMatrix a, const TMatrix& b) {
+    return a &= b;
+  }
+
+  friend TMatrix operator|(TMatrix a, const TMatrix& b) {
+    return a |= b;
+  }
+
+  friend TMatrix operator*(const TMatrix& a, const TMatrix& b) {
+    EXPECT(
+      a.ColCount == b.RowCount,
+      Format(FMT("Incompatible matrices: (%, %) * (%, %)"), a.RowCount, a.ColCount, b.RowCount, b.ColCount)
+    );
+    if constexpr (std::is_same_v<TBlock, T8x8>) {
+      if (detail::PreferBlockMul()) {
+        TMatrix result(a.RowCount, b.ColCount);
+        detail::MulBlocks(
+          detail::GetGf2Kernels(), a.Blocks.data(), b.Blocks.data(), result.Blocks.data(),
+          a.BlockRowCount, a.BlockColCount, b.BlockColCount
+        );
+        return result;
+      }
+    }
+    const auto rowsA = a.ToBitRows();
+    const auto rowsB = b.ToBitRows();
+    detail::TBitRows rowsC(rowsA.Rows, rowsB.Words);
+    detail::MulAddM4rm(rowsA, rowsB, rowsC, 0, rowsC.Rows, 0, rowsC.Words);
+    TMatrix result(a.RowCount, b.ColCount);
+    result.FromBitRows(rowsC);
+    return result;
+  }
+
+  friend bool operator==(const TMatrix& a, const TMatrix& b) {
+    return a.RowCount == b.RowCount && a.ColCount == b.ColCount && std::equal(
+      a.Blocks.begin(), a.Blocks.end(), b.Blocks.begin(),
+      [](TBlock x, TBlock y) { return x.data == y.data; }
+    );
+  }
+
+  friend bool operator!=(const TMatrix& a, const TMatrix& b) {
+    return !(a == b);
+  }
+
+  /// Rows padded to whole blocks, the columns of a block are `BLOCK_DIM`
+  /// consecutive bits of a word
+  detail::TBitRows ToBitRows() const {
+    detail::TBitRows result(BlockRowCount * BLOCK_DIM, (BlockColCount * BLOCK_DIM + 63) / 64);
+    for (std::size_t bi = 0; bi < BlockRowCount; bi++) {
+      for (std::size_t bj = 0; bj < BlockColCount; bj++) {
+        const u64 data = Block(bi, bj).data;
+        const auto word = bj * BLOCK_DIM / 64;
+        const auto shift = bj * BLOCK_DIM % 64;
+        for (std::size_t r = 0; r < BLOCK_DIM; r++) {
+          result.Row(bi * BLOCK_DIM + r)[word] |= ((data >> (r * BLOCK_DIM)) & ROW_MASK) << shift;
         }
-        return *this;
+      }
+    }
+    return result;
+  }
+
+  /// The inverse of `ToBitRows`, `rows` must have zero bits outside of the
+  /// matrix
+  void FromBitRows(const detail::TBitRows& rows) {
+    for (std::size_t bi = 0; bi < BlockRowCount; bi++) {
+      for (std::size_t bj = 0; bj < BlockColCount; bj++) {
+        const auto word = bj * BLOCK_DIM / 64;
+        const auto shift = bj * BLOCK_DIM % 64;
+        u64 data = 0;
+        for (std::size_t r = 0; r < BLOCK_DIM; r++) {
+          data |= ((rows.Row(bi * BLOCK_DIM + r)[word] >> shift) & ROW_MASK) << (r * BLOCK_DIM);
+        }
+        Block(bi, bj).data = static_cast<typename TBlock::TData>(data);
+      }
+    }
+  }
+
+private:
+  static constexpr u64 ROW_MASK = (u64{1} << BLOCK_DIM) - 1;
+
+  static std::size_t BitIndex(std::size_t row, std::size_t col) {
+    return row % BLOCK_DIM * BLOCK_DIM + col % BLOCK_DIM;
+  }
+
+  template<class Op>
+  TMatrix& Elementwise(const TMatrix& other, Op op) {
+    EXPECT(
+      RowCount == other.RowCount && ColCount == other.ColCount,
+      Format(FMT("Shapes differ: (%, %) and (%, %)"), RowCount, ColCount, other.RowCount, other.ColCount)
+    );
+    for (std::size_t i = 0; i < Blocks.size(); i++) {
+      Blocks[i].data = static_cast<typename TBlock::TData>(op(Blocks[i].data, other.Blocks[i].data));
     }
+    return *this;
+  }
+
+  std::size_t RowCount{0};
+  std::size_t ColCount{0};
+  std::size_t BlockRowCount{0};
+  std::size_t BlockColCount{0};
+  std::vector<TBlock> Blocks;
+};
 
-    TMatrix& operator^=(const TMatrix& other) {
+using TMatrix64bit = TMatrix<T8x8>;
+using TMatrix16bit = TMatrix<T4x4>;
+
+/*******************************************************************************
+*                                Elimination                                  *
+*******************************************************************************/
+
+namespace detail {
+
+/// Brings the first `cols` columns of `rows` to row echelon form with row
+/// swaps and word-parallel row XORs, the other columns follow along. With
+/// `reduced` the pivot columns are cleared above the pivots too. Large
+/// matrices are eliminated 8 columns at a time with the Method of Four
+/// Russians (M4RI): the 2^8 combinations of the pivot rows are tabulated and
+/// every other row takes one table row.
+/// Returns the pivot columns: pivot `i` is the first set bit of row `i`.
+std::vector<std::size_t> Eliminate(TBitRows& rows, std::size_t cols, bool reduced);
+
+/// Right-hand sides up to this many columns are solved by back substitution
+/// from the row echelon form, which saves clearing above the pivots
+inline constexpr std::size_t BACK_SUBSTITUTION_COLS = 64;
+
+/// Sets the rows `pivots[t]` of `x` to the solutions of the system in row
+/// echelon form `rows`, whose `cols` right-hand sides start at the word
+/// `split`
+void BackSubstitute(
+  const TBitRows& rows,
+  const std::vector<std::size_t>& pivots,
+  std::size_t split,
+  std::size_t cols,
+  TBitRows& x
+);
+
+/// Words taken by the columns of `m` in `ToBitRows`
+template<class TBlock>
+std::size_t RowWords(const TMatrix<TBlock>& m) {
+  return (m.BlockCols() * TBlock::DIM + 63) / 64;
+}
+
+/// `[a | b]`, the columns of `b` start at the word `RowWords(a)`
+template<class TBlock>
+TBitRows Augment(const TMatrix<TBlock>& a, const TMatrix<TBlock>& b) {
+  const auto left = a.ToBitRows();
+  const auto right = b.ToBitRows();
+  TBitRows result(left.Rows, left.Words + right.Words);
+  for (std::size_t i = 0; i < result.Rows; i++) {
+    std::copy(left.Row(i), left.Row(i) + left.Words, result.Row(i));
+    std::copy(right.Row(i), right.Row(i) + right.Words, result.Row(i) + left.Words);
+  }
+  return result;
+}
+
+}  // namespace utils::gf2::detail
+
+/// Number of linearly independent rows (and columns)
+template<class TBlock>
+std::size_t Rank(const TMatrix<TBlock>& a) {
+  auto rows = a.ToBitRows();
+  return detail::Eliminate(rows, a.Cols(), false).size();
+}
+
+/// Reduced row echelon form: the first set bit of every nonzero row is the
+/// only one in its column, and the zero rows are at the bottom
+template<class TBlock>
+TMatrix<TBlock> ReducedRowEchelon(const TMatrix<TBlock>& a) {
+  auto rows = a.ToBitRows();
+  detail::Eliminate(rows, a.Cols(), true);
+  TMatrix<TBlock> result(a.Rows(), a.Cols());
+  result.FromBitRows(rows);
+  return result;
+}
+
+/// A solution of `a * x = b` with the free variables set to zero, or nothing
+/// if there is none. Every column of `b` is a separate right-hand side.
+template<class TBlock>
+std::optional<TMatrix<TBlock>> Solve(const TMatrix<TBlock>& a, const TMatrix<TBlock>& b) {
+  EXPECT(
+    a.Rows() == b.Rows(),
+    Format(FMT("Incompatible system: (%, %) * x = (%, %)"), a.Rows(), a.Cols(), b.Rows(), b.Cols())
+  );
+  auto rows = detail::Augment(a, b);
+  const auto split = detail::RowWords(a);
+  const bool backSubstitute = b.Cols() <= detail::BACK_SUBSTITUTION_COLS;
+  const auto pivots = detail::Eliminate(rows, a.Cols(), !backSubstitute);
+  for (auto r = pivots.size(); r < rows.Rows; r++) {
+    if (std::any_of(rows.Row(r) + split, rows.Row(r) + rows.Words, [](u64 w) { return w != 0; })) {
+      return std::nullopt;
+    }
+  }
+  TMatrix<TBlock> result(a.Cols(), b.Cols());
+  detail::TBitRows x(result.BlockRows() * TBlock::DIM, rows.Words - split);
+  if (backSubstitute) {
+    detail::BackSubstitute(rows, pivots, split, b.Cols(), x);
+  } else {
+    for (std::size_t t = 0; t < pivots.size(); t++) {
+      std::copy(rows.Row(t) + split, rows.Row(t) + rows.Words, x.Row(pivots[t]));
     }
+  }
+  result.FromBitRows(x);
+  return result;
+}
 
-    // TODO: add only ^, | and &, no other operations are allowed
+/// Nothing if `a` is singular
+template<class TBlock>
+std::optional<TMatrix<TBlock>> Inverse(const TMatrix<TBlock>& a) {
+  EXPECT(a.IsSquare(), Format(FMT("Inverse of a non-square matrix: (%, %)"), a.Rows(), a.Cols()));
+  // a * x = I has no solution for a singular `a`
+  return Solve(a, TMatrix<TBlock>::Identity(a.Rows()));
+}
 
-    friend TMatrix operator*(const TMatrix& A, const TMatrix& B) {
-        auto result{A};
-        return result *= B;
+/// Basis of the solutions of `a * x = 0` as the columns of a
+/// `(a.Cols(), a.Cols() - Rank(a))` matrix
+template<class TBlock>
+TMatrix<TBlock> Nullspace(const TMatrix<TBlock>& a) {
+  auto rows = a.ToBitRows();
+  const auto pivots = detail::Eliminate(rows, a.Cols(), true);
+  std::vector<std::size_t> freeCols;
+  for (std::size_t c = 0, t = 0; c < a.Cols(); c++) {
+    if (t < pivots.size() && pivots[t] == c) {
+      t++;
+    } else {
+      freeCols.push_back(c);
+    }
+  }
+  // a free variable set to one fixes the pivot variables of its column
+  TMatrix<TBlock> result(a.Cols(), freeCols.size());
+  detail::TBitRows basis(result.BlockRows() * TBlock::DIM, detail::RowWords(result));
+  for (std::size_t j = 0; j < freeCols.size(); j++) {
+    const auto bit = u64{1} << (j % 64);
+    const auto f = freeCols[j];
+    basis.Row(f)[j / 64] |= bit;
+    for (std::size_t t = 0; t < pivots.size(); t++) {
+      if ((rows.Row(t)[f / 64] >> (f % 64)) & 1) {
+        basis.Row(pivots[t])[j / 64] |= bit;
+      }
     }
+  }
+  result.FromBitRows(basis);
+  return result;
+}
 
-    uint64_t rows;
-    uint64_t cols;
-    std::vector<TBlock> blocks;
+/*******************************************************************************
+*                              Parallel product                               *
+*******************************************************************************/
+
+struct TParallelMulOptions {
+  /// `GetThreadPool()` if not set
+  TThreadPool* Pool{nullptr};
+  /// Products with all sides at least this many bits long are split into 7
+  /// half-size products (Strassen-Winograd) instead of 8, the additions are
+  /// just XORs. Zero turns the recursion off.
+  std::size_t StrassenCutoff{0};
 };
 
-using TMatrix64bit = TMatrix<T8x8>;
-using TMatrix16bit = TMatrix<T4x4>;
-}  // namespace utils::gf2
+namespace detail {
+
+/// The blocks `[row, row + rows) x [col, col + cols)` of `m`, zero past its
+/// edges
+template<class TBlock>
+TMatrix<TBlock> SubBlocks(const TMatrix<TBlock>& m, std::size_t row, std::size_t col, std::size_t rows, std::size_t cols) {
+  TMatrix<TBlock> result(rows * TBlock::DIM, cols * TBlock::DIM);
+  for (std::size_t i = 0; i < rows && row + i < m.BlockRows(); i++) {
+    for (std::size_t j = 0; j < cols && col + j < m.BlockCols(); j++) {
+      result.Block(i, j) = m.Block(row + i, col + j);
+    }
+  }
+  return result;
+}
 
+/// The inverse of `SubBlocks`, the blocks of `part` past the edges of `m`
+/// are dropped
+template<class TBlock>
+void SetBlocks(TMatrix<TBlock>& m, std::size_t row, std::size_t col, const TMatrix<TBlock>& part) {
+  for (std::size_t i = 0; i < part.BlockRows() && row + i < m.BlockRows(); i++) {
+    for (std::size_t j = 0; j < part.BlockCols() && col + j < m.BlockCols(); j++) {
+      m.Block(row + i, col + j) = part.Block(i, j);
+    }
+  }
+}
+
+/// Every tile of the product is computed by one task, in the same order as
+/// `operator*`
+template<class TBlock>
+TMatrix<TBlock> ParallelMulTiles(const TMatrix<TBlock>& a, const TMatrix<TBlock>& b, TThreadPool* pool) {
+  TMatrix<TBlock> result(a.Rows(), b.Cols());
+  if (a.BlockRows() == 0 || a.BlockCols() == 0 || b.BlockCols() == 0) {
+    return result;
+  }
+  if constexpr (std::is_same_v<TBlock, T8x8>) {
+    if (PreferBlockMul()) {
+      ParallelMulBlocks(
+        GetGf2Kernels(), &a.Block(0, 0), &b.Block(0, 0), &result.Block(0, 0),
+        a.BlockRows(), a.BlockCols(), b.BlockCols(), pool
+      );
+      return result;
+    }
+  }
+  const auto rowsA = a.ToBitRows();
+  const auto rowsB = b.ToBitRows();
+  TBitRows rowsC(rowsA.Rows, rowsB.Words);
+  ParallelMulAddM4rm(rowsA, rowsB, rowsC, pool);
+  result.FromBitRows(rowsC);
+  return result;
 }
+
+template<class TBlock>
+TMatrix<TBlock> MulStrassen(const TMatrix<TBlock>& a, const TMatrix<TBlock>& b, const TParallelMulOptions& options) {
+  const auto cutoff = std::max(options.StrassenCutoff, 2 * TBlock::DIM);
+  if (options.StrassenCutoff == 0 || std::min({a.Rows(), a.Cols(), b.Cols()}) < cutoff) {
+    return ParallelMulTiles(a, b, options.Pool);
+  }
+  // quadrants of whole blocks, the odd ones padded with zeros
+  const auto n = (a.BlockRows() + 1) / 2;
+  const auto m = (a.BlockCols() + 1) / 2;
+  const auto p = (b.BlockCols() + 1) / 2;
+  const auto a11 = SubBlocks(a, 0, 0, n, m);
+  const auto a12 = SubBlocks(a, 0, m, n, m);
+  const auto a21 = SubBlocks(a, n, 0, n, m);
+  const auto a22 = SubBlocks(a, n, m, n, m);
+  const auto b11 = SubBlocks(b, 0, 0, m, p);
+  const auto b12 = SubBlocks(b, 0, p, m, p);
+  const auto b21 = SubBlocks(b, m, 0, m, p);
+  const auto b22 = SubBlocks(b, m, p, m, p);
+
+  // Winograd's schedule, subtraction is XOR as well
+  const auto s1 = a21 ^ a22;
+  const auto s2 = s1 ^ a11;
+  const auto s3 = a11 ^ a21;
+  const auto s4 = a12 ^ s2;
+  const auto t1 = b12 ^ b11;
+  const auto t2 = b22 ^ t1;
+  const auto t3 = b22 ^ b12;
+  const auto t4 = t2 ^ b21;
+  const std::pair<const TMatrix<TBlock>*, const TMatrix<TBlock>*> factors[7] = {
+    {&a11, &b11}, {&a12, &b21}, {&s4, &b22}, {&a22, &t4}, {&s1, &t1}, {&s2, &t2}, {&s3, &t3},
+  };
+  // one product at a time, each of them in parallel tiles: nested parallel
+  // recursion would let a waiting thread pick up ever deeper subproducts
+  TMatrix<TBlock> products[7];
+  for (std::size_t i = 0; i < 7; i++) {
+    products[i] = MulStrassen(*factors[i].first, *factors[i].second, options);
+  }
+
+  const auto u2 = products[0] ^ products[5];
+  const auto u3 = u2 ^ products[6];
+  const auto u4 = u2 ^ products[4];
+  TMatrix<TBlock> result(a.Rows(), b.Cols());
+  SetBlocks(result, 0, 0, products[0] ^ products[1]);
+  SetBlocks(result, 0, p, u4 ^ products[2]);
+  SetBlocks(result, n, 0, u3 ^ products[3]);
+  SetBlocks(result, n, p, u3 ^ products[4]);
+  return result;
+}
+
+}  // namespace utils::gf2::detail
+
+/// `a * b` for large matrices: the product is split into tiles computed on a
+/// thread pool, optionally after a few levels of Strassen-Winograd. Matrix
+/// products over GF(2) are exact, so the result is the same as `a * b` for
+/// any number of threads.
+template<class TBlock>
+TMatrix<TBlock> ParallelMul(const TMatrix<TBlock>& a, const TMatrix<TBlock>& b, const TParallelMulOptions& options = {}) {
+  EXPECT(
+    a.Cols() == b.Rows(),
+    Format(FMT("Incompatible matrices: (%, %) * (%, %)"), a.Rows(), a.Cols(), b.Rows(), b.Cols())
+  );
+  return detail::MulStrassen(a, b, options);
+}
+
+}  // namespace utils::gf2
+
+}  // namespace utils
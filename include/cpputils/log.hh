@@ -0,0 +1,296 @@
+#pragma once
+
+#include <cpputils/common.hh>
+#include <cpputils/string.hh>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+/// Log calls below this level are compiled out, see `LOG_INFO` and friends
+#ifndef CPPUTILS_LOG_MIN_LEVEL
+#define CPPUTILS_LOG_MIN_LEVEL 0
+#endif
+
+namespace utils {
+
+enum class ELogLevel {
+  Trace = 0,
+  Debug = 1,
+  Info = 2,
+  Warning = 3,
+  Error = 4,
+  Off = 5,
+};
+
+enum class ELogOverflow {
+  /// The record is discarded and counted in `TLogger::Dropped`
+  Drop,
+  /// The caller waits for the background thread to free some space
+  Block,
+};
+
+struct TLoggerOptions {
+  ELogLevel Level{ELogLevel::Info};
+  ELogOverflow Overflow{ELogOverflow::Drop};
+  /// Size of the ring buffer of every logging thread, rounded up to a power of two
+  std::size_t RingSize{1 << 20};
+  /// How long the background thread sleeps when there is nothing to write
+  std::chrono::microseconds PollInterval{1000};
+};
+
+namespace detail {
+
+constexpr bool IsLogLevelCompiled(ELogLevel level) {
+  return static_cast<int>(level) >= CPPUTILS_LOG_MIN_LEVEL;
+}
+
+using TLogDecodeFn = void (*)(const char* payload, std::string& out);
+
+struct TLogRecordHeader {
+  /// Size of the whole record including the header, a multiple of 8
+  u32 Size;
+  ELogLevel Level;
+  /// nullptr marks padding up to the end of the ring
+  TLogDecodeFn Decode;
+  i64 Timestamp;
+};
+
+/// Single-producer single-consumer byte ring, one per logging thread
+struct TLogRing {
+  explicit TLogRing(std::size_t capacity);
+
+  /// Space for a record of `size` bytes or nullptr if the ring is full
+  char* Reserve(std::size_t size);
+
+  void Commit(std::size_t size) {
+    Tail.store(Tail.load(std::memory_order_relaxed) + size, std::memory_order_release);
+  }
+
+  std::unique_ptr<char[]> Data;
+  std::size_t Capacity;
+  alignas(64) std::atomic<u64> Head{0};
+  alignas(64) std::atomic<u64> Tail{0};
+  u64 CachedHead{0};
+  std::atomic<u64> Dropped{0};
+  /// Set when the logger is destroyed, so the thread can let the ring go
+  std::atomic<bool> Orphaned{false};
+};
+
+/// How a log argument is carried from the caller to the background thread:
+/// strings are copied with their length, trivially copyable scalars are
+/// copied as is, everything else is formatted on the spot
+template<class T>
+inline constexpr bool IsLogString = std::is_convertible_v<const T&, std::string_view>;
+
+template<class T>
+inline constexpr bool IsLogScalar =
+  !IsLogString<T> && (std::is_arithmetic_v<T> || std::is_enum_v<T> || std::is_pointer_v<T>);
+
+template<class T>
+using TLogDecoded = std::conditional_t<IsLogScalar<T>, T, std::string_view>;
+
+/// Arguments that are neither strings nor scalars are formatted once, before
+/// the record is sized and encoded
+template<class T>
+decltype(auto) PrepareLogArg(const T& x) {
+  if constexpr (IsLogScalar<T> || IsLogString<T>) {
+    return (x);
+  } else {
+    return ToString(x);
+  }
+}
+
+/// `T` is a prepared argument: a scalar or a string
+template<class T>
+std::size_t LogArgSize(const T& x) {
+  if constexpr (IsLogScalar<T>) {
+    return sizeof(T);
+  } else {
+    return sizeof(u32) + std::string_view{x}.size();
+  }
+}
+
+inline char* EncodeLogString(char* out, std::string_view s) {
+  const auto size = static_cast<u32>(s.size());
+  std::memcpy(out, &size, sizeof(size));
+  std::memcpy(out + sizeof(size), s.data(), s.size());
+  return out + sizeof(size) + s.size();
+}
+
+template<class T>
+char* EncodeLogArg(char* out, const T& x) {
+  if constexpr (IsLogScalar<T>) {
+    std::memcpy(out, &x, sizeof(T));
+    return out + sizeof(T);
+  } else {
+    return EncodeLogString(out, x);
+  }
+}
+
+template<class T>
+TLogDecoded<T> DecodeLogArg(const char*& in) {
+  if constexpr (IsLogScalar<T>) {
+    T x;
+    std::memcpy(&x, in, sizeof(T));
+    in += sizeof(T);
+    return x;
+  } else {
+    u32 size;
+    std::memcpy(&size, in, sizeof(size));
+    in += sizeof(size);
+    const std::string_view result{in, size};
+    in += size;
+    return result;
+  }
+}
+
+template<class TSource, class... Args>
+void DecodeLogRecord([[maybe_unused]] const char* payload, std::string& out) {
+  // Braced initialization is evaluated left to right
+  std::tuple<TLogDecoded<Args>...> args{DecodeLogArg<Args>(payload)...};
+  std::apply([&out](const auto&... xs) { FormatTo(out, TSource{}, xs...); }, args);
+}
+
+}  // namespace utils::detail
+
+/*******************************************************************************
+*                                   TLogger                                   *
+*******************************************************************************/
+
+/// Asynchronous logger. A log call copies the raw arguments into a lock-free
+/// ring buffer of the calling thread and returns, so there is no formatting
+/// and no syscall on the caller side. A background thread formats the
+/// records, prefixes them with a UTC timestamp and the level, and writes
+/// them out in batches with `writev`. Records of one thread stay in order,
+/// records of different threads are not merged by time.
+class TLogger {
+public:
+  /// Logs to `fd`, which is not closed by the logger
+  explicit TLogger(int fd, TLoggerOptions options = {});
+
+  /// Appends to the file at `path`
+  explicit TLogger(const std::string& path, TLoggerOptions options = {});
+
+  /// Writes out everything that was logged before
+  ~TLogger();
+
+  TLogger(const TLogger&) = delete;
+  TLogger& operator=(const TLogger&) = delete;
+
+  void SetLevel(ELogLevel level) {
+    Level.store(level, std::memory_order_relaxed);
+  }
+
+  bool ShouldLog(ELogLevel level) const {
+    return level >= Level.load(std::memory_order_relaxed);
+  }
+
+  template<class TSource, class... Args>
+  void Log(ELogLevel level, TSource, const Args&... args) {
+    static_assert(detail::IsFormatString<TSource>, "Log format must be created with FMT");
+    static_assert(
+      detail::ParsedFormat<TSource>.Segments.size() == sizeof...(Args) + 1,
+      "Number of arguments doesn't match number of replacement spots"
+    );
+    Write(level, &detail::DecodeLogRecord<TSource, Args...>, detail::PrepareLogArg(args)...);
+  }
+
+  /// Blocks until everything logged before the call is written
+  void Flush();
+
+  /// Number of records discarded because of full ring buffers
+  u64 Dropped() const;
+
+private:
+  template<class... TPrepared>
+  void Write(ELogLevel level, detail::TLogDecodeFn decode, const TPrepared&... args) {
+    const auto timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::system_clock::now().time_since_epoch()
+    ).count();
+    const auto payloadSize = (std::size_t{0} + ... + detail::LogArgSize(args));
+    const auto size = (sizeof(detail::TLogRecordHeader) + payloadSize + 7) & ~std::size_t{7};
+
+    auto& ring = GetRing();
+    char* record = ring.Reserve(size);
+    while (record == nullptr && Options.Overflow == ELogOverflow::Block && size <= ring.Capacity) {
+      std::this_thread::yield();
+      record = ring.Reserve(size);
+    }
+    if (record == nullptr) {
+      ring.Dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    const detail::TLogRecordHeader header{static_cast<u32>(size), level, decode, timestamp};
+    std::memcpy(record, &header, sizeof(header));
+    [[maybe_unused]] char* payload = record + sizeof(header);
+    ((payload = detail::EncodeLogArg(payload, args)), ...);
+    ring.Commit(size);
+  }
+
+  detail::TLogRing& GetRing();
+  void Run();
+  bool Drain(std::string& batch);
+
+  const u64 Id;
+  const TLoggerOptions Options;
+  std::atomic<ELogLevel> Level;
+  int Fd;
+  bool OwnsFd;
+
+  mutable std::mutex RingsLock;
+  std::vector<std::shared_ptr<detail::TLogRing>> Rings;
+  u64 DroppedByFinishedThreads{0};
+
+  std::mutex PassLock;
+  std::condition_variable PassDone;
+  u64 Passes{0};
+  std::atomic<bool> Stopping{false};
+  std::thread Worker;
+};
+
+/*******************************************************************************
+*                                Global logger                                *
+*******************************************************************************/
+
+/// The logger used by the `LOG_*` macros, nullptr if there is none
+TLogger* GetLogger();
+
+/// Makes `logger` the global one for the lifetime of the scope and restores
+/// the previous one afterwards
+class TScopedLogger {
+public:
+  explicit TScopedLogger(TLogger& logger);
+  ~TScopedLogger();
+
+  TScopedLogger(const TScopedLogger&) = delete;
+  TScopedLogger& operator=(const TScopedLogger&) = delete;
+
+private:
+  TLogger* Previous;
+};
+
+}  // namespace utils
+
+/// LOG_INFO(FMT("request % took % ms"), id, ms);
+#define CPPUTILS_LOG(level, ...) \
+  do { \
+    if constexpr (::utils::detail::IsLogLevelCompiled(level)) { \
+      if (auto* cpputilsLogger = ::utils::GetLogger(); cpputilsLogger && cpputilsLogger->ShouldLog(level)) { \
+        cpputilsLogger->Log(level, __VA_ARGS__); \
+      } \
+    } \
+  } while (false)
+
+#define LOG_TRACE(...) CPPUTILS_LOG(::utils::ELogLevel::Trace, __VA_ARGS__)
+#define LOG_DEBUG(...) CPPUTILS_LOG(::utils::ELogLevel::Debug, __VA_ARGS__)
+#define LOG_INFO(...) CPPUTILS_LOG(::utils::ELogLevel::Info, __VA_ARGS__)
+#define LOG_WARNING(...) CPPUTILS_LOG(::utils::ELogLevel::Warning, __VA_ARGS__)
+#define LOG_ERROR(...) CPPUTILS_LOG(::utils::ELogLevel::Error, __VA_ARGS__)
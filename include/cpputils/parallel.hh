@@ -0,0 +1,253 @@
+#pragma once
+
+#include <cpputils/itertools.hh>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace utils {
+
+/*******************************************************************************
+*                                 TThreadPool                                 *
+*******************************************************************************/
+
+/// Fixed-size pool of workers with a task deque each. A worker pushes and
+/// pops its own tasks at the back and steals from the front of the others'
+/// deques when it runs out, so nested parallel calls stay local while idle
+/// workers pick up the oldest (largest) pieces of work.
+class TThreadPool {
+public:
+  using TTask = std::function<void()>;
+
+  /// `threads` may be zero, then everything runs on the calling thread
+  explicit TThreadPool(std::size_t threads = std::thread::hardware_concurrency());
+  ~TThreadPool();
+
+  TThreadPool(const TThreadPool&) = delete;
+  TThreadPool& operator=(const TThreadPool&) = delete;
+
+  /// Number of worker threads, not counting the threads that wait in
+  /// `ParallelFor` and help the workers
+  std::size_t Size() const {
+    return Threads.size();
+  }
+
+  /// Runs `task` on some worker. Exceptions escaping `task` terminate.
+  void Submit(TTask task);
+
+  /// Calls `fn(0)`, ..., `fn(count - 1)` in parallel and returns when all of
+  /// them are done. The calling thread runs tasks too, so it is safe to call
+  /// from inside a task. The first exception thrown by `fn` is rethrown after
+  /// all calls finish.
+  void ParallelFor(std::size_t count, const std::function<void(std::size_t)>& fn);
+
+private:
+  struct TWorker {
+    std::mutex Mutex;
+    std::deque<TTask> Tasks;
+  };
+
+  void Push(std::size_t queue, TTask task);
+  bool TryPop(std::size_t self, TTask& task);
+  bool TrySteal(std::size_t self, TTask& task);
+  /// Runs one pending task if there is any
+  bool RunOne(std::size_t self);
+  void WorkerLoop(std::size_t self);
+
+  std::vector<std::unique_ptr<TWorker>> Workers;
+  std::vector<std::thread> Threads;
+
+  std::mutex SleepMutex;
+  std::condition_variable WakeUp;
+  /// Pushed but not yet popped tasks. May go below zero for a moment, since
+  /// tasks are counted after they become visible to thieves.
+  std::atomic<long> Pending{0};
+  bool Stopping{false};
+  std::atomic<std::size_t> NextQueue{0};
+};
+
+/// Process-wide pool with one thread less than the hardware concurrency:
+/// the thread that calls a parallel algorithm is the remaining one
+TThreadPool& GetThreadPool();
+
+/*******************************************************************************
+*                             Parallel algorithms                             *
+*******************************************************************************/
+
+struct TParallelOptions {
+  /// Elements per task. Zero picks it from the range size and the number of
+  /// threads. Reductions group elements by chunk, so fix the grain size to
+  /// get bitwise identical results for non-associative operations (like
+  /// floating-point addition) on machines with different core counts.
+  std::size_t GrainSize{0};
+  /// `GetThreadPool()` if not set
+  TThreadPool* Pool{nullptr};
+};
+
+namespace detail {
+
+/// Chunks per thread for the automatic grain size: enough to even out
+/// uneven elements, few enough to keep the scheduling overhead low
+inline constexpr std::size_t CHUNKS_PER_THREAD = 4;
+
+struct TChunking {
+  std::size_t Size;
+  std::size_t Grain;
+  std::size_t Chunks;
+
+  constexpr std::size_t Begin(std::size_t chunk) const {
+    return chunk * Grain;
+  }
+
+  constexpr std::size_t End(std::size_t chunk) const {
+    return std::min(Size, (chunk + 1) * Grain);
+  }
+};
+
+inline TChunking MakeChunking(std::size_t size, const TParallelOptions& options, const TThreadPool& pool) {
+  auto grain = options.GrainSize;
+  if (grain == 0) {
+    const auto chunks = (pool.Size() + 1) * CHUNKS_PER_THREAD;
+    grain = std::max<std::size_t>((size + chunks - 1) / chunks, 1);
+  }
+  return TChunking{size, grain, (size + grain - 1) / grain};
+}
+
+/// Calls `fn(chunk, begin, end)` for every chunk of the random-access `view`
+template<class TView, class Fn>
+void ForEachChunk(const TView& view, const TParallelOptions& options, Fn&& fn) {
+  static_assert(
+    TRangeTraits<TView>::is_random_access,
+    "Parallel algorithms need a random-access range with an end iterator"
+  );
+  auto& pool = options.Pool ? *options.Pool : GetThreadPool();
+  const auto begin = std::begin(view);
+  const auto chunking = MakeChunking(static_cast<std::size_t>(std::end(view) - begin), options, pool);
+  const auto run = [&](std::size_t chunk) {
+    using TDifference = typename TRangeTraits<TView>::difference_type;
+    fn(chunk, begin + static_cast<TDifference>(chunking.Begin(chunk)), begin + static_cast<TDifference>(chunking.End(chunk)));
+  };
+  if (chunking.Chunks <= 1) {
+    if (chunking.Chunks == 1) {
+      run(0);
+    }
+    return;
+  }
+  pool.ParallelFor(chunking.Chunks, run);
+}
+
+template<class TView>
+std::size_t ChunkCount(const TView& view, const TParallelOptions& options) {
+  const auto& pool = options.Pool ? *options.Pool : GetThreadPool();
+  return MakeChunking(RangeSize(view), options, pool).Chunks;
+}
+
+}  // namespace utils::detail
+
+/// Calls `fn` on every element of a random-access range (a container,
+/// `MakeView`, `Map` or `Zip` of random-access ranges) in parallel
+template<class TRange, class Fn>
+void ParallelForEach(const TRange& r, Fn fn, const TParallelOptions& options = {}) {
+  const auto view = MakeView(r);
+  detail::ForEachChunk(view, options, [&fn](std::size_t, auto first, auto last) {
+    for (; first != last; ++first) {
+      fn(*first);
+    }
+  });
+}
+
+/// `ToVector(Map(r, fn))` computed in parallel. The results are in the order
+/// of the elements of `r`.
+template<class TRange, class Fn>
+auto ParallelMap(const TRange& r, Fn fn, const TParallelOptions& options = {}) {
+  const auto view = MakeView(r);
+  using TResult = std::decay_t<std::invoke_result_t<Fn&, typename detail::TRangeTraits<decltype(view)>::value_type>>;
+  if constexpr (std::is_default_constructible_v<TResult> && !std::is_same_v<TResult, bool>) {
+    // every chunk writes its own slice of the result
+    std::vector<TResult> result(detail::RangeSize(view));
+    const auto begin = std::begin(view);
+    detail::ForEachChunk(view, options, [&](std::size_t, auto first, auto last) {
+      auto out = result.begin() + (first - begin);
+      for (; first != last; ++first, ++out) {
+        *out = fn(*first);
+      }
+    });
+    return result;
+  } else {
+    std::vector<std::vector<TResult>> chunks(detail::ChunkCount(view, options));
+    detail::ForEachChunk(view, options, [&](std::size_t chunk, auto first, auto last) {
+      auto& out = chunks[chunk];
+      out.reserve(static_cast<std::size_t>(last - first));
+      for (; first != last; ++first) {
+        out.push_back(fn(*first));
+      }
+    });
+    std::vector<TResult> result;
+    result.reserve(detail::RangeSize(view));
+    for (auto& chunk : chunks) {
+      std::move(chunk.begin(), chunk.end(), std::back_inserter(result));
+    }
+    return result;
+  }
+}
+
+/// Left fold of `r` with `op` in parallel: every chunk is folded starting
+/// from its first element, then `init` and the chunk results are folded in
+/// order. The result equals the sequential fold whenever `op` is associative
+/// and is the same from run to run for a fixed grain size. `op` is called
+/// both as `op(T, element)` and `op(T, T)`, so the elements must be of type
+/// `T`; other accumulators need the overload with `combine`.
+template<class TRange, class T, class Op>
+T ParallelReduce(const TRange& r, T init, Op op, const TParallelOptions& options = {}) {
+  const auto view = MakeView(r);
+  static_assert(
+    std::is_same_v<typename detail::TRangeTraits<decltype(view)>::value_type, T>,
+    "The accumulator type differs from the element type, pass `combine` to merge the chunk results"
+  );
+  std::vector<std::optional<T>> partial(detail::ChunkCount(view, options));
+  detail::ForEachChunk(view, options, [&](std::size_t chunk, auto first, auto last) {
+    T acc(*first);
+    for (++first; first != last; ++first) {
+      acc = op(std::move(acc), *first);
+    }
+    partial[chunk].emplace(std::move(acc));
+  });
+  for (auto& value : partial) {
+    init = op(std::move(init), std::move(*value));
+  }
+  return init;
+}
+
+/// Parallel fold into an accumulator of another type: every chunk folds its
+/// elements with `op(T, element)` starting from a copy of `identity`, then
+/// the chunk results are merged in order with `combine(T, T)`. `identity`
+/// must not change a value it is combined with, e.g. 0 for a sum.
+template<class TRange, class T, class Op, class Combine>
+T ParallelReduce(const TRange& r, T identity, Op op, Combine combine, const TParallelOptions& options = {}) {
+  const auto view = MakeView(r);
+  std::vector<std::optional<T>> partial(detail::ChunkCount(view, options));
+  detail::ForEachChunk(view, options, [&](std::size_t chunk, auto first, auto last) {
+    T acc(identity);
+    for (; first != last; ++first) {
+      acc = op(std::move(acc), *first);
+    }
+    partial[chunk].emplace(std::move(acc));
+  });
+  for (auto& value : partial) {
+    identity = combine(std::move(identity), std::move(*value));
+  }
+  return identity;
+}
+
+}  // namespace utils
@@ -0,0 +1,203 @@
+#pragma once
+
+#include <cpputils/common.hh>
+#include <cpputils/charset.hh>
+
+#include <charconv>
+#include <cstring>
+#include <limits>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+namespace utils {
+
+enum class EParseError {
+  Ok,
+  Empty,
+  /// Not a number at all
+  Invalid,
+  /// A number that doesn't fit into the type
+  OutOfRange,
+  /// A number followed by something else
+  Trailing,
+};
+
+template<class T>
+struct TParsed {
+  T Value{};
+  EParseError Error{EParseError::Ok};
+
+  bool Ok() const {
+    return Error == EParseError::Ok;
+  }
+
+  explicit operator bool() const {
+    return Ok();
+  }
+};
+
+namespace detail {
+
+/// Eight ASCII digits loaded as a little-endian word
+inline bool IsEightDigits(u64 chunk) {
+  return (((chunk & 0xF0F0F0F0F0F0F0F0ull) | (((chunk + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4))
+    == 0x3333333333333333ull);
+}
+
+/// Value of eight ASCII digits: pairs, then quadruples, then the whole word
+/// are combined with one multiplication each
+inline u64 ParseEightDigits(u64 chunk) {
+  chunk -= 0x3030303030303030ull;
+  chunk = (chunk * 10 + (chunk >> 8)) & 0x00FF00FF00FF00FFull;
+  chunk = (chunk * 100 + (chunk >> 16)) & 0x0000FFFF0000FFFFull;
+  return (chunk * 10000 + (chunk >> 32)) & 0xFFFFFFFFull;
+}
+
+inline bool IsDigit(char c) {
+  return static_cast<unsigned char>(c - '0') < 10;
+}
+
+/// Parses the digits at `begin` eight at a time while it can. Returns the
+/// end of the digit run, the value is only meaningful for up to 19 digits.
+inline const char* ParseDigits(const char* begin, const char* end, u64& value) {
+  const char* p = begin;
+  value = 0;
+  while (end - p >= 8) {
+    u64 chunk;
+    std::memcpy(&chunk, p, sizeof(chunk));
+    if (!IsEightDigits(chunk)) {
+      break;
+    }
+    value = value * 100000000 + ParseEightDigits(chunk);
+    p += 8;
+  }
+  while (p != end && IsDigit(*p)) {
+    value = value * 10 + (*p - '0');
+    p++;
+  }
+  return p;
+}
+
+template<class T>
+TParsed<T> ParseInteger(std::string_view s) {
+  const char* p = s.data();
+  const char* end = p + s.size();
+  bool negative = false;
+  if (p != end && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    p++;
+    if constexpr (std::is_unsigned_v<T>) {
+      if (negative) {
+        return {T{}, EParseError::Invalid};
+      }
+    }
+  }
+  u64 magnitude;
+  const char* digitsEnd = ParseDigits(p, end, magnitude);
+  if (digitsEnd == p) {
+    return {T{}, EParseError::Invalid};
+  }
+  if (digitsEnd - p > 19) {
+    // May not fit into 64 bits, let the standard library sort it out
+    T value{};
+    const auto [ptr, ec] = std::from_chars(negative ? p - 1 : p, end, value);
+    if (ec == std::errc::result_out_of_range) {
+      return {T{}, EParseError::OutOfRange};
+    }
+    return {value, ptr == end ? EParseError::Ok : EParseError::Trailing};
+  }
+  using TUnsigned = std::make_unsigned_t<T>;
+  const u64 limit = negative
+    ? static_cast<u64>(static_cast<TUnsigned>(std::numeric_limits<T>::max())) + 1
+    : static_cast<u64>(std::numeric_limits<T>::max());
+  if (magnitude > limit) {
+    return {T{}, EParseError::OutOfRange};
+  }
+  const auto value = negative
+    ? static_cast<T>(TUnsigned{0} - static_cast<TUnsigned>(magnitude))
+    : static_cast<T>(magnitude);
+  return {value, digitsEnd == end ? EParseError::Ok : EParseError::Trailing};
+}
+
+template<class T>
+TParsed<T> ParseFloat(std::string_view s) {
+  const char* p = s.data();
+  const char* end = p + s.size();
+  if (p != end && *p == '+' && end - p > 1 && *(p + 1) != '-') {
+    p++;
+  }
+  T value{};
+  const auto [ptr, ec] = std::from_chars(p, end, value);
+  if (ec == std::errc::invalid_argument) {
+    return {T{}, EParseError::Invalid};
+  }
+  if (ec == std::errc::result_out_of_range) {
+    return {T{}, EParseError::OutOfRange};
+  }
+  return {value, ptr == end ? EParseError::Ok : EParseError::Trailing};
+}
+
+}  // namespace utils::detail
+
+/*******************************************************************************
+*                                    Parse                                    *
+*******************************************************************************/
+
+/// Parses the whole `s` as a number of type `T` without allocating or
+/// throwing. A leading '+' is accepted, whitespace is not.
+///   if (const auto port = utils::Parse<u32>(token)) { use(port.Value); }
+template<class T>
+TParsed<T> Parse(std::string_view s) {
+  static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, "Only numbers can be parsed");
+  if (s.empty()) {
+    return {T{}, EParseError::Empty};
+  }
+  if constexpr (std::is_integral_v<T>) {
+    return detail::ParseInteger<T>(s);
+  } else {
+    return detail::ParseFloat<T>(s);
+  }
+}
+
+/*******************************************************************************
+*                                  ParseMany                                  *
+*******************************************************************************/
+
+struct TParseManyResult {
+  /// Number of values appended to the column
+  std::size_t Count{0};
+  EParseError Error{EParseError::Ok};
+  /// Offset of the token that failed to parse
+  std::size_t ErrorOffset{0};
+
+  bool Ok() const {
+    return Error == EParseError::Ok;
+  }
+};
+
+/// Parses every token of `buffer` separated by runs of `separators` (same
+/// tokens as `Split`) and appends the values to `column`. Stops at the first
+/// token that is not a valid number. Token boundaries are found with the
+/// `TCharSet` scanning kernels, integer digits are converted eight at a time.
+template<class T>
+TParseManyResult ParseMany(std::string_view buffer, const TCharSet& separators, std::vector<T>& column) {
+  TParseManyResult result;
+  auto begin = FindFirstNotOf(buffer, separators);
+  while (begin != std::string_view::npos) {
+    const auto end = std::min(FindFirstOf(buffer, separators, begin), buffer.size());
+    const auto parsed = Parse<T>(buffer.substr(begin, end - begin));
+    if (!parsed) {
+      result.Error = parsed.Error;
+      result.ErrorOffset = begin;
+      return result;
+    }
+    column.push_back(parsed.Value);
+    result.Count++;
+    begin = FindFirstNotOf(buffer, separators, end);
+  }
+  return result;
+}
+
+}  // namespace utils
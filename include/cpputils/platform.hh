@@ -0,0 +1,69 @@
+#pragma once
+
+/// Platform-dependent functionality: CPU feature detection for the kernels
+/// that are dispatched at runtime
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define CPPUTILS_X86 1
+#else
+#define CPPUTILS_X86 0
+#endif
+
+/// Compiles a function for the given instruction set, callers must check
+/// that the CPU supports it
+#if CPPUTILS_X86
+#define CPPUTILS_TARGET(isa) __attribute__((target(isa)))
+#else
+#define CPPUTILS_TARGET(isa)
+#endif
+
+namespace utils::platform {
+
+inline bool HasSse2() {
+#if CPPUTILS_X86
+  static const bool result = __builtin_cpu_supports("sse2") != 0;
+  return result;
+#else
+  return false;
+#endif
+}
+
+inline bool HasSse42() {
+#if CPPUTILS_X86
+  static const bool result = __builtin_cpu_supports("sse4.2") != 0;
+  return result;
+#else
+  return false;
+#endif
+}
+
+inline bool HasAvx2() {
+#if CPPUTILS_X86
+  static const bool result = __builtin_cpu_supports("avx2") != 0;
+  return result;
+#else
+  return false;
+#endif
+}
+
+/// Galois field instructions (`vgf2p8affineqb` and friends)
+inline bool HasGfni() {
+#if CPPUTILS_X86
+  static const bool result = __builtin_cpu_supports("gfni") != 0;
+  return result;
+#else
+  return false;
+#endif
+}
+
+/// Hint to fetch the cache line at `address`, so that a later access to it
+/// does not stall
+inline void Prefetch(const void* address) {
+#if defined(__GNUC__)
+  __builtin_prefetch(address);
+#else
+  (void)address;
+#endif
+}
+
+}  // namespace utils::platform
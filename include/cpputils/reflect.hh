@@ -90,6 +90,10 @@ struct TStructDescriptor {
   auto ToTuple() const { \
     return std::make_tuple(__VA_ARGS__); \
   } \
+  /* references to the fields, for hashing and comparison without copies */ \
+  auto Tie() const { \
+    return std::tie(__VA_ARGS__); \
+  } \
   static const utils::detail::TStructDescriptor* GetDescriptor() { \
     return STRUCT{}.GetDescriptorHelper(); \
   }
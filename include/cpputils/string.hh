@@ -1,63 +1,419 @@
 #pragma once
 
+#include <cpputils/charset.hh>
+#include <cpputils/itertools.hh>
+
 #include <string>
 #include <string_view>
-#include <unordered_set>
 #include <vector>
 #include <type_traits>
 #include <sstream>
 #include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
 
 namespace utils {
 
 namespace detail {
-  inline const std::unordered_set WS = {' ', '\f', '\n', '\r', '\t', '\v'};
+  inline constexpr TCharSet WS{" \f\n\r\t\v"};
+
+  template<class T>
+  inline constexpr bool IsCharLike =
+    std::is_same_v<T, char> || std::is_same_v<T, signed char> || std::is_same_v<T, unsigned char>;
+
+  template<class TBuffer, class T>
+  void StreamTo(TBuffer& buffer, const T& x) {
+    std::ostringstream os;
+    os << x;
+    const auto str = os.str();
+    buffer.append(str.data(), str.size());
+  }
 }  // namespace utils::detail
 
+/*******************************************************************************
+*                                 AppendValue                                 *
+*******************************************************************************/
+
+/// Appends the textual representation of `x` to `buffer`. The output is the
+/// same as `std::ostream::operator<<` with default flags, but arithmetic types
+/// and strings never go through a stream.
+/// `TBuffer` needs `append(const char*, size_t)` and `push_back(char)`.
+template <class TBuffer, class T>
+void AppendValue(TBuffer& buffer, const T& x) {
+  if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+    const std::string_view sv = x;
+    buffer.append(sv.data(), sv.size());
+  } else if constexpr (detail::IsCharLike<T>) {
+    buffer.push_back(static_cast<char>(x));
+  } else if constexpr (std::is_same_v<T, bool>) {
+    buffer.push_back(x ? '1' : '0');
+  } else if constexpr (std::is_integral_v<T>) {
+    char chars[24];
+    const auto [end, ec] = std::to_chars(chars, chars + sizeof(chars), x);
+    buffer.append(chars, end - chars);
+  } else if constexpr (std::is_floating_point_v<T>) {
+    // Same as the default stream precision, i.e. "%g"
+    char chars[64];
+    const auto [end, ec] = std::to_chars(chars, chars + sizeof(chars), x, std::chars_format::general, 6);
+    buffer.append(chars, end - chars);
+  } else {
+    detail::StreamTo(buffer, x);
+  }
+}
+
 template <typename T>
 std::string ToString(const T& x) {
-  std::ostringstream os;
-  os << x;
-  return os.str();
+  std::string result;
+  AppendValue(result, x);
+  return result;
 }
 
-template <typename... Args>
-std::string Format(std::string_view formatStr, Args&&... args) {
-  constexpr static auto REPORT_MISMATCH = [] () {
-    throw std::runtime_error(
-        "Number of arguments doesn't match number of replacement spots");
-  };
-  if constexpr (sizeof...(Args) == 0) {
-    return std::string{formatStr};
+/*******************************************************************************
+*                                   Format                                    *
+*******************************************************************************/
+
+namespace detail {
+
+/// Base of the types produced by `FMT`
+struct TFormatStringTag {};
+
+template<class T>
+inline constexpr bool IsFormatString = std::is_base_of_v<TFormatStringTag, std::decay_t<T>>;
+
+struct TFormatSegment {
+  std::size_t Offset{0};
+  std::size_t Size{0};
+};
+
+constexpr std::size_t CountSpots(std::string_view formatStr) {
+  std::size_t spots = 0;
+  for (std::size_t i = 0; i < formatStr.size(); i++) {
+    if (formatStr[i] == '\\') {
+      i++;
+    } else if (formatStr[i] == '%') {
+      spots++;
+    }
+  }
+  return spots;
+}
+
+/// Format string split into `SPOTS + 1` unescaped literal segments that
+/// surround the replacement spots
+template<std::size_t LENGTH, std::size_t SPOTS>
+struct TParsedFormat {
+  std::array<char, LENGTH> Text{};
+  std::array<TFormatSegment, SPOTS + 1> Segments{};
+  std::size_t TextSize{0};
+
+  constexpr std::string_view Segment(std::size_t i) const {
+    return std::string_view{Text.data() + Segments[i].Offset, Segments[i].Size};
   }
-  std::initializer_list<std::string> replacements = {ToString(std::forward<Args>(args))...};
-  auto currentReplacement = replacements.begin();
-  std::ostringstream result;
-  bool skip{false};
-  for (auto c : formatStr) {
-    if (skip) {
-      skip = false;
-      result << c;
+};
+
+template<class TSource>
+constexpr auto ParseFormat() {
+  constexpr std::string_view formatStr = TSource::Get();
+  TParsedFormat<formatStr.size(), CountSpots(formatStr)> result;
+  std::size_t segment = 0;
+  for (std::size_t i = 0; i < formatStr.size(); i++) {
+    if (formatStr[i] == '%') {
+      result.Segments[segment].Size = result.TextSize - result.Segments[segment].Offset;
+      segment++;
+      result.Segments[segment].Offset = result.TextSize;
       continue;
     }
-    if (c == '%') {
-      if (currentReplacement == replacements.end()) {
-        REPORT_MISMATCH();
+    if (formatStr[i] == '\\') {
+      i++;
+      if (i == formatStr.size()) {
+        break;
       }
-      result << *currentReplacement;
-      currentReplacement++;
-    } else if (c == '\\') {
-      skip = true;
-    } else {
-      result << c;
     }
+    result.Text[result.TextSize++] = formatStr[i];
+  }
+  result.Segments[segment].Size = result.TextSize - result.Segments[segment].Offset;
+  return result;
+}
+
+template<class TSource>
+inline constexpr auto ParsedFormat = ParseFormat<TSource>();
+
+template<class TBuffer>
+void AppendFormatSegments(TBuffer&, const std::string_view*) {}
+
+template<class TBuffer, class T, class... Args>
+void AppendFormatSegments(TBuffer& buffer, const std::string_view* segments, const T& arg, const Args&... args) {
+  AppendValue(buffer, arg);
+  buffer.append(segments->data(), segments->size());
+  AppendFormatSegments(buffer, segments + 1, args...);
+}
+
+template<class TSource, size_t... Is>
+constexpr auto MakeSegmentViews(std::index_sequence<Is...>) {
+  return std::array<std::string_view, sizeof...(Is)>{ParsedFormat<TSource>.Segment(Is)...};
+}
+
+template<class TSource>
+inline constexpr auto SegmentViews = MakeSegmentViews<TSource>(
+  std::make_index_sequence<ParsedFormat<TSource>.Segments.size()>()
+);
+
+/// Copies the literal part of `formatStr` starting at `pos` into `buffer`.
+/// Returns true if it stopped at a replacement spot, `pos` then points right
+/// after it.
+template<class TBuffer>
+bool AppendUntilSpot(TBuffer& buffer, std::string_view formatStr, std::size_t& pos) {
+  while (pos < formatStr.size()) {
+    const auto special = formatStr.find_first_of("%\\", pos);
+    const auto literalEnd = special == std::string_view::npos ? formatStr.size() : special;
+    buffer.append(formatStr.data() + pos, literalEnd - pos);
+    pos = literalEnd;
+    if (pos == formatStr.size()) {
+      break;
+    }
+    if (formatStr[pos] == '%') {
+      pos++;
+      return true;
+    }
+    if (pos + 1 < formatStr.size()) {
+      buffer.push_back(formatStr[pos + 1]);
+    }
+    pos += 2;
+  }
+  return false;
+}
+
+[[noreturn]] inline void ReportFormatMismatch() {
+  throw std::runtime_error(
+      "Number of arguments doesn't match number of replacement spots");
+}
+
+}  // namespace utils::detail
+
+/// Makes a format string that is parsed at compile time:
+///   utils::Format(FMT("% + % = %"), 1, 2, 3)
+/// Mismatch between the number of `%` and arguments is a compile error.
+#define FMT(str) \
+  ([] { \
+    struct TFormatSource : ::utils::detail::TFormatStringTag { \
+      static constexpr std::string_view Get() { return str; } \
+    }; \
+    return TFormatSource{}; \
+  }())
+
+/// Appends the formatted string to `buffer` (see `AppendValue` for the
+/// requirements). Every `%` is replaced with the next argument, `\\` escapes
+/// the following character.
+template <class TBuffer, class TSource, class... Args,
+          std::enable_if_t<detail::IsFormatString<TSource>, int> = 0>
+void FormatTo(TBuffer& buffer, TSource, const Args&... args) {
+  static_assert(
+    detail::ParsedFormat<TSource>.Segments.size() == sizeof...(Args) + 1,
+    "Number of arguments doesn't match number of replacement spots"
+  );
+  const auto& segments = detail::SegmentViews<TSource>;
+  buffer.append(segments[0].data(), segments[0].size());
+  detail::AppendFormatSegments(buffer, segments.data() + 1, args...);
+}
+
+template <class TBuffer, class... Args>
+void FormatTo(TBuffer& buffer, std::string_view formatStr, const Args&... args) {
+  const auto initialSize = buffer.size();
+  std::size_t pos = 0;
+  const bool matches =
+    ((detail::AppendUntilSpot(buffer, formatStr, pos) && (AppendValue(buffer, args), true)) && ...)
+    && !detail::AppendUntilSpot(buffer, formatStr, pos);
+  if (!matches) {
+    buffer.resize(initialSize);
+    detail::ReportFormatMismatch();
   }
-  if (currentReplacement != replacements.end()) {
-    REPORT_MISMATCH();
+}
+
+template <class TSource, class... Args,
+          std::enable_if_t<detail::IsFormatString<TSource>, int> = 0>
+std::string Format(TSource source, const Args&... args) {
+  std::string result;
+  result.reserve(detail::ParsedFormat<TSource>.TextSize + 16 * sizeof...(Args));
+  FormatTo(result, source, args...);
+  return result;
+}
+
+/// Runtime counterpart of `Format(FMT(...), ...)`, throws on argument count
+/// mismatch. Without arguments the format string is returned as is.
+template <typename... Args>
+std::string Format(std::string_view formatStr, const Args&... args) {
+  if constexpr (sizeof...(Args) == 0) {
+    return std::string{formatStr};
+  } else {
+    std::string result;
+    result.reserve(formatStr.size() + 16 * sizeof...(Args));
+    FormatTo(result, formatStr, args...);
+    return result;
   }
-  return result.str();
 }
 
+/*******************************************************************************
+*                               TStringBuilder                                *
+*******************************************************************************/
+
+/// String builder that keeps up to `INLINE_CAPACITY` bytes inside the object
+/// (i.e. on the stack for a local builder) and only goes to the heap when it
+/// overflows. Values are appended with `AppendValue`, so there is no locale
+/// or stream work for strings and arithmetic types. It satisfies the buffer
+/// requirements of `AppendValue`/`FormatTo`.
+template<std::size_t INLINE_CAPACITY>
+class TBasicStringBuilder {
+public:
+  TBasicStringBuilder() = default;
+
+  TBasicStringBuilder(const TBasicStringBuilder& other) {
+    append(other.data(), other.size());
+  }
+
+  TBasicStringBuilder& operator=(const TBasicStringBuilder& other) {
+    if (this != &other) {
+      clear();
+      append(other.data(), other.size());
+    }
+    return *this;
+  }
+
+  /// Steals the heap buffer, inline bytes are copied
+  TBasicStringBuilder(TBasicStringBuilder&& other) noexcept {
+    MoveFrom(other);
+  }
+
+  TBasicStringBuilder& operator=(TBasicStringBuilder&& other) noexcept {
+    if (this != &other) {
+      Heap.reset();
+      Data = Inline;
+      Capacity = INLINE_CAPACITY;
+      MoveFrom(other);
+    }
+    return *this;
+  }
+
+  template<class T>
+  TBasicStringBuilder& operator<<(const T& x) {
+    AppendValue(*this, x);
+    return *this;
+  }
+
+  template<class... Args>
+  TBasicStringBuilder& Append(const Args&... args) {
+    (AppendValue(*this, args), ...);
+    return *this;
+  }
+
+  void append(const char* s, std::size_t count) {
+    // `s` may point into the builder itself, so the old buffer is released
+    // only after it is copied from
+    std::unique_ptr<char[]> old;
+    if (Size + count > Capacity) {
+      old = Grow(Size + count);
+    }
+    std::copy_n(s, count, Data + Size);
+    Size += count;
+  }
+
+  void append(std::string_view s) {
+    append(s.data(), s.size());
+  }
+
+  void push_back(char c) {
+    reserve(Size + 1);
+    Data[Size++] = c;
+  }
+
+  void reserve(std::size_t capacity) {
+    if (capacity > Capacity) {
+      Grow(capacity);
+    }
+  }
+
+  /// Only shrinking is supported
+  void resize(std::size_t size) {
+    Size = std::min(Size, size);
+  }
+
+  void clear() {
+    Size = 0;
+  }
+
+  const char* data() const {
+    return Data;
+  }
+
+  std::size_t size() const {
+    return Size;
+  }
+
+  std::size_t capacity() const {
+    return Capacity;
+  }
+
+  bool IsInline() const {
+    return Heap == nullptr;
+  }
+
+  std::string_view View() const {
+    return {Data, Size};
+  }
+
+  std::string Str() const {
+    return std::string{View()};
+  }
+
+  operator std::string_view() const {
+    return View();
+  }
+
+  explicit operator std::string() const {
+    return Str();
+  }
+
+private:
+  /// Moves the contents to a new heap buffer and returns the previous one
+  std::unique_ptr<char[]> Grow(std::size_t capacity) {
+    const auto newCapacity = std::max(capacity, 2 * Capacity);
+    // Not value-initialized: the bytes past `Size` are never read
+    std::unique_ptr<char[]> heap{new char[newCapacity]};
+    std::copy_n(Data, Size, heap.get());
+    std::swap(Heap, heap);
+    Data = Heap.get();
+    Capacity = newCapacity;
+    return heap;
+  }
+
+  void MoveFrom(TBasicStringBuilder& other) noexcept {
+    if (other.IsInline()) {
+      std::copy_n(other.Data, other.Size, Inline);
+    } else {
+      Heap = std::move(other.Heap);
+      Data = Heap.get();
+      Capacity = other.Capacity;
+    }
+    Size = other.Size;
+    other.Data = other.Inline;
+    other.Capacity = INLINE_CAPACITY;
+    other.Size = 0;
+  }
+
+  char Inline[INLINE_CAPACITY];
+  std::unique_ptr<char[]> Heap;
+  char* Data{Inline};
+  std::size_t Size{0};
+  std::size_t Capacity{INLINE_CAPACITY};
+};
+
+using TStringBuilder = TBasicStringBuilder<256>;
+
+/// Stream-backed, so manipulators like `std::hex` and `std::setw` work.
+/// New code should use `TStringBuilder`, which skips the stream.
 class MakeString {
 public:
   template<class T>
@@ -73,21 +429,62 @@ private:
 };
 
 /*******************************************************************************
-*                                    Trim                                     *
+*                              StrCat/StrAppend                               *
 *******************************************************************************/
 
-inline std::string Trim(const std::string& s, const std::unordered_set<char>& trimmedChars) {
-  const auto isNotTrimmedChar = [&trimmedChars](char c) { return trimmedChars.find(c) == trimmedChars.end(); };
-  const auto begin = std::find_if(s.begin(), s.end(), isNotTrimmedChar);
-  const auto end = std::find_if(s.rbegin(), s.rend(), isNotTrimmedChar).base();
-  std::string result;
-  if (begin < end) {
-    result.resize(end - begin);
-    std::copy(begin, end, result.begin());
+namespace detail {
+
+/// Whether `EstimateSize` knows the size of `T`
+template<class T>
+inline constexpr bool HasSizeEstimate = std::is_convertible_v<const T&, std::string_view> || std::is_arithmetic_v<T>;
+
+/// Upper bound of the size `AppendValue` produces, 0 if it is not known
+template<class T>
+std::size_t EstimateSize(const T& x) {
+  if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+    return std::string_view{x}.size();
+  } else if constexpr (IsCharLike<T> || std::is_same_v<T, bool>) {
+    return 1;
+  } else if constexpr (std::is_integral_v<T>) {
+    return std::numeric_limits<T>::digits10 + 2;
+  } else if constexpr (std::is_floating_point_v<T>) {
+    return 16;
+  } else {
+    return 0;
   }
+}
+
+}  // namespace utils::detail
+
+/// Appends all the arguments to `dest` with at most one reallocation
+template<class... Args>
+void StrAppend(std::string& dest, const Args&... args) {
+  dest.reserve(dest.size() + (std::size_t{0} + ... + detail::EstimateSize(args)));
+  (AppendValue(dest, args), ...);
+}
+
+/// Concatenates the arguments with a single allocation (as long as all of
+/// them are strings or arithmetic types)
+template<class... Args>
+std::string StrCat(const Args&... args) {
+  std::string result;
+  StrAppend(result, args...);
   return result;
 }
 
+/*******************************************************************************
+*                                    Trim                                     *
+*******************************************************************************/
+
+inline std::string Trim(const std::string& s, const TCharSet& trimmedChars) {
+  const auto begin = FindFirstNotOf(s, trimmedChars);
+  if (begin == std::string_view::npos) {
+    return {};
+  }
+  const auto end = FindLastNotOf(s, trimmedChars) + 1;
+  return s.substr(begin, end - begin);
+}
+
 inline std::string Trim(const std::string& s) {
   return Trim(s, detail::WS);
 }
@@ -96,14 +493,117 @@ inline std::string Trim(const std::string& s) {
 *                                    Split                                    *
 *******************************************************************************/
 
-inline std::vector<std::string> Split(const std::string_view& s, const std::unordered_set<char>& sepChars) {
-  const auto isSepChar = [&sepChars](char c) { return sepChars.find(c) != sepChars.end(); };
-  auto begin = std::find_if_not(s.begin(), s.end(), isSepChar);
-  std::vector<std::string> result;  // TODO: preallocate vector space
-  while (begin != s.end()) {
-    auto end = std::find_if(begin, s.end(), isSepChar);
-    result.emplace_back(begin, end);
-    begin = std::find_if_not(end, s.end(), isSepChar);
+namespace detail {
+
+/// Lazy sequence of `std::string_view` tokens of `Text`. Tokens are either
+/// the non-empty runs of non-separator characters (`Split` semantics) or the
+/// lines of the text without their terminators (`SplitLines` semantics).
+struct TSplitView : TViewTag {
+  struct TIterator;
+  friend TIterator;
+
+  using iterator = TIterator;
+  using value_type = std::string_view;
+
+  constexpr TSplitView(std::string_view text, const TCharSet& separators, bool lines)
+    : Text{text}, Separators{separators}, Lines{lines} {}
+
+  struct TIterator {
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::string_view;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const std::string_view*;
+    using reference = std::string_view;
+
+    TIterator(const TSplitView* r, std::size_t begin) : UnderlyingRange{r}, Begin{begin} {
+      SeekEnd();
+    }
+
+    TIterator& operator++() {
+      const auto& r = *UnderlyingRange;
+      Begin = r.Lines ? End + 1 : FindFirstNotOf(r.Text, r.Separators, End);
+      SeekEnd();
+      return *this;
+    }
+
+    TIterator operator++(int) {
+      auto result = *this;
+      ++*this;
+      return result;
+    }
+
+    std::string_view operator*() const {
+      auto token = UnderlyingRange->Text.substr(Begin, End - Begin);
+      if (UnderlyingRange->Lines && !token.empty() && token.back() == '\r') {
+        token.remove_suffix(1);
+      }
+      return token;
+    }
+
+    friend bool operator==(const TIterator &lhs, const TIterator &rhs) {
+      return lhs.UnderlyingRange == rhs.UnderlyingRange && (lhs.IsEnd() ? rhs.IsEnd() : lhs.Begin == rhs.Begin);
+    }
+    friend bool operator==(const TIterator &lhs, const TSentinel&) {
+      return lhs.IsEnd();
+    }
+    friend bool operator==(const TSentinel&, const TIterator &rhs) {
+      return rhs.IsEnd();
+    }
+    friend bool operator!=(const TIterator &lhs, const TIterator &rhs) {
+      return !(lhs == rhs);
+    }
+    friend bool operator!=(const TIterator &lhs, const TSentinel &rhs) {
+      return !(lhs == rhs);
+    }
+    friend bool operator!=(const TSentinel &lhs, const TIterator &rhs) {
+      return !(lhs == rhs);
+    }
+  private:
+    bool IsEnd() const { return Begin >= UnderlyingRange->Text.size(); }
+
+    void SeekEnd() {
+      if (!IsEnd()) {
+        End = std::min(FindFirstOf(UnderlyingRange->Text, UnderlyingRange->Separators, Begin), UnderlyingRange->Text.size());
+      }
+    }
+
+    const TSplitView* UnderlyingRange;
+    std::size_t Begin;
+    std::size_t End{0};
+  };
+
+  TIterator begin() const {
+    return TIterator(this, Lines ? 0 : FindFirstNotOf(Text, Separators));
+  }
+
+  constexpr TSentinel end() const {
+    return Sentinel;
+  }
+
+private:
+  std::string_view Text;
+  TCharSet Separators;
+  bool Lines;
+};
+
+}  // namespace utils::detail
+
+/// Lazy `Split`: yields `std::string_view`s into `s` without allocating, and
+/// composes with `Map`, `Filter`, `Zip` and `ToVector`. `s` must outlive it.
+inline detail::TSplitView SplitView(std::string_view s, const TCharSet& sepChars = detail::WS) {
+  return detail::TSplitView{s, sepChars, false};
+}
+
+/// Lazy sequence of the lines of `s`, including empty ones. The terminating
+/// "\n" or "\r\n" is not a part of the line.
+inline detail::TSplitView SplitLines(std::string_view s) {
+  return detail::TSplitView{s, '\n', true};
+}
+
+inline std::vector<std::string> Split(const std::string_view& s, const TCharSet& sepChars) {
+  std::vector<std::string> result;
+  for (auto token : SplitView(s, sepChars)) {
+    result.emplace_back(token);
   }
   return result;
 }
@@ -116,17 +616,42 @@ inline std::vector<std::string> Split(const std::string_view& s) {
 *                                    Join                                     *
 *******************************************************************************/
 
+namespace detail {
+
+/// The elements can be sized in a first pass without computing them twice:
+/// the range can be traversed twice, dereferencing only yields references
+/// and `EstimateSize` knows the size of the elements
+template<class TIterator, class = void>
+inline constexpr bool IsSizedBeforeJoin = false;
+
+template<class TIterator>
+inline constexpr bool IsSizedBeforeJoin<TIterator, std::void_t<typename std::iterator_traits<TIterator>::iterator_category>> =
+  std::is_base_of_v<std::forward_iterator_tag, typename std::iterator_traits<TIterator>::iterator_category>
+  && std::is_reference_v<typename std::iterator_traits<TIterator>::reference>
+  && HasSizeEstimate<std::decay_t<typename std::iterator_traits<TIterator>::reference>>;
+
+}  // namespace utils::detail
+
+/// Joins the elements with `sep`, elements are written with `AppendValue`.
+/// When the elements are strings or numbers stored in a range that can be
+/// traversed twice, the result is sized in advance, so it is allocated once.
 template<typename ItBegin, typename ItEnd>
 inline std::string Join(std::string_view sep, ItBegin begin, ItEnd end) {
-  // TODO: restrictions on types
   std::string result;
+  if constexpr (detail::IsSizedBeforeJoin<ItBegin>) {
+    std::size_t size = 0;
+    for (auto it = begin; it != end; ++it) {
+      size += sep.size() + detail::EstimateSize(*it);
+    }
+    result.reserve(size);
+  }
   if (begin != end) {
-    result = *begin;
-    begin++;
+    AppendValue(result, *begin);
+    ++begin;
     while (begin != end) {
       result.append(sep);
-      result.append(*begin);
-      begin++;
+      AppendValue(result, *begin);
+      ++begin;
     }
   }
   return result;
@@ -146,27 +671,100 @@ inline std::string Join(std::initializer_list<T> l, std::string_view sep = ", ")
 *                                   Replace                                   *
 *******************************************************************************/
 
-inline std::string Replace(std::string_view text, std::vector<std::pair<std::string_view, std::string_view>> replacementPairs) {
-  std::string result; // TODO: reserve space for result
-  for (std::size_t i = 0; i < text.size();) {
-    bool replaced = false;
-    for (const auto& [pattern, replacement] : replacementPairs) {
-      if (text.size() - i < pattern.size()) {
-        continue;
-      }
-      if (text.compare(i, pattern.size(), pattern) == 0) {
-        result.append(replacement);
-        i += pattern.size();
-        replaced = true;
-        break;
-      }
-    }
-    if (!replaced) {
-      result.push_back(text[i]);
-      i++;
-    }
+/// Multi-pattern replacer compiled once into an Aho-Corasick automaton.
+/// Text is scanned left to right; when several patterns match, the one that
+/// starts first wins, and among those starting at the same position either
+/// the first listed (`LeftmostFirst`, same as trying the patterns in order at
+/// every position) or the longest one (`LeftmostLongest`). Replaced text is
+/// not scanned again.
+///
+/// Every byte goes through a single table lookup. The only exception are the
+/// bytes that follow a match which was waiting for a longer candidate, they
+/// are looked up once more after the match is committed.
+class TReplacer {
+public:
+  enum class EMatchKind {
+    LeftmostFirst,
+    LeftmostLongest,
+  };
+
+  /// Incremental replacement over a sequence of chunks. Matches that straddle
+  /// chunk boundaries are found, the unresolved tail of a chunk is kept
+  /// inside (at most the length of the longest pattern).
+  class TStream {
+  public:
+    explicit TStream(const TReplacer& replacer) : Replacer{&replacer} {}
+
+    /// Appends everything that can already be decided about `chunk` to `out`
+    void Feed(std::string_view chunk, std::string& out);
+
+    /// Flushes the remaining text, after that the stream is reset
+    void Finish(std::string& out);
+
+  private:
+    struct TMatch {
+      std::size_t Start;
+      std::size_t End;
+      std::uint32_t Pattern;
+    };
+
+    void Run(std::string_view chunk, std::string& out, bool atEnd);
+    char ByteAt(std::string_view chunk, std::size_t pos) const;
+    void AppendText(std::string_view chunk, std::size_t from, std::size_t to, std::string& out) const;
+
+    const TReplacer* Replacer;
+    std::uint32_t State{0};
+    /// Absolute positions in the concatenation of all chunks
+    std::size_t Consumed{0};
+    std::size_t Emitted{0};
+    std::size_t ChunkBegin{0};
+    /// Bytes `[ChunkBegin - Carry.size(), ChunkBegin)` of the previous chunks
+    std::string Carry;
+    bool HasMatch{false};
+    TMatch Match{};
+  };
+
+  explicit TReplacer(
+    const std::vector<std::pair<std::string_view, std::string_view>>& replacementPairs,
+    EMatchKind kind = EMatchKind::LeftmostFirst
+  );
+
+  std::string Replace(std::string_view text) const;
+
+  /// Appends the result of the replacement to `out`
+  void ReplaceTo(std::string_view text, std::string& out) const;
+
+  TStream Stream() const {
+    return TStream{*this};
   }
-  return result;
+
+private:
+  static constexpr std::int32_t NO_PATTERN = -1;
+
+  struct TState {
+    std::uint32_t Depth{0};
+    /// The longest pattern that ends in this state
+    std::int32_t Match{NO_PATTERN};
+    /// This state is a pattern that can't be beaten by a longer match with
+    /// the same start
+    bool Final{false};
+  };
+
+  std::uint32_t Next(std::uint32_t state, char c) const {
+    return Transitions[state * ClassCount + ByteClass[static_cast<unsigned char>(c)]];
+  }
+
+  EMatchKind Kind;
+  std::vector<std::string> Patterns;
+  std::vector<std::string> Replacements;
+  std::array<std::uint16_t, 256> ByteClass{};
+  std::size_t ClassCount{1};
+  std::vector<TState> States;
+  std::vector<std::uint32_t> Transitions;
+};
+
+inline std::string Replace(std::string_view text, std::vector<std::pair<std::string_view, std::string_view>> replacementPairs) {
+  return TReplacer{replacementPairs}.Replace(text);
 }
 
 }  // namespace utils
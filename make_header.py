@@ -9,9 +9,21 @@ WORK_DIR = Path('.')
 # hardcoded topsort of includes
 INCLUDE_ORDER = [
     'cpputils/common.hh',
+    'cpputils/platform.hh',
+    'cpputils/flat_hash.hh',
+    'cpputils/charset.hh',
+    'cpputils/encoding.hh',
+    'cpputils/parse.hh',
     'cpputils/meta.hh',
     'cpputils/itertools.hh',
+    'cpputils/generator.hh',
+    'cpputils/hash.hh',
+    'cpputils/aggregate.hh',
+    'cpputils/parallel.hh',
     'cpputils/string.hh',
+    'cpputils/arena.hh',
+    'cpputils/io.hh',
+    'cpputils/log.hh',
     'cpputils/debug.hh',
     'cpputils/linalg.hh',
     'cpputils/reflect.hh',
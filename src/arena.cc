@@ -0,0 +1,97 @@
+#include <cpputils/arena.hh>
+
+namespace utils {
+
+/*******************************************************************************
+*                                TStringArena                                 *
+*******************************************************************************/
+
+TStringArena::TStringArena(std::size_t blockSize) : BlockSize{blockSize} {}
+
+char* TStringArena::Allocate(std::size_t size) {
+  Used += size;
+  if (size <= Remaining) {
+    auto* result = Current;
+    Current += size;
+    Remaining -= size;
+    return result;
+  }
+  if (size > BlockSize / 4) {
+    LargeBlocks.push_back(TBlock{std::make_unique<char[]>(size), size});
+    return LargeBlocks.back().Data.get();
+  }
+  if (Current != nullptr) {
+    CurrentBlock++;
+  }
+  if (CurrentBlock == Blocks.size()) {
+    Blocks.push_back(TBlock{std::make_unique<char[]>(BlockSize), BlockSize});
+  }
+  Current = Blocks[CurrentBlock].Data.get() + size;
+  Remaining = BlockSize - size;
+  return Blocks[CurrentBlock].Data.get();
+}
+
+std::string_view TStringArena::Store(std::string_view s) {
+  if (s.empty()) {
+    return {};
+  }
+  char* data = Allocate(s.size());
+  std::copy(s.begin(), s.end(), data);
+  return {data, s.size()};
+}
+
+void TStringArena::Reset() {
+  LargeBlocks.clear();
+  CurrentBlock = 0;
+  Current = nullptr;
+  Remaining = 0;
+  Used = 0;
+}
+
+std::size_t TStringArena::BytesReserved() const {
+  std::size_t result = 0;
+  for (const auto& block : Blocks) {
+    result += block.Size;
+  }
+  for (const auto& block : LargeBlocks) {
+    result += block.Size;
+  }
+  return result;
+}
+
+std::string_view Replace(TStringArena& arena, std::string_view text, const TReplacer& replacer) {
+  auto& scratch = arena.Scratch;
+  scratch.clear();
+  replacer.ReplaceTo(text, scratch);
+  return arena.Store(scratch);
+}
+
+/*******************************************************************************
+*                              TStringInterner                                *
+*******************************************************************************/
+
+TStringInterner::TId TStringInterner::Intern(std::string_view s) {
+  if (const auto it = Ids.find(s); it != Ids.end()) {
+    return it->second;
+  }
+  const auto stored = Arena.Store(s);
+  const auto id = static_cast<TId>(Strings.size());
+  Strings.push_back(stored);
+  Ids.emplace(stored, id);
+  return id;
+}
+
+std::optional<TStringInterner::TId> TStringInterner::Find(std::string_view s) const {
+  if (const auto it = Ids.find(s); it != Ids.end()) {
+    return it->second;
+  }
+  return std::nullopt;
+}
+
+void TStringInterner::Clear() {
+  Ids.clear();
+  Strings.clear();
+  Arena.Reset();
+}
+
+}  // namespace utils
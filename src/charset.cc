@@ -0,0 +1,123 @@
+#include <cpputils/charset.hh>
+#include <cpputils/platform.hh>
+
+#if CPPUTILS_X86
+#include <immintrin.h>
+#endif
+
+namespace utils::detail {
+
+namespace {
+
+std::size_t ScanScalar(const char* data, std::size_t size, const TCharSet& set, bool member) {
+  for (std::size_t i = 0; i < size; i++) {
+    if (set.Contains(data[i]) == member) {
+      return i;
+    }
+  }
+  return size;
+}
+
+#if CPPUTILS_X86
+
+CPPUTILS_TARGET("sse2")
+std::size_t ScanSse2(const char* data, std::size_t size, const TCharSet& set, bool member) {
+  if (!set.IsSmall()) {
+    return ScanScalar(data, size, set, member);
+  }
+  const auto count = set.GetSize();
+  __m128i needles[TCharSet::SMALL_SIZE];
+  for (std::size_t k = 0; k < count; k++) {
+    needles[k] = _mm_set1_epi8(set.Small[k]);
+  }
+  const unsigned flip = member ? 0 : 0xFFFF;
+  std::size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    auto hits = _mm_setzero_si128();
+    for (std::size_t k = 0; k < count; k++) {
+      hits = _mm_or_si128(hits, _mm_cmpeq_epi8(v, needles[k]));
+    }
+    const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hits)) ^ flip;
+    if (mask != 0) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+  return i + ScanScalar(data + i, size - i, set, member);
+}
+
+CPPUTILS_TARGET("avx2")
+std::size_t ScanAvx2(const char* data, std::size_t size, const TCharSet& set, bool member) {
+  const auto low = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(set.Low.data())));
+  const auto high = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(set.High.data())));
+  // 1 << (hi % 8) for every high nibble
+  const auto bits = _mm256_setr_epi8(
+    1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128,
+    1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128
+  );
+  const auto nibble = _mm256_set1_epi8(0x0F);
+  const auto seven = _mm256_set1_epi8(7);
+  const unsigned flip = member ? 0 : 0xFFFFFFFFu;
+  std::size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+    const auto lo = _mm256_and_si256(v, nibble);
+    const auto hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble);
+    const auto row = _mm256_blendv_epi8(
+      _mm256_shuffle_epi8(low, lo),
+      _mm256_shuffle_epi8(high, lo),
+      _mm256_cmpgt_epi8(hi, seven)
+    );
+    const auto bit = _mm256_shuffle_epi8(bits, hi);
+    const auto hits = _mm256_cmpeq_epi8(_mm256_and_si256(row, bit), bit);
+    const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(hits)) ^ flip;
+    if (mask != 0) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+  return i + ScanScalar(data + i, size - i, set, member);
+}
+
+#endif
+
+}  // namespace
+
+bool IsKernelSupported(ECharSetKernel kernel, const TCharSet& set) {
+  switch (kernel) {
+    case ECharSetKernel::Scalar:
+      return true;
+    case ECharSetKernel::Sse2:
+      return platform::HasSse2() && set.IsSmall();
+    case ECharSetKernel::Avx2:
+      return platform::HasAvx2();
+  }
+  return false;
+}
+
+std::size_t ScanCharSet(const char* data, std::size_t size, const TCharSet& set, bool member, ECharSetKernel kernel) {
+  switch (kernel) {
+#if CPPUTILS_X86
+    case ECharSetKernel::Sse2:
+      return ScanSse2(data, size, set, member);
+    case ECharSetKernel::Avx2:
+      return ScanAvx2(data, size, set, member);
+#endif
+    default:
+      return ScanScalar(data, size, set, member);
+  }
+}
+
+std::size_t ScanCharSet(const char* data, std::size_t size, const TCharSet& set, bool member) {
+  if (size < 16) {
+    return ScanScalar(data, size, set, member);
+  }
+  if (IsKernelSupported(ECharSetKernel::Avx2, set)) {
+    return ScanCharSet(data, size, set, member, ECharSetKernel::Avx2);
+  }
+  if (IsKernelSupported(ECharSetKernel::Sse2, set)) {
+    return ScanCharSet(data, size, set, member, ECharSetKernel::Sse2);
+  }
+  return ScanScalar(data, size, set, member);
+}
+
+}  // namespace utils::detail
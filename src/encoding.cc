@@ -0,0 +1,601 @@
+#include <cpputils/encoding.hh>
+#include <cpputils/platform.hh>
+
+#include <cstring>
+
+#if CPPUTILS_X86
+#include <immintrin.h>
+#endif
+
+namespace utils::detail {
+
+namespace {
+
+/*******************************************************************************
+*                                   Scalar                                    *
+*******************************************************************************/
+
+inline unsigned char Byte(const char* data, std::size_t i) {
+  return static_cast<unsigned char>(data[i]);
+}
+
+inline bool IsContinuation(unsigned char c) {
+  return (c & 0xC0) == 0x80;
+}
+
+inline char LowerByte(char c) {
+  const auto byte = static_cast<unsigned char>(c);
+  return static_cast<char>(byte ^ (static_cast<unsigned char>(byte - 'A') < 26 ? 0x20 : 0));
+}
+
+inline char UpperByte(char c) {
+  const auto byte = static_cast<unsigned char>(c);
+  return static_cast<char>(byte ^ (static_cast<unsigned char>(byte - 'a') < 26 ? 0x20 : 0));
+}
+
+bool IsAsciiScalar(const char* data, std::size_t size) {
+  for (std::size_t i = 0; i < size; i++) {
+    if (Byte(data, i) >= 0x80) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool IsValidUtf8Scalar(const char* data, std::size_t size) {
+  std::size_t i = 0;
+  while (i < size) {
+    const auto lead = Byte(data, i);
+    if (lead < 0x80) {
+      i++;
+      continue;
+    }
+    std::size_t length = 0;
+    // the allowed range of the second byte excludes overlong forms, surrogates
+    // and code points above U+10FFFF
+    unsigned char low = 0x80;
+    unsigned char high = 0xBF;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+      length = 2;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+      length = 3;
+      if (lead == 0xE0) {
+        low = 0xA0;
+      } else if (lead == 0xED) {
+        high = 0x9F;
+      }
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+      length = 4;
+      if (lead == 0xF0) {
+        low = 0x90;
+      } else if (lead == 0xF4) {
+        high = 0x8F;
+      }
+    } else {
+      return false;
+    }
+    if (size - i < length) {
+      return false;
+    }
+    const auto second = Byte(data, i + 1);
+    if (second < low || second > high) {
+      return false;
+    }
+    for (std::size_t k = 2; k < length; k++) {
+      if (!IsContinuation(Byte(data, i + k))) {
+        return false;
+      }
+    }
+    i += length;
+  }
+  return true;
+}
+
+std::size_t CountCodePointsScalar(const char* data, std::size_t size) {
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < size; i++) {
+    count += !IsContinuation(Byte(data, i));
+  }
+  return count;
+}
+
+void ToLowerScalar(const char* in, char* out, std::size_t size) {
+  for (std::size_t i = 0; i < size; i++) {
+    out[i] = LowerByte(in[i]);
+  }
+}
+
+void ToUpperScalar(const char* in, char* out, std::size_t size) {
+  for (std::size_t i = 0; i < size; i++) {
+    out[i] = UpperByte(in[i]);
+  }
+}
+
+std::size_t MismatchIgnoreCaseScalar(const char* a, const char* b, std::size_t size) {
+  for (std::size_t i = 0; i < size; i++) {
+    if (LowerByte(a[i]) != LowerByte(b[i])) {
+      return i;
+    }
+  }
+  return size;
+}
+
+constexpr TTextKernels SCALAR_KERNELS{
+  IsAsciiScalar,
+  IsValidUtf8Scalar,
+  CountCodePointsScalar,
+  ToLowerScalar,
+  ToUpperScalar,
+  MismatchIgnoreCaseScalar,
+};
+
+#if CPPUTILS_X86
+
+/*******************************************************************************
+*                                   SSE4.2                                    *
+*******************************************************************************/
+
+// UTF-8 validation follows Keiser & Lemire, "Validating UTF-8 In Less Than One
+// Instruction Per Byte": three nibble lookups over every pair of adjacent bytes
+// classify all errors that are visible within two bytes, and the positions that
+// must hold the 3rd/4th byte of a sequence are checked with saturating
+// subtractions.
+constexpr char TOO_SHORT = 1 << 0;
+constexpr char TOO_LONG = 1 << 1;
+constexpr char OVERLONG_3 = 1 << 2;
+constexpr char TOO_LARGE = 1 << 3;
+constexpr char SURROGATE = 1 << 4;
+constexpr char OVERLONG_2 = 1 << 5;
+constexpr char TOO_LARGE_1000 = 1 << 6;
+constexpr char OVERLONG_4 = 1 << 6;
+constexpr char TWO_CONTS = static_cast<char>(1 << 7);
+constexpr char CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS;
+
+#define CPPUTILS_UTF8_BYTE_1_HIGH \
+  TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, \
+  TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS, \
+  TOO_SHORT | OVERLONG_2, \
+  TOO_SHORT, \
+  TOO_SHORT | OVERLONG_3 | SURROGATE, \
+  TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4
+
+#define CPPUTILS_UTF8_BYTE_1_LOW \
+  CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4, \
+  CARRY | OVERLONG_2, \
+  CARRY, \
+  CARRY, \
+  CARRY | TOO_LARGE, \
+  CARRY | TOO_LARGE | TOO_LARGE_1000, \
+  CARRY | TOO_LARGE | TOO_LARGE_1000, \
+  CARRY | TOO_LARGE | TOO_LARGE_1000, \
+  CARRY | TOO_LARGE | TOO_LARGE_1000, \
+  CARRY | TOO_LARGE | TOO_LARGE_1000, \
+  CARRY | TOO_LARGE | TOO_LARGE_1000, \
+  CARRY | TOO_LARGE | TOO_LARGE_1000, \
+  CARRY | TOO_LARGE | TOO_LARGE_1000, \
+  CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE, \
+  CARRY | TOO_LARGE | TOO_LARGE_1000, \
+  CARRY | TOO_LARGE | TOO_LARGE_1000
+
+#define CPPUTILS_UTF8_BYTE_2_HIGH \
+  TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, \
+  TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4, \
+  TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE, \
+  TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE, \
+  TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE, \
+  TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT
+
+// the last three bytes of a block may not start a sequence longer than the
+// rest of the block
+#define CPPUTILS_UTF8_MAX_TAIL static_cast<char>(0xEF), static_cast<char>(0xDF), static_cast<char>(0xBF)
+
+CPPUTILS_TARGET("sse4.2")
+inline __m128i HighNibbles128(__m128i v) {
+  return _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0F));
+}
+
+struct TUtf8CheckerSse42 {
+  __m128i Error;
+  __m128i PrevInput;
+  __m128i PrevIncomplete;
+
+  CPPUTILS_TARGET("sse4.2")
+  TUtf8CheckerSse42() : Error{_mm_setzero_si128()}, PrevInput{_mm_setzero_si128()}, PrevIncomplete{_mm_setzero_si128()} {}
+
+  CPPUTILS_TARGET("sse4.2")
+  void Check(__m128i input) {
+    if (_mm_movemask_epi8(input) == 0) {
+      Error = _mm_or_si128(Error, PrevIncomplete);
+      PrevIncomplete = _mm_setzero_si128();
+    } else {
+      const auto prev1 = _mm_alignr_epi8(input, PrevInput, 15);
+      const auto prev2 = _mm_alignr_epi8(input, PrevInput, 14);
+      const auto prev3 = _mm_alignr_epi8(input, PrevInput, 13);
+      const auto byte1High = _mm_shuffle_epi8(_mm_setr_epi8(CPPUTILS_UTF8_BYTE_1_HIGH), HighNibbles128(prev1));
+      const auto byte1Low = _mm_shuffle_epi8(_mm_setr_epi8(CPPUTILS_UTF8_BYTE_1_LOW), _mm_and_si128(prev1, _mm_set1_epi8(0x0F)));
+      const auto byte2High = _mm_shuffle_epi8(_mm_setr_epi8(CPPUTILS_UTF8_BYTE_2_HIGH), HighNibbles128(input));
+      const auto special = _mm_and_si128(_mm_and_si128(byte1High, byte1Low), byte2High);
+      // only 111_____ and 1111____ leads reach 0x80 after the subtraction
+      const auto third = _mm_subs_epu8(prev2, _mm_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+      const auto fourth = _mm_subs_epu8(prev3, _mm_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+      const auto must23 = _mm_and_si128(_mm_or_si128(third, fourth), _mm_set1_epi8(TWO_CONTS));
+      Error = _mm_or_si128(Error, _mm_xor_si128(must23, special));
+      const auto maxTail = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, CPPUTILS_UTF8_MAX_TAIL);
+      PrevIncomplete = _mm_subs_epu8(input, maxTail);
+    }
+    PrevInput = input;
+  }
+
+  CPPUTILS_TARGET("sse4.2")
+  bool Finish() const {
+    const auto error = _mm_or_si128(Error, PrevIncomplete);
+    return _mm_testz_si128(error, error) != 0;
+  }
+};
+
+CPPUTILS_TARGET("sse4.2")
+bool IsAsciiSse42(const char* data, std::size_t size) {
+  std::size_t i = 0;
+  for (; i + 64 <= size; i += 64) {
+    const auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    const auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 16));
+    const auto c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 32));
+    const auto d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 48));
+    if (_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d))) != 0) {
+      return false;
+    }
+  }
+  for (; i + 16 <= size; i += 16) {
+    if (_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i))) != 0) {
+      return false;
+    }
+  }
+  return IsAsciiScalar(data + i, size - i);
+}
+
+CPPUTILS_TARGET("sse4.2")
+bool IsValidUtf8Sse42(const char* data, std::size_t size) {
+  TUtf8CheckerSse42 checker;
+  std::size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    checker.Check(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)));
+  }
+  if (i < size) {
+    // zero padding is ASCII, so a truncated sequence shows up as too short
+    char tail[16] = {};
+    std::memcpy(tail, data + i, size - i);
+    checker.Check(_mm_loadu_si128(reinterpret_cast<const __m128i*>(tail)));
+  }
+  return checker.Finish();
+}
+
+CPPUTILS_TARGET("sse4.2")
+std::size_t CountCodePointsSse42(const char* data, std::size_t size) {
+  // continuation bytes are exactly the signed bytes below -64
+  const auto threshold = _mm_set1_epi8(-65);
+  std::size_t count = 0;
+  std::size_t i = 0;
+  while (i + 16 <= size) {
+    // per-byte counters are flushed before they can overflow
+    auto counters = _mm_setzero_si128();
+    for (std::size_t steps = 0; steps < 255 && i + 16 <= size; steps++, i += 16) {
+      const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+      counters = _mm_sub_epi8(counters, _mm_cmpgt_epi8(v, threshold));
+    }
+    const auto sums = _mm_sad_epu8(counters, _mm_setzero_si128());
+    count += static_cast<std::size_t>(_mm_cvtsi128_si64(sums) + _mm_extract_epi64(sums, 1));
+  }
+  return count + CountCodePointsScalar(data + i, size - i);
+}
+
+// flips the case bit of the bytes in [first, first + 26)
+CPPUTILS_TARGET("sse4.2")
+inline __m128i FlipCase128(__m128i v, char first) {
+  const auto shifted = _mm_add_epi8(v, _mm_set1_epi8(static_cast<char>(0x80 - first)));
+  const auto inRange = _mm_cmpgt_epi8(_mm_set1_epi8(-128 + 26), shifted);
+  return _mm_xor_si128(v, _mm_and_si128(inRange, _mm_set1_epi8(0x20)));
+}
+
+CPPUTILS_TARGET("sse4.2")
+void ToLowerSse42(const char* in, char* out, std::size_t size) {
+  std::size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), FlipCase128(v, 'A'));
+  }
+  ToLowerScalar(in + i, out + i, size - i);
+}
+
+CPPUTILS_TARGET("sse4.2")
+void ToUpperSse42(const char* in, char* out, std::size_t size) {
+  std::size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), FlipCase128(v, 'a'));
+  }
+  ToUpperScalar(in + i, out + i, size - i);
+}
+
+CPPUTILS_TARGET("sse4.2")
+std::size_t MismatchIgnoreCaseSse42(const char* a, const char* b, std::size_t size) {
+  std::size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    const auto x = FlipCase128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)), 'A');
+    const auto y = FlipCase128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i)), 'A');
+    const unsigned equal = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)));
+    if (equal != 0xFFFF) {
+      return i + __builtin_ctz(~equal);
+    }
+  }
+  return i + MismatchIgnoreCaseScalar(a + i, b + i, size - i);
+}
+
+constexpr TTextKernels SSE42_KERNELS{
+  IsAsciiSse42,
+  IsValidUtf8Sse42,
+  CountCodePointsSse42,
+  ToLowerSse42,
+  ToUpperSse42,
+  MismatchIgnoreCaseSse42,
+};
+
+/*******************************************************************************
+*                                    AVX2                                     *
+*******************************************************************************/
+
+CPPUTILS_TARGET("avx2")
+inline __m256i HighNibbles256(__m256i v) {
+  return _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0F));
+}
+
+CPPUTILS_TARGET("avx2")
+inline __m256i Broadcast128(__m128i v) {
+  return _mm256_broadcastsi128_si256(v);
+}
+
+struct TUtf8CheckerAvx2 {
+  __m256i Error;
+  __m256i PrevInput;
+  __m256i PrevIncomplete;
+
+  CPPUTILS_TARGET("avx2")
+  TUtf8CheckerAvx2() : Error{_mm256_setzero_si256()}, PrevInput{_mm256_setzero_si256()}, PrevIncomplete{_mm256_setzero_si256()} {}
+
+  CPPUTILS_TARGET("avx2")
+  void Check(__m256i input) {
+    if (_mm256_movemask_epi8(input) == 0) {
+      Error = _mm256_or_si256(Error, PrevIncomplete);
+      PrevIncomplete = _mm256_setzero_si256();
+    } else {
+      // the previous block's upper half followed by this block's lower half,
+      // so that `alignr` can shift bytes across the 128-bit lanes
+      const auto carried = _mm256_permute2x128_si256(PrevInput, input, 0x21);
+      const auto prev1 = _mm256_alignr_epi8(input, carried, 15);
+      const auto prev2 = _mm256_alignr_epi8(input, carried, 14);
+      const auto prev3 = _mm256_alignr_epi8(input, carried, 13);
+      const auto byte1High = _mm256_shuffle_epi8(Broadcast128(_mm_setr_epi8(CPPUTILS_UTF8_BYTE_1_HIGH)), HighNibbles256(prev1));
+      const auto byte1Low = _mm256_shuffle_epi8(
+        Broadcast128(_mm_setr_epi8(CPPUTILS_UTF8_BYTE_1_LOW)),
+        _mm256_and_si256(prev1, _mm256_set1_epi8(0x0F))
+      );
+      const auto byte2High = _mm256_shuffle_epi8(Broadcast128(_mm_setr_epi8(CPPUTILS_UTF8_BYTE_2_HIGH)), HighNibbles256(input));
+      const auto special = _mm256_and_si256(_mm256_and_si256(byte1High, byte1Low), byte2High);
+      const auto third = _mm256_subs_epu8(prev2, _mm256_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+      const auto fourth = _mm256_subs_epu8(prev3, _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+      const auto must23 = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8(TWO_CONTS));
+      Error = _mm256_or_si256(Error, _mm256_xor_si256(must23, special));
+      const auto maxTail = _mm256_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, CPPUTILS_UTF8_MAX_TAIL
+      );
+      PrevIncomplete = _mm256_subs_epu8(input, maxTail);
+    }
+    PrevInput = input;
+  }
+
+  CPPUTILS_TARGET("avx2")
+  bool Finish() const {
+    const auto error = _mm256_or_si256(Error, PrevIncomplete);
+    return _mm256_testz_si256(error, error) != 0;
+  }
+};
+
+#undef CPPUTILS_UTF8_BYTE_1_HIGH
+#undef CPPUTILS_UTF8_BYTE_1_LOW
+#undef CPPUTILS_UTF8_BYTE_2_HIGH
+#undef CPPUTILS_UTF8_MAX_TAIL
+
+CPPUTILS_TARGET("avx2")
+bool IsAsciiAvx2(const char* data, std::size_t size) {
+  std::size_t i = 0;
+  for (; i + 128 <= size; i += 128) {
+    const auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+    const auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 32));
+    const auto c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 64));
+    const auto d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 96));
+    if (_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(a, b), _mm256_or_si256(c, d))) != 0) {
+      return false;
+    }
+  }
+  for (; i + 32 <= size; i += 32) {
+    if (_mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i))) != 0) {
+      return false;
+    }
+  }
+  return IsAsciiScalar(data + i, size - i);
+}
+
+CPPUTILS_TARGET("avx2")
+bool IsValidUtf8Avx2(const char* data, std::size_t size) {
+  TUtf8CheckerAvx2 checker;
+  std::size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    checker.Check(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)));
+  }
+  if (i < size) {
+    char tail[32] = {};
+    std::memcpy(tail, data + i, size - i);
+    checker.Check(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(tail)));
+  }
+  return checker.Finish();
+}
+
+CPPUTILS_TARGET("avx2")
+std::size_t CountCodePointsAvx2(const char* data, std::size_t size) {
+  const auto threshold = _mm256_set1_epi8(-65);
+  std::size_t count = 0;
+  std::size_t i = 0;
+  while (i + 32 <= size) {
+    auto counters = _mm256_setzero_si256();
+    for (std::size_t steps = 0; steps < 255 && i + 32 <= size; steps++, i += 32) {
+      const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+      counters = _mm256_sub_epi8(counters, _mm256_cmpgt_epi8(v, threshold));
+    }
+    const auto sums = _mm256_sad_epu8(counters, _mm256_setzero_si256());
+    count += static_cast<std::size_t>(
+      _mm256_extract_epi64(sums, 0) + _mm256_extract_epi64(sums, 1) +
+      _mm256_extract_epi64(sums, 2) + _mm256_extract_epi64(sums, 3)
+    );
+  }
+  return count + CountCodePointsScalar(data + i, size - i);
+}
+
+CPPUTILS_TARGET("avx2")
+inline __m256i FlipCase256(__m256i v, char first) {
+  const auto shifted = _mm256_add_epi8(v, _mm256_set1_epi8(static_cast<char>(0x80 - first)));
+  const auto inRange = _mm256_cmpgt_epi8(_mm256_set1_epi8(-128 + 26), shifted);
+  return _mm256_xor_si256(v, _mm256_and_si256(inRange, _mm256_set1_epi8(0x20)));
+}
+
+CPPUTILS_TARGET("avx2")
+void ToLowerAvx2(const char* in, char* out, std::size_t size) {
+  std::size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), FlipCase256(v, 'A'));
+  }
+  ToLowerScalar(in + i, out + i, size - i);
+}
+
+CPPUTILS_TARGET("avx2")
+void ToUpperAvx2(const char* in, char* out, std::size_t size) {
+  std::size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), FlipCase256(v, 'a'));
+  }
+  ToUpperScalar(in + i, out + i, size - i);
+}
+
+CPPUTILS_TARGET("avx2")
+std::size_t MismatchIgnoreCaseAvx2(const char* a, const char* b, std::size_t size) {
+  std::size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    const auto x = FlipCase256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)), 'A');
+    const auto y = FlipCase256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)), 'A');
+    const unsigned equal = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y)));
+    if (equal != 0xFFFFFFFFu) {
+      return i + __builtin_ctz(~equal);
+    }
+  }
+  return i + MismatchIgnoreCaseScalar(a + i, b + i, size - i);
+}
+
+constexpr TTextKernels AVX2_KERNELS{
+  IsAsciiAvx2,
+  IsValidUtf8Avx2,
+  CountCodePointsAvx2,
+  ToLowerAvx2,
+  ToUpperAvx2,
+  MismatchIgnoreCaseAvx2,
+};
+
+#endif
+
+}  // namespace
+
+bool IsKernelSupported(ETextKernel kernel) {
+  switch (kernel) {
+    case ETextKernel::Scalar:
+      return true;
+    case ETextKernel::Sse42:
+      return platform::HasSse42();
+    case ETextKernel::Avx2:
+      return platform::HasAvx2();
+  }
+  return false;
+}
+
+const TTextKernels& GetTextKernels(ETextKernel kernel) {
+  switch (kernel) {
+#if CPPUTILS_X86
+    case ETextKernel::Sse42:
+      return SSE42_KERNELS;
+    case ETextKernel::Avx2:
+      return AVX2_KERNELS;
+#endif
+    default:
+      return SCALAR_KERNELS;
+  }
+}
+
+const TTextKernels& GetTextKernels() {
+  static const TTextKernels& best = [] () -> const TTextKernels& {
+    for (const auto kernel : {ETextKernel::Avx2, ETextKernel::Sse42}) {
+      if (IsKernelSupported(kernel)) {
+        return GetTextKernels(kernel);
+      }
+    }
+    return SCALAR_KERNELS;
+  }();
+  return best;
+}
+
+}  // namespace utils::detail
+
+namespace utils {
+
+int CompareIgnoreCase(std::string_view a, std::string_view b) {
+  const auto common = std::min(a.size(), b.size());
+  const auto i = detail::GetTextKernels().MismatchIgnoreCase(a.data(), b.data(), common);
+  if (i < common) {
+    return static_cast<int>(static_cast<unsigned char>(detail::LowerByte(a[i]))) -
+      static_cast<int>(static_cast<unsigned char>(detail::LowerByte(b[i])));
+  }
+  return a.size() < b.size() ? -1 : (a.size() > b.size() ? 1 : 0);
+}
+
+u64 HashIgnoreCase(std::string_view s) {
+  constexpr u64 MULTIPLIER = 0x9E3779B97F4A7C15ull;
+  const auto& kernels = detail::GetTextKernels();
+  u64 hash = s.size() * MULTIPLIER;
+  // lowercase through a stack buffer so that the hash doesn't depend on the
+  // kernel and doesn't allocate
+  alignas(32) char buffer[256];
+  for (std::size_t offset = 0; offset < s.size(); offset += sizeof(buffer)) {
+    const auto chunk = std::min(sizeof(buffer), s.size() - offset);
+    kernels.ToLower(s.data() + offset, buffer, chunk);
+    std::size_t i = 0;
+    for (; i + 8 <= chunk; i += 8) {
+      u64 word;
+      std::memcpy(&word, buffer + i, 8);
+      hash = (hash ^ word) * MULTIPLIER;
+      hash ^= hash >> 29;
+    }
+    if (i < chunk) {
+      u64 word = 0;
+      std::memcpy(&word, buffer + i, chunk - i);
+      hash = (hash ^ word) * MULTIPLIER;
+      hash ^= hash >> 29;
+    }
+  }
+  // murmur3 finalizer
+  hash ^= hash >> 33;
+  hash *= 0xFF51AFD7ED558CCDull;
+  hash ^= hash >> 33;
+  hash *= 0xC4CEB93FE53A87E3ull;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+}  // namespace utils
@@ -0,0 +1,90 @@
+#include <cpputils/generator.hh>
+
+#include <array>
+#include <new>
+#include <utility>
+
+namespace utils::detail {
+
+namespace {
+
+/// Frames kept per size class, the rest is returned to `operator delete`
+constexpr std::size_t MAX_FREE_FRAMES = 64;
+constexpr std::size_t SIZE_CLASSES = MAX_POOLED_FRAME / FRAME_SIZE_CLASS;
+
+/// Trivially destructible, so it can still be read after the pool of the
+/// thread is destroyed: thread_local destructors run before the static ones,
+/// which may destroy generators
+thread_local bool FramePoolDestroyed = false;
+
+struct TFreeFrame {
+  TFreeFrame* Next;
+};
+
+class TFramePool {
+public:
+  TFramePool() = default;
+  TFramePool(const TFramePool&) = delete;
+  TFramePool& operator=(const TFramePool&) = delete;
+
+  ~TFramePool() {
+    FramePoolDestroyed = true;
+    for (auto* frame : FreeLists) {
+      while (frame) {
+        ::operator delete(std::exchange(frame, frame->Next));
+      }
+    }
+  }
+
+  void* Allocate(std::size_t size) {
+    const auto sizeClass = SizeClass(size);
+    if (sizeClass >= SIZE_CLASSES) {
+      return ::operator new(size);
+    }
+    if (auto* frame = FreeLists[sizeClass]) {
+      FreeLists[sizeClass] = frame->Next;
+      FreeCounts[sizeClass]--;
+      return frame;
+    }
+    return ::operator new((sizeClass + 1) * FRAME_SIZE_CLASS);
+  }
+
+  void Deallocate(void* frame, std::size_t size) noexcept {
+    const auto sizeClass = SizeClass(size);
+    if (sizeClass >= SIZE_CLASSES || FreeCounts[sizeClass] == MAX_FREE_FRAMES) {
+      ::operator delete(frame);
+      return;
+    }
+    FreeLists[sizeClass] = new (frame) TFreeFrame{FreeLists[sizeClass]};
+    FreeCounts[sizeClass]++;
+  }
+
+private:
+  static std::size_t SizeClass(std::size_t size) {
+    return (size - 1) / FRAME_SIZE_CLASS;
+  }
+
+  std::array<TFreeFrame*, SIZE_CLASSES> FreeLists{};
+  std::array<std::size_t, SIZE_CLASSES> FreeCounts{};
+};
+
+thread_local TFramePool FramePool;
+
+}  // namespace
+
+void* AllocateFrame(std::size_t size) {
+  if (FramePoolDestroyed) {
+    return ::operator new(size);
+  }
+  return FramePool.Allocate(size);
+}
+
+void DeallocateFrame(void* frame, std::size_t size) noexcept {
+  if (FramePoolDestroyed) {
+    ::operator delete(frame);
+    return;
+  }
+  FramePool.Deallocate(frame, size);
+}
+
+}  // namespace utils::detail
@@ -0,0 +1,224 @@
+#include <cpputils/hash.hh>
+#include <cpputils/platform.hh>
+
+#include <array>
+#include <cstring>
+
+#if CPPUTILS_X86
+#include <immintrin.h>
+#endif
+
+namespace utils::detail {
+
+namespace {
+
+/*******************************************************************************
+*                                   Common                                    *
+*******************************************************************************/
+
+/// Inputs up to this size are hashed 16 bytes at a time with wyhash steps,
+/// longer ones in 8 independent lanes
+constexpr std::size_t HASH_MEDIUM_INPUT = 128;
+constexpr std::size_t LANES = 8;
+constexpr std::size_t STRIPE = LANES * sizeof(u64);
+/// The lanes are scrambled after every block of stripes, so that a
+/// difference in one stripe can't be cancelled out in a later one
+constexpr std::size_t STRIPES_PER_BLOCK = 16;
+constexpr u64 LANE_PRIME = 0x9E3779B1ull;
+
+/// Stripe `i` of a block is keyed with `SECRET[i % 16, i % 16 + 8)`, the
+/// last stripe of the input with `SECRET[16, 24)`
+constexpr std::array<u64, STRIPES_PER_BLOCK + LANES> MakeSecret() {
+  std::array<u64, STRIPES_PER_BLOCK + LANES> result{};
+  u64 state = 0x2545F4914F6CDD1Dull;
+  for (auto& x : result) {
+    // splitmix64
+    state += 0x9E3779B97F4A7C15ull;
+    auto z = state;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    x = z ^ (z >> 31);
+  }
+  return result;
+}
+
+constexpr auto SECRET = MakeSecret();
+constexpr const u64* SCRAMBLE_KEY = SECRET.data() + 3;
+constexpr const u64* LAST_STRIPE_KEY = SECRET.data() + STRIPES_PER_BLOCK;
+
+inline u64 Read64(const char* p) {
+  u64 result;
+  std::memcpy(&result, p, sizeof(result));
+  return result;
+}
+
+u64 HashMedium(const char* data, std::size_t size, u64 seed) {
+  seed ^= MulFold(seed ^ HASH_PRIME0, HASH_PRIME1);
+  for (std::size_t i = 0; i + 16 < size; i += 16) {
+    seed = MulFold(Read64(data + i) ^ HASH_PRIME1, Read64(data + i + 8) ^ seed);
+  }
+  const auto a = Read64(data + size - 16);
+  const auto b = Read64(data + size - 8);
+  return MulFold(MulFold(a ^ HASH_PRIME1, b ^ seed) ^ HASH_PRIME0 ^ size, HASH_PRIME1);
+}
+
+void InitLanes(u64* lanes, u64 seed) {
+  for (std::size_t i = 0; i < LANES; i++) {
+    lanes[i] = SECRET[i] + (i % 2 == 0 ? seed : ~seed);
+  }
+}
+
+u64 FinishLanes(const u64* lanes, std::size_t size, u64 seed) {
+  u64 hash = size * HASH_PRIME0 ^ seed;
+  for (std::size_t i = 0; i < LANES; i += 2) {
+    hash += MulFold(lanes[i] ^ SECRET[LANES + i], lanes[i + 1] ^ SECRET[LANES + i + 1]);
+  }
+  // murmur3 finalizer
+  hash ^= hash >> 33;
+  hash *= 0xFF51AFD7ED558CCDull;
+  hash ^= hash >> 33;
+  hash *= 0xC4CEB93FE53A87E3ull;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+/// Number of whole stripes before the last one. The last stripe always
+/// ends at the end of the input and may overlap with the previous one.
+inline std::size_t LeadingStripes(std::size_t size) {
+  return (size - 1) / STRIPE;
+}
+
+/*******************************************************************************
+*                                   Scalar                                    *
+*******************************************************************************/
+
+void AccumulateScalar(u64* lanes, const char* stripe, const u64* key) {
+  for (std::size_t i = 0; i < LANES; i++) {
+    const auto value = Read64(stripe + i * sizeof(u64));
+    const auto keyed = value ^ key[i];
+    lanes[i ^ 1] += value;
+    lanes[i] += (keyed & 0xFFFFFFFF) * (keyed >> 32);
+  }
+}
+
+void ScrambleScalar(u64* lanes) {
+  for (std::size_t i = 0; i < LANES; i++) {
+    lanes[i] ^= lanes[i] >> 47;
+    lanes[i] ^= SCRAMBLE_KEY[i];
+    lanes[i] *= LANE_PRIME;
+  }
+}
+
+u64 HashLongScalar(const char* data, std::size_t size, u64 seed) {
+  if (size <= HASH_MEDIUM_INPUT) {
+    return HashMedium(data, size, seed);
+  }
+  u64 lanes[LANES];
+  InitLanes(lanes, seed);
+  const auto stripes = LeadingStripes(size);
+  for (std::size_t s = 0; s < stripes; s++) {
+    AccumulateScalar(lanes, data + s * STRIPE, SECRET.data() + s % STRIPES_PER_BLOCK);
+    if (s % STRIPES_PER_BLOCK == STRIPES_PER_BLOCK - 1) {
+      ScrambleScalar(lanes);
+    }
+  }
+  AccumulateScalar(lanes, data + size - STRIPE, LAST_STRIPE_KEY);
+  return FinishLanes(lanes, size, seed);
+}
+
+constexpr THashKernels SCALAR_HASH_KERNELS{
+  HashLongScalar,
+};
+
+/*******************************************************************************
+*                                    AVX2                                     *
+*******************************************************************************/
+
+#if CPPUTILS_X86
+
+/// The scalar lanes 0-3 and 4-7 in two registers. Swapping the neighbour
+/// lanes never crosses a 128-bit half, so it is a single in-lane shuffle.
+CPPUTILS_TARGET("avx2")
+inline __m256i AccumulateAvx2(__m256i lanes, const char* data, const u64* key) {
+  const auto value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+  const auto keyed = _mm256_xor_si256(value, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(key)));
+  const auto product = _mm256_mul_epu32(keyed, _mm256_srli_epi64(keyed, 32));
+  const auto swapped = _mm256_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2));
+  return _mm256_add_epi64(lanes, _mm256_add_epi64(product, swapped));
+}
+
+CPPUTILS_TARGET("avx2")
+inline __m256i ScrambleAvx2(__m256i lanes, const u64* key) {
+  lanes = _mm256_xor_si256(lanes, _mm256_srli_epi64(lanes, 47));
+  lanes = _mm256_xor_si256(lanes, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(key)));
+  // 64-bit by 32-bit multiplication from two 32x32 products
+  const auto prime = _mm256_set1_epi64x(static_cast<long long>(LANE_PRIME));
+  const auto low = _mm256_mul_epu32(lanes, prime);
+  const auto high = _mm256_mul_epu32(_mm256_srli_epi64(lanes, 32), prime);
+  return _mm256_add_epi64(low, _mm256_slli_epi64(high, 32));
+}
+
+CPPUTILS_TARGET("avx2")
+u64 HashLongAvx2(const char* data, std::size_t size, u64 seed) {
+  if (size <= HASH_MEDIUM_INPUT) {
+    return HashMedium(data, size, seed);
+  }
+  alignas(32) u64 lanes[LANES];
+  InitLanes(lanes, seed);
+  auto low = _mm256_load_si256(reinterpret_cast<const __m256i*>(lanes));
+  auto high = _mm256_load_si256(reinterpret_cast<const __m256i*>(lanes + 4));
+  const auto stripes = LeadingStripes(size);
+  for (std::size_t s = 0; s < stripes; s++) {
+    const auto* stripe = data + s * STRIPE;
+    const auto* key = SECRET.data() + s % STRIPES_PER_BLOCK;
+    low = AccumulateAvx2(low, stripe, key);
+    high = AccumulateAvx2(high, stripe + 32, key + 4);
+    if (s % STRIPES_PER_BLOCK == STRIPES_PER_BLOCK - 1) {
+      low = ScrambleAvx2(low, SCRAMBLE_KEY);
+      high = ScrambleAvx2(high, SCRAMBLE_KEY + 4);
+    }
+  }
+  low = AccumulateAvx2(low, data + size - STRIPE, LAST_STRIPE_KEY);
+  high = AccumulateAvx2(high, data + size - STRIPE + 32, LAST_STRIPE_KEY + 4);
+  _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), low);
+  _mm256_store_si256(reinterpret_cast<__m256i*>(lanes + 4), high);
+  return FinishLanes(lanes, size, seed);
+}
+
+constexpr THashKernels AVX2_HASH_KERNELS{
+  HashLongAvx2,
+};
+
+#endif
+
+}  // namespace
+
+bool IsKernelSupported(EHashKernel kernel) {
+  switch (kernel) {
+    case EHashKernel::Scalar:
+      return true;
+    case EHashKernel::Avx2:
+      return platform::HasAvx2();
+  }
+  return false;
+}
+
+const THashKernels& GetHashKernels(EHashKernel kernel) {
+  switch (kernel) {
+#if CPPUTILS_X86
+    case EHashKernel::Avx2:
+      return AVX2_HASH_KERNELS;
+#endif
+    default:
+      return SCALAR_HASH_KERNELS;
+  }
+}
+
+const THashKernels& GetHashKernels() {
+  static const THashKernels& best = IsKernelSupported(EHashKernel::Avx2)
+    ? GetHashKernels(EHashKernel::Avx2)
+    : SCALAR_HASH_KERNELS;
+  return best;
+}
+
+}  // namespace utils::detail
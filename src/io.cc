@@ -0,0 +1,234 @@
+#include <cpputils/io.hh>
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace utils {
+
+namespace {
+
+constexpr std::size_t READ_BLOCK_SIZE = 1 << 20;
+
+/// Makes the names of temporary files unique within the process
+std::atomic<u64> TemporaryFileCounter{0};
+
+[[noreturn]] void ThrowErrno(std::string_view action, const std::string& path) {
+  throw std::runtime_error(Format(FMT("Can't % %: %"), action, path, std::strerror(errno)));
+}
+
+class TFd {
+public:
+  explicit TFd(int fd) : Fd{fd} {}
+  ~TFd() {
+    if (Fd >= 0) {
+      ::close(Fd);
+    }
+  }
+  TFd(const TFd&) = delete;
+  TFd& operator=(const TFd&) = delete;
+
+  int Get() const {
+    return Fd;
+  }
+
+private:
+  int Fd;
+};
+
+void WriteAll(int fd, const char* data, std::size_t size, const std::string& path) {
+  while (size > 0) {
+    const auto written = ::write(fd, data, size);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      ThrowErrno("write to", path);
+    }
+    data += written;
+    size -= written;
+  }
+}
+
+}  // namespace
+
+/*******************************************************************************
+*                                  ReadFile                                   *
+*******************************************************************************/
+
+TFileContents::~TFileContents() {
+  if (Mapped) {
+    ::munmap(const_cast<char*>(Data), Size);
+  }
+}
+
+TFileContents::TFileContents(TFileContents&& other) noexcept {
+  *this = std::move(other);
+}
+
+TFileContents& TFileContents::operator=(TFileContents&& other) noexcept {
+  if (this != &other) {
+    if (Mapped) {
+      ::munmap(const_cast<char*>(Data), Size);
+    }
+    Mapped = other.Mapped;
+    Size = other.Size;
+    Buffer = std::move(other.Buffer);
+    Data = Mapped ? other.Data : Buffer.data();
+    other.Data = nullptr;
+    other.Size = 0;
+    other.Mapped = false;
+  }
+  return *this;
+}
+
+TFileContents ReadFile(const std::string& path) {
+  TFd fd{::open(path.c_str(), O_RDONLY | O_CLOEXEC)};
+  if (fd.Get() < 0) {
+    ThrowErrno("open", path);
+  }
+  struct stat st;
+  if (::fstat(fd.Get(), &st) != 0) {
+    ThrowErrno("stat", path);
+  }
+
+  TFileContents result;
+  if (S_ISREG(st.st_mode) && st.st_size > 0) {
+    void* data = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd.Get(), 0);
+    if (data != MAP_FAILED) {
+      ::madvise(data, st.st_size, MADV_SEQUENTIAL);
+      result.Data = static_cast<const char*>(data);
+      result.Size = st.st_size;
+      result.Mapped = true;
+      return result;
+    }
+  }
+
+  auto& buffer = result.Buffer;
+  std::size_t size = 0;
+  while (true) {
+    if (buffer.size() - size < READ_BLOCK_SIZE) {
+      buffer.resize(size + READ_BLOCK_SIZE);
+    }
+    const auto count = ::read(fd.Get(), buffer.data() + size, buffer.size() - size);
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      ThrowErrno("read", path);
+    }
+    if (count == 0) {
+      break;
+    }
+    size += count;
+  }
+  buffer.resize(size);
+  result.Data = buffer.data();
+  result.Size = size;
+  return result;
+}
+
+/*******************************************************************************
+*                                  WriteFile                                  *
+*******************************************************************************/
+
+TFileWriter::TFileWriter(const std::string& path, EWriteMode mode, std::size_t bufferSize)
+  : Path{path}, Mode{mode}, BufferSize{bufferSize} {
+  Buffer.reserve(BufferSize);
+  switch (Mode) {
+    case EWriteMode::Truncate:
+      Fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+      break;
+    case EWriteMode::Append:
+      Fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0666);
+      break;
+    case EWriteMode::Atomic: {
+      // Not mkstemp: it creates the file with 0600, while the kernel applies
+      // the umask to 0666 here like for the other modes
+      do {
+        TemporaryPath = StrCat(
+          path, ".tmp.", ::getpid(), ".", TemporaryFileCounter.fetch_add(1, std::memory_order_relaxed)
+        );
+        Fd = ::open(TemporaryPath.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+      } while (Fd < 0 && errno == EEXIST);
+      // An existing target keeps its mode, as it does when truncated
+      struct stat target;
+      if (Fd >= 0 && ::stat(path.c_str(), &target) == 0) {
+        ::fchmod(Fd, target.st_mode & 07777);
+      }
+      break;
+    }
+  }
+  if (Fd < 0) {
+    ThrowErrno("open", Mode == EWriteMode::Atomic ? TemporaryPath : path);
+  }
+}
+
+TFileWriter::~TFileWriter() {
+  if (Fd < 0) {
+    return;
+  }
+  if (Mode == EWriteMode::Atomic) {
+    ::close(Fd);
+    ::unlink(TemporaryPath.c_str());
+    return;
+  }
+  try {
+    Close();
+  } catch (...) {
+    // Destructors must not throw, call `Close` to see the errors
+  }
+}
+
+void TFileWriter::Write(std::string_view data) {
+  if (Buffer.size() + data.size() <= BufferSize) {
+    Buffer.append(data);
+    return;
+  }
+  Flush();
+  if (data.size() >= BufferSize) {
+    WriteAll(Fd, data.data(), data.size(), Path);
+  } else {
+    Buffer.append(data);
+  }
+}
+
+void TFileWriter::Flush() {
+  WriteAll(Fd, Buffer.data(), Buffer.size(), Path);
+  Buffer.clear();
+}
+
+void TFileWriter::Close() {
+  if (Fd < 0) {
+    return;
+  }
+  Flush();
+  if (Mode == EWriteMode::Atomic && ::fsync(Fd) != 0) {
+    ThrowErrno("sync", TemporaryPath);
+  }
+  const int fd = Fd;
+  Fd = -1;
+  if (::close(fd) != 0) {
+    ThrowErrno("close", Path);
+  }
+  if (Mode == EWriteMode::Atomic && ::rename(TemporaryPath.c_str(), Path.c_str()) != 0) {
+    const auto error = errno;
+    ::unlink(TemporaryPath.c_str());
+    errno = error;
+    ThrowErrno("rename to", Path);
+  }
+}
+
+void WriteFile(const std::string& path, std::string_view data, EWriteMode mode) {
+  TFileWriter writer{path, mode, 0};
+  writer.Write(data);
+  writer.Close();
+}
+
+}  // namespace utils
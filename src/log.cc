@@ -0,0 +1,286 @@
+#include <cpputils/log.hh>
+
+#include <cerrno>
+#include <climits>
+#include <ctime>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace utils {
+
+namespace {
+
+std::atomic<u64> LoggerIds{0};
+std::atomic<TLogger*> GlobalLogger{nullptr};
+
+constexpr std::string_view LEVEL_NAMES[] = {"TRACE", "DEBUG", "INFO", "WARNING", "ERROR", "OFF"};
+
+std::size_t RoundUpToPowerOfTwo(std::size_t x) {
+  std::size_t result = 64;
+  while (result < x) {
+    result *= 2;
+  }
+  return result;
+}
+
+/// "2024-02-13 12:34:56.123456 "
+void AppendTimestamp(std::string& out, i64 timestampNs) {
+  thread_local i64 cachedSecond = -1;
+  thread_local char cachedPrefix[32];
+  const auto second = timestampNs / 1'000'000'000;
+  if (second != cachedSecond) {
+    const std::time_t t = second;
+    std::tm tm;
+    ::gmtime_r(&t, &tm);
+    std::strftime(cachedPrefix, sizeof(cachedPrefix), "%Y-%m-%d %H:%M:%S.", &tm);
+    cachedSecond = second;
+  }
+  out.append(cachedPrefix);
+  const auto micros = (timestampNs / 1000) % 1'000'000;
+  char digits[6];
+  auto value = micros;
+  for (int i = 5; i >= 0; i--) {
+    digits[i] = static_cast<char>('0' + value % 10);
+    value /= 10;
+  }
+  out.append(digits, sizeof(digits));
+  out.push_back(' ');
+}
+
+}  // namespace
+
+namespace detail {
+
+TLogRing::TLogRing(std::size_t capacity)
+  : Data{std::make_unique<char[]>(RoundUpToPowerOfTwo(capacity))}
+  , Capacity{RoundUpToPowerOfTwo(capacity)} {}
+
+char* TLogRing::Reserve(std::size_t size) {
+  auto tail = Tail.load(std::memory_order_relaxed);
+  const auto fits = [&](std::size_t bytes) {
+    if (tail + bytes - CachedHead > Capacity) {
+      CachedHead = Head.load(std::memory_order_acquire);
+    }
+    return tail + bytes - CachedHead <= Capacity;
+  };
+  const auto index = tail & (Capacity - 1);
+  if (index + size > Capacity) {
+    // Records are contiguous, so the end of the ring is skipped. The padding
+    // is committed on its own, so that a record that doesn't fit yet starts
+    // at the beginning of the ring when it is retried.
+    const auto padding = Capacity - index;
+    if (!fits(padding)) {
+      return nullptr;
+    }
+    if (padding >= sizeof(TLogRecordHeader)) {
+      const TLogRecordHeader header{static_cast<u32>(padding), ELogLevel::Off, nullptr, 0};
+      std::memcpy(Data.get() + index, &header, sizeof(header));
+    }
+    tail += padding;
+    Tail.store(tail, std::memory_order_release);
+  }
+  if (!fits(size)) {
+    return nullptr;
+  }
+  return Data.get() + (tail & (Capacity - 1));
+}
+
+}  // namespace utils::detail
+
+/*******************************************************************************
+*                                   TLogger                                   *
+*******************************************************************************/
+
+TLogger::TLogger(int fd, TLoggerOptions options)
+  : Id{LoggerIds.fetch_add(1)}
+  , Options{options}
+  , Level{options.Level}
+  , Fd{fd}
+  , OwnsFd{false}
+{
+  Worker = std::thread([this] { Run(); });
+}
+
+TLogger::TLogger(const std::string& path, TLoggerOptions options)
+  : Id{LoggerIds.fetch_add(1)}
+  , Options{options}
+  , Level{options.Level}
+  , Fd{::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0666)}
+  , OwnsFd{true}
+{
+  if (Fd < 0) {
+    throw std::runtime_error(Format(FMT("Can't open log file %: %"), path, std::strerror(errno)));
+  }
+  Worker = std::thread([this] { Run(); });
+}
+
+TLogger::~TLogger() {
+  TLogger* self = this;
+  GlobalLogger.compare_exchange_strong(self, nullptr);
+  Stopping.store(true);
+  Worker.join();
+  std::lock_guard guard{RingsLock};
+  for (const auto& ring : Rings) {
+    ring->Orphaned.store(true);
+  }
+  if (OwnsFd) {
+    ::close(Fd);
+  }
+}
+
+detail::TLogRing& TLogger::GetRing() {
+  struct TThreadRing {
+    u64 LoggerId;
+    std::shared_ptr<detail::TLogRing> Ring;
+  };
+  thread_local std::vector<TThreadRing> threadRings;
+  for (const auto& [loggerId, ring] : threadRings) {
+    if (loggerId == Id) {
+      return *ring;
+    }
+  }
+  threadRings.erase(
+    std::remove_if(threadRings.begin(), threadRings.end(), [](const auto& r) { return r.Ring->Orphaned.load(); }),
+    threadRings.end()
+  );
+  auto ring = std::make_shared<detail::TLogRing>(Options.RingSize);
+  {
+    std::lock_guard guard{RingsLock};
+    Rings.push_back(ring);
+  }
+  threadRings.push_back(TThreadRing{Id, ring});
+  return *ring;
+}
+
+u64 TLogger::Dropped() const {
+  std::lock_guard guard{RingsLock};
+  auto result = DroppedByFinishedThreads;
+  for (const auto& ring : Rings) {
+    result += ring->Dropped.load(std::memory_order_relaxed);
+  }
+  return result;
+}
+
+void TLogger::Flush() {
+  std::unique_lock guard{PassLock};
+  // The pass that is running now may have missed the latest records
+  const auto target = Passes + 2;
+  PassDone.wait(guard, [&] { return Passes >= target; });
+}
+
+bool TLogger::Drain(std::string& batch) {
+  std::vector<std::shared_ptr<detail::TLogRing>> rings;
+  {
+    std::lock_guard guard{RingsLock};
+    // Rings of finished threads are only referenced here, drop the empty ones
+    for (auto it = Rings.begin(); it != Rings.end();) {
+      const auto& ring = *it;
+      if (ring.use_count() == 1 && ring->Head.load() == ring->Tail.load()) {
+        DroppedByFinishedThreads += ring->Dropped.load();
+        it = Rings.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    rings = Rings;
+  }
+
+  std::vector<iovec> chunks;
+  std::vector<std::size_t> offsets;
+  for (const auto& ring : rings) {
+    const auto start = batch.size();
+    auto head = ring->Head.load(std::memory_order_relaxed);
+    const auto tail = ring->Tail.load(std::memory_order_acquire);
+    while (head != tail) {
+      const auto index = head & (ring->Capacity - 1);
+      if (ring->Capacity - index < sizeof(detail::TLogRecordHeader)) {
+        head += ring->Capacity - index;
+        continue;
+      }
+      detail::TLogRecordHeader header;
+      std::memcpy(&header, ring->Data.get() + index, sizeof(header));
+      if (header.Decode != nullptr) {
+        AppendTimestamp(batch, header.Timestamp);
+        batch.append(LEVEL_NAMES[static_cast<int>(header.Level)]);
+        batch.push_back(' ');
+        header.Decode(ring->Data.get() + index + sizeof(header), batch);
+        batch.push_back('\n');
+      }
+      head += header.Size;
+    }
+    ring->Head.store(head, std::memory_order_release);
+    if (batch.size() > start) {
+      offsets.push_back(start);
+    }
+  }
+  if (batch.empty()) {
+    return false;
+  }
+
+  // One chunk per thread, the pointers are taken once the batch stopped growing
+  offsets.push_back(batch.size());
+  for (std::size_t i = 0; i + 1 < offsets.size(); i++) {
+    chunks.push_back(iovec{batch.data() + offsets[i], offsets[i + 1] - offsets[i]});
+  }
+  std::size_t chunk = 0;
+  while (chunk < chunks.size()) {
+    const auto count = std::min<std::size_t>(chunks.size() - chunk, IOV_MAX);
+    const auto written = ::writev(Fd, chunks.data() + chunk, count);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      // Nowhere to report the error, the batch is lost
+      break;
+    }
+    auto left = static_cast<std::size_t>(written);
+    while (chunk < chunks.size() && left >= chunks[chunk].iov_len) {
+      left -= chunks[chunk].iov_len;
+      chunk++;
+    }
+    if (chunk < chunks.size()) {
+      chunks[chunk].iov_base = static_cast<char*>(chunks[chunk].iov_base) + left;
+      chunks[chunk].iov_len -= left;
+    }
+  }
+  return true;
+}
+
+void TLogger::Run() {
+  std::string batch;
+  while (true) {
+    const bool stopping = Stopping.load();
+    batch.clear();
+    const bool wrote = Drain(batch);
+    {
+      std::lock_guard guard{PassLock};
+      Passes++;
+    }
+    PassDone.notify_all();
+    if (stopping && !wrote) {
+      break;
+    }
+    if (!wrote) {
+      std::this_thread::sleep_for(Options.PollInterval);
+    }
+  }
+}
+
+/*******************************************************************************
+*                                Global logger                                *
+*******************************************************************************/
+
+TLogger* GetLogger() {
+  return GlobalLogger.load(std::memory_order_acquire);
+}
+
+TScopedLogger::TScopedLogger(TLogger& logger) : Previous{GlobalLogger.exchange(&logger)} {}
+
+TScopedLogger::~TScopedLogger() {
+  GlobalLogger.store(Previous);
+}
+
+}  // namespace utils
@@ -0,0 +1,169 @@
+#include <cpputils/parallel.hh>
+
+#include <exception>
+
+namespace utils {
+
+namespace {
+
+/// The pool and the index of the worker running on this thread
+thread_local const TThreadPool* CurrentPool = nullptr;
+thread_local std::size_t CurrentWorker = 0;
+
+}  // namespace
+
+/*******************************************************************************
+*                                 TThreadPool                                 *
+*******************************************************************************/
+
+TThreadPool::TThreadPool(std::size_t threads) {
+  Workers.reserve(threads);
+  for (std::size_t i = 0; i < threads; i++) {
+    Workers.push_back(std::make_unique<TWorker>());
+  }
+  Threads.reserve(threads);
+  for (std::size_t i = 0; i < threads; i++) {
+    Threads.emplace_back([this, i] { WorkerLoop(i); });
+  }
+}
+
+TThreadPool::~TThreadPool() {
+  {
+    std::lock_guard lock{SleepMutex};
+    Stopping = true;
+  }
+  WakeUp.notify_all();
+  for (auto& thread : Threads) {
+    thread.join();
+  }
+}
+
+void TThreadPool::Submit(TTask task) {
+  if (Workers.empty()) {
+    task();
+    return;
+  }
+  // tasks spawned by a worker stay on its deque, others are spread around
+  const auto queue = CurrentPool == this
+    ? CurrentWorker
+    : NextQueue.fetch_add(1, std::memory_order_relaxed) % Workers.size();
+  Push(queue, std::move(task));
+}
+
+void TThreadPool::Push(std::size_t queue, TTask task) {
+  {
+    std::lock_guard lock{Workers[queue]->Mutex};
+    Workers[queue]->Tasks.push_back(std::move(task));
+  }
+  {
+    std::lock_guard lock{SleepMutex};
+    Pending.fetch_add(1, std::memory_order_relaxed);
+  }
+  WakeUp.notify_one();
+}
+
+bool TThreadPool::TryPop(std::size_t self, TTask& task) {
+  auto& worker = *Workers[self];
+  std::lock_guard lock{worker.Mutex};
+  if (worker.Tasks.empty()) {
+    return false;
+  }
+  task = std::move(worker.Tasks.back());
+  worker.Tasks.pop_back();
+  return true;
+}
+
+bool TThreadPool::TrySteal(std::size_t self, TTask& task) {
+  const auto count = Workers.size();
+  for (std::size_t k = 1; k <= count; k++) {
+    auto& victim = *Workers[(self + k) % count];
+    std::unique_lock lock{victim.Mutex, std::try_to_lock};
+    if (!lock.owns_lock() || victim.Tasks.empty()) {
+      continue;
+    }
+    task = std::move(victim.Tasks.front());
+    victim.Tasks.pop_front();
+    return true;
+  }
+  return false;
+}
+
+bool TThreadPool::RunOne(std::size_t self) {
+  TTask task;
+  const bool isWorker = CurrentPool == this;
+  if ((isWorker && TryPop(self, task)) || TrySteal(self, task)) {
+    Pending.fetch_sub(1, std::memory_order_relaxed);
+    task();
+    return true;
+  }
+  return false;
+}
+
+void TThreadPool::WorkerLoop(std::size_t self) {
+  CurrentPool = this;
+  CurrentWorker = self;
+  while (true) {
+    if (RunOne(self)) {
+      continue;
+    }
+    std::unique_lock lock{SleepMutex};
+    WakeUp.wait(lock, [this] { return Stopping || Pending.load(std::memory_order_relaxed) > 0; });
+    if (Stopping && Pending.load(std::memory_order_relaxed) <= 0) {
+      return;
+    }
+  }
+}
+
+void TThreadPool::ParallelFor(std::size_t count, const std::function<void(std::size_t)>& fn) {
+  if (Workers.empty() || count <= 1) {
+    for (std::size_t i = 0; i < count; i++) {
+      fn(i);
+    }
+    return;
+  }
+
+  struct TState {
+    std::atomic<std::size_t> Remaining;
+    std::mutex ErrorMutex;
+    std::exception_ptr Error;
+  };
+  auto state = std::make_shared<TState>();
+  state->Remaining.store(count, std::memory_order_relaxed);
+  const auto run = [&fn](TState& state, std::size_t i) {
+    try {
+      fn(i);
+    } catch (...) {
+      std::lock_guard lock{state.ErrorMutex};
+      if (!state.Error) {
+        state.Error = std::current_exception();
+      }
+    }
+    state.Remaining.fetch_sub(1, std::memory_order_acq_rel);
+  };
+
+  // pushed in reverse, so that the owner pops the chunks in order while
+  // thieves take the last ones
+  for (auto i = count - 1; i > 0; i--) {
+    Submit([state, run, i] { run(*state, i); });
+  }
+  run(*state, 0);
+
+  // `fn` is referenced by the submitted tasks, so wait for all of them and
+  // help with whatever is pending meanwhile
+  const auto self = CurrentPool == this ? CurrentWorker : 0;
+  while (state->Remaining.load(std::memory_order_acquire) > 0) {
+    if (!RunOne(self)) {
+      std::this_thread::yield();
+    }
+  }
+  if (state->Error) {
+    std::rethrow_exception(state->Error);
+  }
+}
+
+TThreadPool& GetThreadPool() {
+  static TThreadPool pool{std::max(std::thread::hardware_concurrency(), 1u) - 1};
+  return pool;
+}
+
+}  // namespace utils
@@ -1 +1,198 @@
 #include <cpputils/string.hh>
+
+#include <limits>
+#include <queue>
+
+namespace utils {
+
+/*******************************************************************************
+*                                  TReplacer                                  *
+*******************************************************************************/
+
+TReplacer::TReplacer(
+  const std::vector<std::pair<std::string_view, std::string_view>>& replacementPairs,
+  EMatchKind kind
+) : Kind{kind} {
+  for (const auto& [pattern, replacement] : replacementPairs) {
+    if (pattern.empty()) {
+      throw std::runtime_error("Replacement pattern must not be empty");
+    }
+    Patterns.emplace_back(pattern);
+    Replacements.emplace_back(replacement);
+    for (auto c : pattern) {
+      auto& byteClass = ByteClass[static_cast<unsigned char>(c)];
+      if (byteClass == 0) {
+        byteClass = ClassCount++;
+      }
+    }
+  }
+
+  // Trie, `NONE` marks the missing edges
+  constexpr auto NONE = std::numeric_limits<std::uint32_t>::max();
+  States.emplace_back();
+  Transitions.assign(ClassCount, NONE);
+  for (std::uint32_t i = 0; i < Patterns.size(); i++) {
+    std::uint32_t state = 0;
+    for (auto c : Patterns[i]) {
+      const auto edge = state * ClassCount + ByteClass[static_cast<unsigned char>(c)];
+      if (Transitions[edge] == NONE) {
+        Transitions[edge] = States.size();
+        States.push_back(TState{States[state].Depth + 1});
+        Transitions.resize(Transitions.size() + ClassCount, NONE);
+      }
+      state = Transitions[edge];
+    }
+    if (States[state].Match == NO_PATTERN) {
+      States[state].Match = i;
+    }
+  }
+
+  // A pattern state is final if no pattern that extends it could win
+  std::vector<std::uint32_t> order;  // BFS order, parents go first
+  std::vector<std::uint32_t> fail(States.size(), 0);
+  std::queue<std::uint32_t> queue;
+  queue.push(0);
+  while (!queue.empty()) {
+    const auto state = queue.front();
+    queue.pop();
+    order.push_back(state);
+    for (std::size_t c = 0; c < ClassCount; c++) {
+      const auto child = Transitions[state * ClassCount + c];
+      if (child != NONE) {
+        queue.push(child);
+      }
+    }
+  }
+  std::vector<std::int32_t> minPatternBelow(States.size(), std::numeric_limits<std::int32_t>::max());
+  for (auto it = order.rbegin(); it != order.rend(); ++it) {
+    const auto state = *it;
+    std::int32_t minBelow = std::numeric_limits<std::int32_t>::max();
+    for (std::size_t c = 0; c < ClassCount; c++) {
+      const auto child = Transitions[state * ClassCount + c];
+      if (child != NONE) {
+        minBelow = std::min(minBelow, minPatternBelow[child]);
+      }
+    }
+    auto& s = States[state];
+    if (s.Match != NO_PATTERN) {
+      s.Final = Kind == EMatchKind::LeftmostLongest
+        ? minBelow == std::numeric_limits<std::int32_t>::max()
+        : minBelow > s.Match;
+      minPatternBelow[state] = std::min(minBelow, s.Match);
+    } else {
+      minPatternBelow[state] = minBelow;
+    }
+  }
+
+  // Failure links and the dense transition table
+  for (const auto state : order) {
+    for (std::size_t c = 0; c < ClassCount; c++) {
+      auto& next = Transitions[state * ClassCount + c];
+      if (next == NONE) {
+        next = state == 0 ? 0 : Transitions[fail[state] * ClassCount + c];
+      } else {
+        fail[next] = state == 0 ? 0 : Transitions[fail[state] * ClassCount + c];
+        if (States[next].Match == NO_PATTERN) {
+          States[next].Match = States[fail[next]].Match;
+        }
+      }
+    }
+  }
+}
+
+std::string TReplacer::Replace(std::string_view text) const {
+  std::string result;
+  ReplaceTo(text, result);
+  return result;
+}
+
+void TReplacer::ReplaceTo(std::string_view text, std::string& out) const {
+  out.reserve(out.size() + text.size());
+  TStream stream{*this};
+  stream.Feed(text, out);
+  stream.Finish(out);
+}
+
+char TReplacer::TStream::ByteAt(std::string_view chunk, std::size_t pos) const {
+  return pos < ChunkBegin ? Carry[Carry.size() - (ChunkBegin - pos)] : chunk[pos - ChunkBegin];
+}
+
+void TReplacer::TStream::AppendText(std::string_view chunk, std::size_t from, std::size_t to, std::string& out) const {
+  if (from < ChunkBegin) {
+    const auto carryBegin = ChunkBegin - Carry.size();
+    const auto carryTo = std::min(to, ChunkBegin);
+    out.append(Carry, from - carryBegin, carryTo - from);
+    from = carryTo;
+  }
+  if (from < to) {
+    out.append(chunk.substr(from - ChunkBegin, to - from));
+  }
+}
+
+void TReplacer::TStream::Feed(std::string_view chunk, std::string& out) {
+  Run(chunk, out, false);
+}
+
+void TReplacer::TStream::Finish(std::string& out) {
+  Run({}, out, true);
+  *this = TStream{*Replacer};
+}
+
+void TReplacer::TStream::Run(std::string_view chunk, std::string& out, bool atEnd) {
+  const auto& r = *Replacer;
+  const auto end = ChunkBegin + chunk.size();
+  while (true) {
+    while (Consumed < end) {
+      State = r.Next(State, ByteAt(chunk, Consumed));
+      Consumed++;
+      const auto& state = r.States[State];
+      if (state.Match != NO_PATTERN) {
+        const auto pattern = static_cast<std::uint32_t>(state.Match);
+        const auto start = Consumed - r.Patterns[pattern].size();
+        if (!HasMatch || start < Match.Start) {
+          HasMatch = true;
+          Match = TMatch{start, Consumed, pattern};
+        } else if (start == Match.Start && (r.Kind == EMatchKind::LeftmostLongest || pattern < Match.Pattern)) {
+          Match = TMatch{start, Consumed, pattern};
+        }
+      }
+      if (!HasMatch) {
+        continue;
+      }
+      // No match that is still in progress can start before `aliveStart`
+      const auto aliveStart = Consumed - state.Depth;
+      const bool decided = Match.Start < aliveStart
+        || (Match.Start == aliveStart && Match.End == Consumed && state.Final);
+      if (decided) {
+        AppendText(chunk, Emitted, Match.Start, out);
+        out.append(r.Replacements[Match.Pattern]);
+        Emitted = Match.End;
+        HasMatch = false;
+        State = 0;
+        Consumed = Match.End;
+      }
+    }
+    if (!atEnd || !HasMatch) {
+      break;
+    }
+    // The input is over, so the pending match can't be beaten anymore
+    AppendText(chunk, Emitted, Match.Start, out);
+    out.append(r.Replacements[Match.Pattern]);
+    Emitted = Match.End;
+    HasMatch = false;
+    State = 0;
+    Consumed = Match.End;
+  }
+
+  const auto unresolved = atEnd ? Consumed : Consumed - r.States[State].Depth;
+  AppendText(chunk, Emitted, unresolved, out);
+  std::string carry;
+  for (auto pos = unresolved; pos < Consumed; pos++) {
+    carry.push_back(ByteAt(chunk, pos));
+  }
+  Carry = std::move(carry);
+  Emitted = unresolved;
+  ChunkBegin = end;
+}
+
+}  // namespace utils
@@ -0,0 +1,88 @@
+#include <cpputils/aggregate.hh>
+#include <cpputils/string.hh>
+
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using testing::ElementsAre;
+using testing::Pair;
+
+TEST(AggregateTest, CountBy) {
+  const auto words = utils::SplitView("b a c a b a");
+  EXPECT_THAT(
+    utils::CountBy(words, [](std::string_view w) { return w; }),
+    ElementsAre(Pair("b", 2), Pair("a", 3), Pair("c", 1))
+  );
+  const auto v = std::vector{1, 2, 3, 4, 5, 6, 7};
+  EXPECT_THAT(
+    utils::CountBy(utils::Map(v, [](int x) { return x * 10; }), [](int x) { return x % 3; }),
+    ElementsAre(Pair(1, 3), Pair(2, 2), Pair(0, 2))
+  );
+  EXPECT_THAT(utils::CountBy(std::vector<int>{}, [](int x) { return x; }), ElementsAre());
+}
+
+TEST(AggregateTest, GroupBy) {
+  const auto v = std::vector{5, 1, 8, 2, 7, 4};
+  const auto parity = [](int x) { return x % 2; };
+  EXPECT_THAT(utils::GroupBy(v, parity), ElementsAre(Pair(1, ElementsAre(5, 1, 7)), Pair(0, ElementsAre(8, 2, 4))));
+  EXPECT_THAT(utils::GroupBy(v, parity, 0, std::plus<>{}), ElementsAre(Pair(1, 13), Pair(0, 14)));
+
+  // zipped columns: total price by category
+  const auto categories = std::vector<std::string>{"fruit", "tool", "fruit", "toy", "tool"};
+  const auto prices = std::vector{3, 20, 5, 7, 15};
+  const auto totals = utils::GroupBy(
+    utils::Zip(categories, prices),
+    [](const auto& row) { return std::get<0>(row); },
+    0,
+    [](int total, const auto& row) { return total + std::get<1>(row); },
+    16
+  );
+  EXPECT_THAT(totals, ElementsAre(Pair("fruit", 8), Pair("tool", 35), Pair("toy", 7)));
+
+  const auto big = utils::GroupBy(utils::Filter(v, [](int x) { return x > 4; }), [](int x) { return x > 6; });
+  EXPECT_THAT(big, ElementsAre(Pair(false, ElementsAre(5)), Pair(true, ElementsAre(8, 7))));
+}
+
+TEST(AggregateTest, Distinct) {
+  EXPECT_THAT(utils::Distinct(std::vector{3, 1, 3, 2, 1, 3}), ElementsAre(3, 1, 2));
+  EXPECT_THAT(utils::Distinct(utils::SplitView("x y x z y")), ElementsAre("x", "y", "z"));
+  EXPECT_THAT(utils::Distinct(std::vector<int>{}, 100), ElementsAre());
+
+  // tuples and pairs have no `std::hash`
+  const auto ids = std::vector{1, 2, 1, 1};
+  const auto codes = std::vector{'a', 'b', 'a', 'c'};
+  EXPECT_THAT(
+    utils::Distinct(utils::Zip(ids, codes)),
+    ElementsAre(testing::FieldsAre(1, 'a'), testing::FieldsAre(2, 'b'), testing::FieldsAre(1, 'c'))
+  );
+  const auto pairs = utils::CountBy(utils::Zip(ids, codes), [](const auto& row) {
+    return std::pair{std::get<0>(row), std::get<1>(row)};
+  });
+  EXPECT_THAT(pairs, ElementsAre(Pair(Pair(1, 'a'), 2), Pair(Pair(2, 'b'), 1), Pair(Pair(1, 'c'), 1)));
+}
+
+TEST(AggregateTest, ManyKeys) {
+  // enough keys to grow the table several times past batch boundaries
+  std::mt19937 rng{1};
+  std::vector<int> values(100000);
+  for (auto& x : values) {
+    x = static_cast<int>(rng() % 20000);
+  }
+  std::unordered_map<int, std::size_t> expected;
+  for (auto x : values) {
+    expected[x]++;
+  }
+  for (const std::size_t hint : {0, 20000}) {
+    const auto counts = utils::CountBy(values, [](int x) { return x; }, hint);
+    ASSERT_EQ(counts.size(), expected.size());
+    for (const auto& [key, count] : counts) {
+      EXPECT_EQ(count, expected[key]) << key;
+    }
+    EXPECT_EQ(utils::Distinct(values, hint).size(), expected.size());
+  }
+}
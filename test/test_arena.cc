@@ -0,0 +1,64 @@
+#include <cpputils/arena.hh>
+
+#include <string>
+#include <string_view>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+TEST(StringArenaTest, StoreAndReset) {
+  utils::TStringArena arena{64};
+  std::vector<std::string_view> views;
+  for (int i = 0; i < 100; i++) {
+    views.push_back(arena.Store(std::to_string(i)));
+  }
+  const auto large = arena.Store(std::string(1000, 'x'));
+  for (int i = 0; i < 100; i++) {
+    EXPECT_EQ(views[i], std::to_string(i));
+  }
+  EXPECT_EQ(large, std::string(1000, 'x'));
+  EXPECT_EQ(arena.BytesUsed(), 190 + 1000);
+
+  const auto reserved = arena.BytesReserved();
+  arena.Reset();
+  EXPECT_EQ(arena.BytesUsed(), 0);
+  EXPECT_EQ(arena.BytesReserved(), reserved - 1000);
+  for (int i = 0; i < 100; i++) {
+    arena.Store(std::to_string(i));
+  }
+  EXPECT_EQ(arena.BytesReserved(), reserved - 1000);
+}
+
+TEST(StringArenaTest, StringUtils) {
+  utils::TStringArena arena;
+  std::string line = "  a,bb,,ccc  ";
+  const auto trimmed = utils::Trim(arena, line);
+  const auto tokens = utils::Split(arena, trimmed, ',');
+  const auto replaced = utils::Replace(arena, line, {{"bb", "B"}, {",", ";"}});
+  const auto joined = utils::Join(arena, tokens, "+");
+  line.assign(line.size(), '?');
+
+  EXPECT_EQ(trimmed, "a,bb,,ccc");
+  EXPECT_THAT(tokens, testing::ElementsAre("a", "bb", "ccc"));
+  EXPECT_EQ(replaced, "  a;B;;ccc  ");
+  EXPECT_EQ(joined, "a+bb+ccc");
+  EXPECT_EQ(utils::Join(arena, {"x", "y"}), "x, y");
+  EXPECT_EQ(utils::Join(arena, std::vector<std::string>{}), "");
+  EXPECT_EQ(utils::Trim(arena, "   "), "");
+}
+
+TEST(StringInternerTest, Intern) {
+  utils::TStringInterner interner;
+  const auto get = interner.Intern("GET");
+  const auto post = interner.Intern(std::string{"POST"});
+  EXPECT_NE(get, post);
+  EXPECT_EQ(interner.Intern(std::string{"GET"}), get);
+  EXPECT_EQ(interner.Get(post), "POST");
+  EXPECT_EQ(interner.InternView("GET").data(), interner.Get(get).data());
+  EXPECT_EQ(interner.Find("POST"), post);
+  EXPECT_EQ(interner.Find("PUT"), std::nullopt);
+  EXPECT_EQ(interner.Size(), 2);
+  interner.Clear();
+  EXPECT_EQ(interner.Size(), 0);
+  EXPECT_EQ(interner.Find("GET"), std::nullopt);
+}
@@ -0,0 +1,75 @@
+#include <cpputils/charset.hh>
+#include <cpputils/string.hh>
+
+#include <random>
+#include <string>
+#include <unordered_set>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace CharSetTest {
+  constexpr utils::TCharSet DIGITS{"0123456789"};
+  static_assert(DIGITS.Contains('7'));
+  static_assert(!DIGITS.Contains('a'));
+  static_assert(DIGITS.GetSize() == 10);
+  static_assert(!DIGITS.IsSmall());
+  static_assert(utils::TCharSet{'\xFF'}.Contains('\xFF'));
+  static_assert(!utils::TCharSet{'\x7F'}.Contains('\xFF'));
+}
+
+TEST(CharSetTest, Membership) {
+  const utils::TCharSet set{std::unordered_set<char>{'a', ',', '\x80'}};
+  for (int c = 0; c < 256; c++) {
+    const auto ch = static_cast<char>(c);
+    EXPECT_EQ(set.Contains(ch), ch == 'a' || ch == ',' || ch == '\x80') << c;
+  }
+}
+
+TEST(CharSetTest, KernelsMatchScalar) {
+  using utils::detail::ECharSetKernel;
+  std::mt19937 rng{42};
+  const std::vector<utils::TCharSet> sets = {
+    utils::TCharSet{','},
+    utils::TCharSet{" \t\n"},
+    utils::TCharSet{"0123456789abcdef\x80\xC3\xFF"},
+  };
+  for (const auto& set : sets) {
+    for (int iteration = 0; iteration < 200; iteration++) {
+      std::string text(rng() % 200, '\0');
+      for (auto& c : text) {
+        // mostly bytes from the set, so the non-member scan also gets exercised
+        c = static_cast<char>(rng() % 4 == 0 ? rng() : set.Small[rng() % std::min<std::size_t>(set.GetSize(), 8)]);
+      }
+      for (const bool member : {true, false}) {
+        const auto expected = utils::detail::ScanCharSet(text.data(), text.size(), set, member, ECharSetKernel::Scalar);
+        for (const auto kernel : {ECharSetKernel::Sse2, ECharSetKernel::Avx2}) {
+          if (utils::detail::IsKernelSupported(kernel, set)) {
+            EXPECT_EQ(utils::detail::ScanCharSet(text.data(), text.size(), set, member, kernel), expected);
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(CharSetTest, Find) {
+  const std::string_view s = "  key = value, other  ";
+  EXPECT_EQ(utils::FindFirstOf(s, "=,"), s.find_first_of("=,"));
+  EXPECT_EQ(utils::FindFirstOf(s, "=,", 8), s.find_first_of("=,", 8));
+  EXPECT_EQ(utils::FindFirstOf(s, '#'), std::string_view::npos);
+  EXPECT_EQ(utils::FindFirstNotOf(s, ' '), s.find_first_not_of(' '));
+  EXPECT_EQ(utils::FindLastNotOf(s, ' '), s.find_last_not_of(' '));
+  EXPECT_EQ(utils::FindFirstNotOf("", ' '), std::string_view::npos);
+}
+
+TEST(CharSetTest, SplitAndTrim) {
+  const std::string longLine(100, ' ');
+  EXPECT_EQ(utils::Trim(longLine + "x y" + longLine), "x y");
+  EXPECT_EQ(utils::Trim(longLine), "");
+  EXPECT_EQ(utils::Trim("--x--", '-'), "x");
+  EXPECT_THAT(utils::Split("a,b;;c", ",;"), testing::ElementsAre("a", "b", "c"));
+  EXPECT_THAT(utils::Split(longLine + "a\tb\n" + longLine + "c"), testing::ElementsAre("a", "b", "c"));
+  EXPECT_THAT(utils::Split("a, b", std::unordered_set<char>{' ', ','}), testing::ElementsAre("a", "b"));
+  EXPECT_THAT(utils::Split(""), testing::IsEmpty());
+}
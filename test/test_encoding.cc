@@ -0,0 +1,212 @@
+#include <cpputils/encoding.hh>
+
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace {
+
+using utils::detail::ETextKernel;
+
+const std::vector<ETextKernel> SIMD_KERNELS = {ETextKernel::Sse42, ETextKernel::Avx2};
+
+void AppendCodePoint(std::string& s, u32 cp) {
+  if (cp < 0x80) {
+    s += static_cast<char>(cp);
+  } else if (cp < 0x800) {
+    s += static_cast<char>(0xC0 | (cp >> 6));
+    s += static_cast<char>(0x80 | (cp & 0x3F));
+  } else if (cp < 0x10000) {
+    s += static_cast<char>(0xE0 | (cp >> 12));
+    s += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+    s += static_cast<char>(0x80 | (cp & 0x3F));
+  } else {
+    s += static_cast<char>(0xF0 | (cp >> 18));
+    s += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+    s += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+    s += static_cast<char>(0x80 | (cp & 0x3F));
+  }
+}
+
+/// Valid UTF-8 with a mix of sequence lengths and long ASCII runs
+std::string RandomUtf8(std::mt19937& rng, std::size_t codePoints) {
+  std::string result;
+  for (std::size_t i = 0; i < codePoints; i++) {
+    u32 cp = 0;
+    switch (rng() % 5) {
+      case 0:
+      case 1:
+        cp = rng() % 0x80;
+        break;
+      case 2:
+        cp = 0x80 + rng() % (0x800 - 0x80);
+        break;
+      case 3:
+        do {
+          cp = 0x800 + rng() % (0x10000 - 0x800);
+        } while (cp >= 0xD800 && cp <= 0xDFFF);
+        break;
+      default:
+        cp = 0x10000 + rng() % (0x110000 - 0x10000);
+    }
+    AppendCodePoint(result, cp);
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST(EncodingTest, ValidUtf8) {
+  EXPECT_TRUE(utils::IsValidUtf8(""));
+  EXPECT_TRUE(utils::IsValidUtf8("plain ascii"));
+  EXPECT_TRUE(utils::IsValidUtf8("\xD0\xBF\xD1\x80\xD0\xB8\xD0\xB2\xD0\xB5\xD1\x82"));
+  EXPECT_TRUE(utils::IsValidUtf8("\xE2\x82\xAC \xF0\x9F\x98\x80 \xF4\x8F\xBF\xBF"));
+
+  const std::vector<std::string> invalid = {
+    "\x80",                  // lone continuation
+    "\xC0\xAF",              // overlong '/'
+    "\xC1\xBF",              // overlong
+    "\xE0\x80\xAF",          // overlong 3 bytes
+    "\xF0\x80\x80\xAF",      // overlong 4 bytes
+    "\xED\xA0\x80",          // surrogate
+    "\xF4\x90\x80\x80",      // above U+10FFFF
+    "\xF5\x80\x80\x80",      // invalid lead
+    "\xFF",
+    "\xC3",                  // truncated
+    "\xE2\x82",
+    "\xF0\x9F\x98",
+    "\xC3\xA9\xA9",          // too long
+    "\xE2\x82" "A",          // too short
+  };
+  for (const auto& text : invalid) {
+    EXPECT_FALSE(utils::IsValidUtf8(text)) << text;
+    // the same errors in the middle of a long block and at a block boundary
+    for (std::size_t prefix : {5, 13, 14, 15, 29, 30, 31, 40}) {
+      const auto padded = std::string(prefix, 'a') + text + std::string(40, 'b');
+      for (const auto kernel : SIMD_KERNELS) {
+        if (utils::detail::IsKernelSupported(kernel)) {
+          EXPECT_FALSE(utils::detail::GetTextKernels(kernel).IsValidUtf8(padded.data(), padded.size())) << prefix;
+        }
+      }
+      EXPECT_FALSE(utils::IsValidUtf8(std::string(prefix, 'a') + text)) << prefix;
+    }
+  }
+}
+
+TEST(EncodingTest, KernelsMatchScalar) {
+  const auto& scalar = utils::detail::GetTextKernels(ETextKernel::Scalar);
+  std::mt19937 rng{42};
+  for (int iteration = 0; iteration < 2000; iteration++) {
+    auto text = RandomUtf8(rng, rng() % 120);
+    // half of the inputs get corrupted bytes, truncations or all-ASCII blocks
+    switch (iteration % 4) {
+      case 0:
+        if (!text.empty()) {
+          text[rng() % text.size()] = static_cast<char>(rng());
+        }
+        break;
+      case 1:
+        text.resize(text.size() - text.size() / 3);
+        break;
+      case 2:
+        text = std::string(rng() % 70, 'x') + text;
+        break;
+    }
+    auto other = text;
+    for (auto& c : other) {
+      if (rng() % 3 == 0) {
+        c = static_cast<char>(c ^ 0x20);
+      }
+    }
+
+    const auto valid = scalar.IsValidUtf8(text.data(), text.size());
+    std::string lower(text.size(), '\0');
+    std::string upper(text.size(), '\0');
+    scalar.ToLower(text.data(), lower.data(), text.size());
+    scalar.ToUpper(text.data(), upper.data(), text.size());
+
+    for (const auto kernel : SIMD_KERNELS) {
+      if (!utils::detail::IsKernelSupported(kernel)) {
+        continue;
+      }
+      const auto& kernels = utils::detail::GetTextKernels(kernel);
+      EXPECT_EQ(kernels.IsValidUtf8(text.data(), text.size()), valid) << testing::PrintToString(text);
+      EXPECT_EQ(kernels.IsAscii(text.data(), text.size()), scalar.IsAscii(text.data(), text.size()));
+      EXPECT_EQ(kernels.CountCodePoints(text.data(), text.size()), scalar.CountCodePoints(text.data(), text.size()));
+      EXPECT_EQ(
+        kernels.MismatchIgnoreCase(text.data(), other.data(), text.size()),
+        scalar.MismatchIgnoreCase(text.data(), other.data(), text.size())
+      );
+
+      std::string result(text.size(), '\0');
+      kernels.ToLower(text.data(), result.data(), text.size());
+      EXPECT_EQ(result, lower);
+      kernels.ToUpper(text.data(), result.data(), text.size());
+      EXPECT_EQ(result, upper);
+      // in place
+      result = text;
+      kernels.ToLower(result.data(), result.data(), result.size());
+      EXPECT_EQ(result, lower);
+    }
+  }
+}
+
+TEST(EncodingTest, CountCodePoints) {
+  std::mt19937 rng{7};
+  for (const std::size_t count : {0, 1, 31, 32, 33, 1000, 20000}) {
+    EXPECT_EQ(utils::CountCodePoints(RandomUtf8(rng, count)), count);
+  }
+  EXPECT_EQ(utils::CountCodePoints("\xE2\x82\xAC" "100"), 4);
+}
+
+TEST(EncodingTest, IsAscii) {
+  EXPECT_TRUE(utils::IsAscii(""));
+  EXPECT_TRUE(utils::IsAscii(std::string(1000, '~')));
+  auto text = std::string(1000, 'a');
+  text[777] = '\x80';
+  EXPECT_FALSE(utils::IsAscii(text));
+}
+
+TEST(EncodingTest, CaseMapping) {
+  EXPECT_EQ(utils::ToLower("Hello, WORLD! @[`{"), "hello, world! @[`{");
+  EXPECT_EQ(utils::ToUpper("Hello, world! @[`{"), "HELLO, WORLD! @[`{");
+  // only ASCII letters change
+  EXPECT_EQ(utils::ToLower("\xC3\x89T\xC3\x89"), "\xC3\x89t\xC3\x89");
+
+  std::string s = "Content-Type: Text/HTML; charset=UTF-8 and some more padding";
+  utils::ToLowerInPlace(s);
+  EXPECT_EQ(s, "content-type: text/html; charset=utf-8 and some more padding");
+  utils::ToUpperInPlace(s);
+  EXPECT_EQ(s, "CONTENT-TYPE: TEXT/HTML; CHARSET=UTF-8 AND SOME MORE PADDING");
+}
+
+TEST(EncodingTest, IgnoreCase) {
+  EXPECT_TRUE(utils::EqualsIgnoreCase("Content-Length", "content-LENGTH"));
+  EXPECT_FALSE(utils::EqualsIgnoreCase("Content-Length", "Content-Lengths"));
+  EXPECT_FALSE(utils::EqualsIgnoreCase("[", "{"));
+
+  EXPECT_EQ(utils::CompareIgnoreCase("abc", "ABC"), 0);
+  EXPECT_LT(utils::CompareIgnoreCase("abc", "ABD"), 0);
+  EXPECT_GT(utils::CompareIgnoreCase("abd", "ABC"), 0);
+  EXPECT_LT(utils::CompareIgnoreCase("ab", "ABC"), 0);
+  EXPECT_GT(utils::CompareIgnoreCase("abc", "AB"), 0);
+  // '_' sorts after letters once they are lowercased
+  EXPECT_GT(utils::CompareIgnoreCase("A", "_"), 0);
+
+  const auto longKey = std::string(300, 'k') + "Key";
+  EXPECT_EQ(utils::HashIgnoreCase(longKey), utils::HashIgnoreCase(utils::ToUpper(longKey)));
+  EXPECT_NE(utils::HashIgnoreCase("key"), utils::HashIgnoreCase("kez"));
+  EXPECT_NE(utils::HashIgnoreCase("key"), utils::HashIgnoreCase(std::string_view("key\0", 4)));
+
+  std::unordered_map<std::string, int, utils::THashIgnoreCase, utils::TEqualIgnoreCase> headers;
+  headers["Content-Type"] = 1;
+  headers["content-type"]++;
+  headers["ACCEPT"] = 3;
+  EXPECT_EQ(headers.size(), 2);
+  EXPECT_EQ(headers["CONTENT-TYPE"], 2);
+  EXPECT_EQ(headers["accept"], 3);
+}
@@ -0,0 +1,172 @@
+#include <cpputils/flat_hash.hh>
+
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using testing::UnorderedElementsAre;
+using testing::Pair;
+
+namespace {
+
+/// Every key in one home slot, so that all of them form a single cluster
+struct TCollidingHash {
+  std::size_t operator()(int) const {
+    return 0;
+  }
+};
+
+template<class TMap, class TModel>
+void ExpectSameContents(const TMap& map, const TModel& model) {
+  ASSERT_EQ(map.size(), model.size());
+  std::size_t visited = 0;
+  for (const auto& [key, value] : map) {
+    const auto it = model.find(key);
+    ASSERT_NE(it, model.end()) << key;
+    EXPECT_EQ(value, it->second) << key;
+    visited++;
+  }
+  EXPECT_EQ(visited, model.size());
+}
+
+}  // namespace
+
+TEST(FlatHashTest, Basic) {
+  utils::TFlatHashMap<int, std::string> map;
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(map.find(1), map.end());
+
+  EXPECT_TRUE(map.try_emplace(1, "one").second);
+  EXPECT_FALSE(map.try_emplace(1, "uno").second);
+  map[2] = "two";
+  map.insert({3, "three"});
+  EXPECT_FALSE(map.insert_or_assign(3, "drei").second);
+  EXPECT_THAT(map, UnorderedElementsAre(Pair(1, "one"), Pair(2, "two"), Pair(3, "drei")));
+
+  EXPECT_EQ(map.at(2), "two");
+  EXPECT_THROW(map.at(4), std::out_of_range);
+  EXPECT_TRUE(map.contains(1));
+  EXPECT_EQ(map.count(4), 0);
+
+  EXPECT_EQ(map.erase(2), 1);
+  EXPECT_EQ(map.erase(2), 0);
+  map.erase(map.find(1));
+  EXPECT_THAT(map, UnorderedElementsAre(Pair(3, "drei")));
+
+  auto copy = map;
+  map.clear();
+  EXPECT_TRUE(map.empty());
+  EXPECT_THAT(copy, UnorderedElementsAre(Pair(3, "drei")));
+  map = std::move(copy);
+  EXPECT_THAT(map, UnorderedElementsAre(Pair(3, "drei")));
+
+  // keys convert like in the std map
+  utils::TFlatHashMap<u64, int> wide;
+  wide[5] = 1;
+  EXPECT_TRUE(wide.contains(5));
+}
+
+TEST(FlatHashTest, MatchesUnorderedMap) {
+  std::mt19937 rng{42};
+  utils::TFlatHashMap<int, int> map;
+  std::unordered_map<int, int> model;
+  for (int step = 0; step < 200000; step++) {
+    const int key = static_cast<int>(rng() % 5000);
+    switch (rng() % 4) {
+      case 0:
+      case 1:
+        map[key] += step;
+        model[key] += step;
+        break;
+      case 2:
+        EXPECT_EQ(map.erase(key), model.erase(key));
+        break;
+      default:
+        EXPECT_EQ(map.contains(key), model.count(key) == 1);
+    }
+    if (step % 20000 == 0) {
+      ExpectSameContents(map, model);
+    }
+  }
+  ExpectSameContents(map, model);
+}
+
+TEST(FlatHashTest, EraseShiftsClusters) {
+  // one long cluster that wraps around the end of the table
+  utils::TFlatHashMap<int, int, TCollidingHash> map;
+  std::unordered_map<int, int> model;
+  for (int i = 0; i < 40; i++) {
+    map[i] = i;
+    model[i] = i;
+  }
+  for (int i : {0, 39, 17, 1, 18, 38, 5}) {
+    EXPECT_EQ(map.erase(i), 1);
+    model.erase(i);
+    ExpectSameContents(map, model);
+    for (const auto& [key, value] : model) {
+      EXPECT_TRUE(map.contains(key)) << key;
+    }
+  }
+
+  // many erasures don't slow down or fill up the table
+  utils::TFlatHashSet<int> set;
+  set.reserve(100);
+  const auto capacity = set.capacity();
+  for (int i = 0; i < 100000; i++) {
+    set.insert(i);
+    if (i >= 50) {
+      EXPECT_EQ(set.erase(i - 50), 1);
+    }
+  }
+  EXPECT_EQ(set.size(), 50);
+  EXPECT_EQ(set.capacity(), capacity);
+}
+
+TEST(FlatHashTest, StringViewLookup) {
+  utils::TFlatHashMap<std::string, int> map;
+  map["alpha"] = 1;
+  map[std::string_view("beta")] = 2;
+  const std::string_view key = "alpha and more";
+  EXPECT_EQ(map.find(key.substr(0, 5))->second, 1);
+  EXPECT_TRUE(map.contains("beta"));
+  EXPECT_FALSE(map.contains(key));
+  EXPECT_TRUE(map.try_emplace(key, 3).second);
+  EXPECT_EQ(map.at(std::string(key)), 3);
+  EXPECT_EQ(map.erase(std::string_view("beta")), 1);
+  EXPECT_THAT(map, UnorderedElementsAre(Pair("alpha", 1), Pair("alpha and more", 3)));
+
+  utils::TFlatHashSet<std::string> set{"x", "y"};
+  EXPECT_TRUE(set.contains(std::string_view("x")));
+  EXPECT_FALSE(set.insert(std::string_view("y")).second);
+  EXPECT_THAT(set, UnorderedElementsAre("x", "y"));
+}
+
+TEST(FlatHashTest, ReserveKeepsReferences) {
+  utils::TFlatHashMap<int, std::unique_ptr<int>> map;
+  map.reserve(1000);
+  const auto capacity = map.capacity();
+  EXPECT_GE(capacity, 1000);
+  map[0] = std::make_unique<int>(0);
+  const auto* first = &map[0];
+  for (int i = 1; i < 1000; i++) {
+    map[i] = std::make_unique<int>(i);
+  }
+  EXPECT_EQ(map.capacity(), capacity);
+  EXPECT_EQ(&map[0], first);
+
+  // growing past the reserved size moves the elements but keeps them
+  for (int i = 1000; i < 5000; i++) {
+    map.try_emplace(i, std::make_unique<int>(i));
+  }
+  EXPECT_GT(map.capacity(), capacity);
+  for (int i = 0; i < 5000; i++) {
+    ASSERT_EQ(*map.at(i), i);
+  }
+}
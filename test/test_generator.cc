@@ -0,0 +1,115 @@
+#include <cpputils/generator.hh>
+#include <cpputils/itertools.hh>
+#include <cpputils/string.hh>
+
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace {
+
+utils::Generator<int> Iota(int n) {
+  for (int i = 0; i < n; i++) {
+    co_yield i;
+  }
+}
+
+/// Joins lines ending with a backslash with the next one
+utils::Generator<std::string> Records(std::string_view text) {
+  std::string record;
+  for (auto line : utils::SplitView(text, "\n")) {
+    if (!line.empty() && line.back() == '\\') {
+      record.append(line.substr(0, line.size() - 1));
+      continue;
+    }
+    record.append(line);
+    co_yield record;
+    record.clear();
+  }
+  if (!record.empty()) {
+    co_yield record;
+  }
+}
+
+utils::Generator<std::uintptr_t> FrameAddress() {
+  int local = 0;
+  co_yield reinterpret_cast<std::uintptr_t>(&local);
+}
+
+utils::Generator<int> Throwing() {
+  co_yield 1;
+  throw std::runtime_error("broken stream");
+}
+
+}  // namespace
+
+static_assert(std::is_same_v<utils::detail::TRangeTraits<utils::Generator<int>>::value_type, int>);
+static_assert(std::is_same_v<utils::detail::TRangeTraits<utils::Generator<int>>::iterator_category, std::input_iterator_tag>);
+
+TEST(GeneratorTest, Iterate) {
+  std::vector<int> result;
+  for (auto x : Iota(4)) {
+    result.push_back(x);
+  }
+  EXPECT_THAT(result, testing::ElementsAre(0, 1, 2, 3));
+  EXPECT_THAT(utils::ToVector(Iota(0)), testing::ElementsAre());
+}
+
+TEST(GeneratorTest, Adaptors) {
+  const auto numbers = Iota(10);
+  const auto even = utils::Filter(numbers, [](int x) { return x % 2 == 0; });
+  EXPECT_THAT(utils::ToVector(utils::Map(even, [](int x) { return x * x; })), testing::ElementsAre(0, 4, 16, 36, 64));
+
+  const auto letters = std::vector<char>{'a', 'b', 'c'};
+  const auto lines = Iota(5);
+  EXPECT_THAT(utils::Zip(lines, letters), testing::ElementsAre(
+    testing::FieldsAre(0, 'a'),
+    testing::FieldsAre(1, 'b'),
+    testing::FieldsAre(2, 'c')
+  ));
+  EXPECT_EQ(utils::Sum(Iota(5)), 10);
+}
+
+TEST(GeneratorTest, StatefulParser) {
+  const auto records = Records("a\\\nb\nc\nd\\\ne\\");
+  EXPECT_THAT(utils::ToVector(records), testing::ElementsAre("ab", "c", "de"));
+}
+
+TEST(GeneratorTest, Exceptions) {
+  const auto gen = Throwing();
+  auto it = gen.begin();
+  EXPECT_EQ(*it, 1);
+  EXPECT_THROW(++it, std::runtime_error);
+}
+
+TEST(GeneratorTest, PooledFrames) {
+  // a frame freed on this thread is handed out again to the next generator
+  std::uintptr_t first = 0;
+  {
+    const auto gen = FrameAddress();
+    first = *gen.begin();
+  }
+  const auto gen = FrameAddress();
+  EXPECT_EQ(*gen.begin(), first);
+
+  // moving keeps the frame
+  auto moved = Iota(3);
+  auto target = std::move(moved);
+  EXPECT_THAT(utils::ToVector(target), testing::ElementsAre(0, 1, 2));
+}
+
+TEST(GeneratorTest, OutlivesFramePool) {
+  // the holder is constructed before the frame pool of the thread, so the
+  // generator is destroyed after the pool
+  std::thread{[] {
+    thread_local std::optional<utils::Generator<int>> holder;
+    holder.emplace(Iota(3));
+    EXPECT_EQ(*holder->begin(), 0);
+  }}.join();
+}
@@ -0,0 +1,167 @@
+#include <cpputils/hash.hh>
+#include <cpputils/reflect.hh>
+
+#include <list>
+#include <random>
+#include <set>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace {
+
+using utils::detail::EHashKernel;
+
+/// No padding: hashed as 16 bytes
+struct TPackedKey {
+  u32 Shard;
+  u32 Table;
+  u64 Row;
+
+  REFLECT(TPackedKey, Shard, Table, Row);
+
+  bool operator==(const TPackedKey& other) const {
+    return Tie() == other.Tie();
+  }
+};
+
+/// Padding after `Flag` and a string: hashed field by field
+struct TMixedKey {
+  bool Flag;
+  u64 Id;
+  std::string Name;
+
+  REFLECT(TMixedKey, Flag, Id, Name);
+
+  bool operator==(const TMixedKey& other) const {
+    return Tie() == other.Tie();
+  }
+};
+
+/// A fixed-size code without a terminating zero
+struct TCodeKey {
+  char Code[4];
+  std::string Name;
+
+  REFLECT(TCodeKey, Code, Name);
+};
+
+std::string RandomBytes(std::mt19937& rng, std::size_t size) {
+  std::string result(size, '\0');
+  for (auto& c : result) {
+    c = static_cast<char>(rng());
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST(HashTest, KernelsMatchScalar) {
+  const auto& scalar = utils::detail::GetHashKernels(EHashKernel::Scalar);
+  std::mt19937 rng{42};
+  for (std::size_t size = 17; size < 3000; size += 1 + size / 16) {
+    const auto bytes = RandomBytes(rng, size);
+    const auto expected = scalar.HashLong(bytes.data(), bytes.size(), size);
+    if (utils::detail::IsKernelSupported(EHashKernel::Avx2)) {
+      const auto& avx2 = utils::detail::GetHashKernels(EHashKernel::Avx2);
+      EXPECT_EQ(avx2.HashLong(bytes.data(), bytes.size(), size), expected) << size;
+    }
+    EXPECT_EQ(utils::HashBytes(bytes.data(), bytes.size(), size), expected);
+  }
+}
+
+TEST(HashTest, BytesAreMixed) {
+  // every single-bit flip and every length and seed change the hash
+  std::mt19937 rng{7};
+  for (const std::size_t size : {1, 3, 4, 8, 15, 16, 17, 100, 128, 129, 1000, 5000}) {
+    auto bytes = RandomBytes(rng, size);
+    std::set<u64> hashes{utils::HashBytes(bytes), utils::HashBytes(bytes, 1)};
+    for (std::size_t bit = 0; bit < size * 8; bit += 1 + size / 64) {
+      bytes[bit / 8] ^= static_cast<char>(1 << (bit % 8));
+      EXPECT_TRUE(hashes.insert(utils::HashBytes(bytes)).second) << size << ' ' << bit;
+      bytes[bit / 8] ^= static_cast<char>(1 << (bit % 8));
+    }
+    EXPECT_TRUE(hashes.insert(utils::HashBytes(std::string_view(bytes).substr(1))).second);
+    EXPECT_EQ(hashes.count(utils::HashBytes(bytes)), 1);
+  }
+  EXPECT_NE(utils::HashBytes(""), utils::HashBytes(std::string_view("\0", 1)));
+}
+
+TEST(HashTest, Values) {
+  EXPECT_EQ(utils::Hash(std::string("key")), utils::Hash(std::string_view("key")));
+  EXPECT_EQ(utils::Hash("key"), utils::Hash(std::string_view("key")));
+  EXPECT_EQ(utils::Hash(0.0), utils::Hash(-0.0));
+  EXPECT_NE(utils::Hash(1), utils::Hash(2));
+  EXPECT_NE(utils::Hash(1, 1), utils::Hash(1, 2));
+  EXPECT_NE(utils::Hash(std::pair{1, 2}), utils::Hash(std::pair{2, 1}));
+  EXPECT_NE(
+    utils::Hash(std::tuple<std::string, std::string>("ab", "c")),
+    utils::Hash(std::tuple<std::string, std::string>("a", "bc"))
+  );
+}
+
+TEST(HashTest, RangesHashByElements) {
+  const std::vector<int> v = {1, 2, 3, 4, 5};
+  const std::list<int> l(v.begin(), v.end());
+  EXPECT_EQ(utils::Hash(v), utils::Hash(l));
+  EXPECT_EQ(utils::Hash(v), utils::Hash(utils::Map(v, [](int x) { return x; })));
+  EXPECT_EQ(utils::Hash(utils::Map(v, [](int x) { return x * 2; })), utils::Hash(std::vector{2, 4, 6, 8, 10}));
+  EXPECT_EQ(utils::Hash(utils::Take(l, 2)), utils::Hash(std::vector{1, 2}));
+  EXPECT_NE(utils::Hash(v), utils::Hash(std::vector{1, 2, 3, 5, 4}));
+
+  // more elements than fit in the staging buffer
+  std::vector<u64> big(1000);
+  for (std::size_t i = 0; i < big.size(); i++) {
+    big[i] = i * i;
+  }
+  EXPECT_EQ(utils::Hash(big), utils::Hash(std::list<u64>(big.begin(), big.end())));
+
+  const std::vector<std::string> words = {"a", "bc"};
+  EXPECT_EQ(utils::Hash(words), utils::Hash(std::list<std::string>(words.begin(), words.end())));
+  EXPECT_NE(utils::Hash(words), utils::Hash(std::vector<std::string>{"ab", "c"}));
+  EXPECT_NE(utils::Hash(words), utils::Hash(std::vector<std::string>{"a", "bc", ""}));
+}
+
+TEST(HashTest, ReflectedStructs) {
+  static_assert(utils::detail::IsHashedAsBytes<TPackedKey>);
+  static_assert(!utils::detail::IsHashedAsBytes<TMixedKey>);
+  const TPackedKey packed{1, 2, 3};
+  EXPECT_EQ(utils::Hash(packed), utils::HashBytes(&packed, sizeof(packed)));
+  EXPECT_NE(utils::Hash(packed), utils::Hash(TPackedKey{2, 1, 3}));
+
+  const TMixedKey mixed{true, 5, "name"};
+  EXPECT_EQ(utils::Hash(mixed), utils::Hash(TMixedKey{true, 5, "name"}));
+  EXPECT_EQ(utils::Hash(mixed), utils::Hash(std::tuple<bool, u64, std::string>(true, 5, "name")));
+  EXPECT_NE(utils::Hash(mixed), utils::Hash(TMixedKey{false, 5, "name"}));
+
+  // all four chars are hashed and nothing past them is read
+  const TCodeKey code{{'a', 'b', 'c', 'd'}, "x"};
+  EXPECT_EQ(utils::Hash(code), utils::Hash(std::tuple<std::string, std::string>("abcd", "x")));
+  EXPECT_NE(utils::Hash(code), utils::Hash(TCodeKey{{'a', 'b', 'c', 'e'}, "x"}));
+}
+
+TEST(HashTest, StandardContainers) {
+  std::unordered_set<TMixedKey, utils::THash> keys;
+  keys.insert({true, 1, "a"});
+  keys.insert({true, 1, "a"});
+  keys.insert({true, 2, "a"});
+  EXPECT_EQ(keys.size(), 2);
+
+  std::unordered_map<std::vector<int>, int, utils::THash> paths;
+  paths[{1, 2, 3}] = 1;
+  paths[{1, 2}] = 2;
+  EXPECT_EQ(paths.at({1, 2, 3}), 1);
+  EXPECT_EQ(paths.count({3, 2, 1}), 0);
+
+  std::unordered_set<TPackedKey, utils::THash> packed;
+  for (u32 i = 0; i < 1000; i++) {
+    packed.insert({i % 7, i % 11, i % 13});
+  }
+  EXPECT_EQ(packed.size(), 1000);
+}
@@ -0,0 +1,92 @@
+#include <cpputils/io.hh>
+#include <cpputils/itertools.hh>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace {
+
+std::string TempPath(std::string_view name) {
+  const char* dir = std::getenv("TMPDIR");
+  return utils::StrCat(dir ? dir : "/tmp", "/cpputils_test_io_", ::getpid(), "_", name);
+}
+
+}  // namespace
+
+TEST(IoTest, WriteAndRead) {
+  const auto path = TempPath("write_and_read");
+  utils::WriteFile(path, "first\nsecond\r\n\nlast");
+  {
+    const auto contents = utils::ReadFile(path);
+    EXPECT_TRUE(contents.IsMapped());
+    EXPECT_EQ(contents.View(), "first\nsecond\r\n\nlast");
+  }
+  utils::WriteFile(path, "\nappended", utils::EWriteMode::Append);
+  EXPECT_THAT(utils::ToVector(utils::ReadLines(path)), testing::ElementsAre("first", "second", "", "last", "appended"));
+
+  const auto lengths = utils::Map(utils::ReadLines(path), [](std::string_view line) { return line.size(); });
+  EXPECT_THAT(utils::ToVector(lengths), testing::ElementsAre(5, 6, 0, 4, 8));
+
+  utils::WriteFile(path, "");
+  EXPECT_EQ(utils::ReadFile(path).View(), "");
+  std::remove(path.c_str());
+}
+
+TEST(IoTest, ReadNonRegularFile) {
+  const auto contents = utils::ReadFile("/proc/self/status");
+  EXPECT_FALSE(contents.IsMapped());
+  EXPECT_THAT(std::string{contents.View()}, testing::HasSubstr("Name:"));
+}
+
+TEST(IoTest, Errors) {
+  EXPECT_THROW(utils::ReadFile(TempPath("missing")), std::runtime_error);
+  EXPECT_THROW(utils::TFileWriter("/nonexistent/dir/file"), std::runtime_error);
+}
+
+TEST(IoTest, BufferedWriter) {
+  const auto path = TempPath("buffered");
+  std::string expected;
+  {
+    utils::TFileWriter writer{path, utils::EWriteMode::Truncate, 16};
+    for (int i = 0; i < 100; i++) {
+      writer << i << ',';
+      utils::FormatTo(writer, FMT("[%]"), std::string(i % 20, 'x'));
+      expected += std::to_string(i) + ",[" + std::string(i % 20, 'x') + "]";
+    }
+  }
+  EXPECT_EQ(utils::ReadFile(path).View(), expected);
+  std::remove(path.c_str());
+}
+
+TEST(IoTest, AtomicWriter) {
+  const auto path = TempPath("atomic");
+  utils::WriteFile(path, "old");
+  {
+    utils::TFileWriter writer{path, utils::EWriteMode::Atomic};
+    writer.Write("abandoned");
+  }
+  EXPECT_EQ(utils::ReadFile(path).View(), "old");
+  {
+    utils::TFileWriter writer{path, utils::EWriteMode::Atomic};
+    writer.Write("new");
+    EXPECT_EQ(utils::ReadFile(path).View(), "old");
+    writer.Close();
+  }
+  EXPECT_EQ(utils::ReadFile(path).View(), "new");
+
+  ::chmod(path.c_str(), 0640);
+  utils::WriteFile(path, "newer", utils::EWriteMode::Atomic);
+  EXPECT_EQ(utils::ReadFile(path).View(), "newer");
+  struct stat info;
+  ASSERT_EQ(::stat(path.c_str(), &info), 0);
+  EXPECT_EQ(info.st_mode & 07777, 0640u);
+  std::remove(path.c_str());
+}
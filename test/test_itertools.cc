@@ -3,8 +3,12 @@
 #include <cpputils/itertools.hh>
 #include <iostream>
 
+#include <algorithm>
 #include <charconv>
+#include <cstdint>
 #include <functional>
+#include <list>
+#include <memory>
 #include <type_traits>
 
 #include <gtest/gtest.h>
@@ -119,3 +123,390 @@ TEST(FilterTest, SimpleFilter) {
 
   EXPECT_THAT(utils::Filter(empty, always_false), testing::ElementsAre());
 }
+
+namespace IteratorTraitsTest {
+  struct TDouble {
+    int operator()(int x) const { return x * 2; }
+  };
+  struct TPositive {
+    bool operator()(int x) const { return x > 0; }
+  };
+  struct TIdentity {
+    std::string_view operator()(std::string_view x) const { return x; }
+  };
+
+  using TVector = std::vector<int>;
+  using TMapped = decltype(utils::Map(std::declval<const TVector&>(), TDouble{}));
+  using TZipped = decltype(utils::Zip(std::declval<const TVector&>(), std::declval<const TMapped&>()));
+  using TFiltered = decltype(utils::Filter(std::declval<const TVector&>(), TPositive{}));
+  using TSplit = decltype(utils::SplitView(""));
+
+  template<class TRange>
+  using TCategory = typename std::iterator_traits<typename utils::detail::TRangeTraits<TRange>::iterator>::iterator_category;
+
+  static_assert(std::is_same_v<TCategory<TMapped>, std::random_access_iterator_tag>);
+  static_assert(std::is_same_v<TCategory<TZipped>, std::random_access_iterator_tag>);
+  static_assert(std::is_same_v<TCategory<TFiltered>, std::forward_iterator_tag>);
+  static_assert(std::is_same_v<TCategory<decltype(utils::Map(std::declval<const TSplit&>(), TIdentity{}))>, std::forward_iterator_tag>);
+
+  static_assert(utils::detail::TRangeTraits<TMapped>::is_sized);
+  static_assert(utils::detail::TRangeTraits<TZipped>::is_sized);
+  static_assert(!utils::detail::TRangeTraits<TFiltered>::is_sized);
+  static_assert(!utils::detail::TRangeTraits<TSplit>::is_sized);
+}
+
+TEST(IteratorTraitsTest, SizedViews) {
+  const auto v1 = std::vector{5, 3, 1, 4, 2};
+  const auto v2 = std::vector<char>{'a', 'b', 'c'};
+  const auto mapped = utils::Map(v1, [](int x) { return x * 10; });
+  EXPECT_EQ(mapped.size(), 5);
+  EXPECT_EQ(std::distance(mapped.begin(), mapped.end()), 5);
+  EXPECT_EQ(mapped.begin()[3], 40);
+  EXPECT_EQ(*(mapped.end() - 1), 20);
+
+  const auto zipped = utils::Zip(v1, v2, mapped);
+  EXPECT_EQ(zipped.size(), 3);
+  EXPECT_EQ(zipped.end() - zipped.begin(), 3);
+  EXPECT_THAT(zipped.begin()[2], testing::FieldsAre(1, 'c', 10));
+  EXPECT_THAT(utils::ToVector(zipped), testing::SizeIs(3));
+  EXPECT_EQ(utils::ToVector(zipped).capacity(), 3);
+
+  EXPECT_EQ(utils::MakeView(v1).size(), 5);
+  EXPECT_EQ(utils::ToVector(mapped).capacity(), 5);
+}
+
+TEST(IteratorTraitsTest, StlAlgorithms) {
+  const auto unsorted = std::vector{5, 3, 1, 4, 2};
+  const auto view = utils::MakeView(unsorted);
+  auto v = std::vector(view.begin(), view.end());
+  std::sort(v.begin(), v.end());
+  EXPECT_THAT(v, testing::ElementsAre(1, 2, 3, 4, 5));
+
+  const auto squares = utils::Map(v, [](int x) { return x * x; });
+  EXPECT_TRUE(std::is_sorted(squares.begin(), squares.end()));
+  EXPECT_EQ(std::lower_bound(squares.begin(), squares.end(), 9) - squares.begin(), 2);
+  EXPECT_EQ(*std::max_element(squares.begin(), squares.end()), 25);
+
+  const auto odd = utils::Filter(v, [](int x) { return x % 2 != 0; });
+  EXPECT_EQ(std::distance(odd.begin(), odd.end()), 3);
+  EXPECT_EQ(*std::find(odd.begin(), odd.end(), 3), 3);
+
+  const auto zipped = utils::Zip(v, squares);
+  const auto it = std::partition_point(zipped.begin(), zipped.end(), [](const auto& p) { return std::get<1>(p) < 10; });
+  EXPECT_EQ(it - zipped.begin(), 3);
+  EXPECT_THAT(*it, testing::FieldsAre(4, 16));
+}
+
+TEST(ZippedRangeTest, YieldsReferences) {
+  const auto v1 = std::vector<std::string>{"a", "b"};
+  const auto v2 = std::vector{1, 2, 3};
+  const auto zipped = utils::Zip(v1, utils::Map(v2, [](int x) { return x * 2; }));
+  using TReference = decltype(*zipped.begin());
+  static_assert(std::is_same_v<TReference, std::tuple<const std::string&, int>>);
+  static_assert(std::is_same_v<decltype(zipped)::value_type, std::tuple<std::string, int>>);
+
+  const auto& [first, doubled] = *zipped.begin();
+  EXPECT_EQ(&first, &v1[0]);
+  EXPECT_EQ(doubled, 2);
+  EXPECT_THAT(utils::ToVector(zipped), testing::ElementsAre(
+    testing::FieldsAre("a", 2),
+    testing::FieldsAre("b", 4)
+  ));
+}
+
+TEST(ZippedRangeTest, StopsAtShortestUnsizedRange) {
+  const auto v = std::vector{1, 2, 3, 4};
+  const auto zipped = utils::Zip(utils::SplitView("x y z"), v, utils::Filter(v, [](int x) { return x > 1; }));
+  EXPECT_THAT(zipped, testing::ElementsAre(
+    testing::FieldsAre("x", 1, 2),
+    testing::FieldsAre("y", 2, 3),
+    testing::FieldsAre("z", 3, 4)
+  ));
+  EXPECT_THAT(utils::Zip(utils::SplitView("x y z"), empty), testing::ElementsAre());
+}
+
+namespace {
+  /// Materializes the subranges of Chunk/Window/Batched
+  template<class TRange>
+  auto Nested(const TRange& r) {
+    std::vector<std::vector<typename utils::detail::TRangeTraits<typename utils::detail::TRangeTraits<TRange>::value_type>::value_type>> result;
+    for (const auto& sub : r) {
+      result.push_back(utils::ToVector(sub));
+    }
+    return result;
+  }
+
+  using testing::ElementsAre;
+}
+
+TEST(ChunkTest, Chunk) {
+  const auto v = std::vector{1, 2, 3, 4, 5};
+  const auto chunks = utils::Chunk(v, 2);
+  EXPECT_EQ(chunks.size(), 3);
+  EXPECT_THAT(Nested(chunks), ElementsAre(ElementsAre(1, 2), ElementsAre(3, 4), ElementsAre(5)));
+  EXPECT_THAT(Nested(utils::Chunk(v, 5)), ElementsAre(ElementsAre(1, 2, 3, 4, 5)));
+  EXPECT_THAT(Nested(utils::Chunk(v, 7)), ElementsAre(ElementsAre(1, 2, 3, 4, 5)));
+  EXPECT_THAT(Nested(utils::Chunk(empty, 3)), ElementsAre());
+  EXPECT_THAT(
+    Nested(utils::Chunk(utils::SplitView("a b c"), 2)),
+    ElementsAre(ElementsAre("a", "b"), ElementsAre("c"))
+  );
+  EXPECT_THROW(utils::Chunk(v, 0), std::invalid_argument);
+  EXPECT_EQ(utils::Chunk(v, SIZE_MAX).size(), 1);
+}
+
+TEST(ChunkTest, Window) {
+  const auto v = std::vector{1, 2, 3, 4};
+  const auto windows = utils::Window(v, 3);
+  EXPECT_EQ(windows.size(), 2);
+  EXPECT_THAT(Nested(windows), ElementsAre(ElementsAre(1, 2, 3), ElementsAre(2, 3, 4)));
+  EXPECT_THAT(Nested(utils::Window(v, 1)), ElementsAre(ElementsAre(1), ElementsAre(2), ElementsAre(3), ElementsAre(4)));
+  EXPECT_EQ(utils::Window(v, 5).size(), 0);
+  EXPECT_THAT(Nested(utils::Window(v, 5)), ElementsAre());
+  EXPECT_THAT(
+    Nested(utils::Window(utils::Filter(v, [](int x) { return x != 2; }), 2)),
+    ElementsAre(ElementsAre(1, 3), ElementsAre(3, 4))
+  );
+}
+
+TEST(ChunkTest, Batched) {
+  const auto v = std::vector{1, 2, 3, 4, 5};
+  // contiguous sources are not copied
+  const auto batches = utils::Batched(v, 2);
+  static_assert(std::is_same_v<decltype(*batches.begin()), utils::TSpan<const int>>);
+  EXPECT_EQ(batches.size(), 3);
+  EXPECT_EQ((*batches.begin()).data(), v.data());
+  EXPECT_THAT(Nested(batches), ElementsAre(ElementsAre(1, 2), ElementsAre(3, 4), ElementsAre(5)));
+
+  // other sources are staged through one buffer
+  const auto staged = utils::Batched(utils::Map(v, [](int x) { return x * 10; }), 2);
+  static_assert(std::is_same_v<decltype(*staged.begin()), utils::TSpan<const int>>);
+  EXPECT_EQ(staged.size(), 3);
+  EXPECT_EQ(utils::Batched(utils::Map(v, [](int x) { return x; }), SIZE_MAX).size(), 1);
+  EXPECT_THAT(Nested(staged), ElementsAre(ElementsAre(10, 20), ElementsAre(30, 40), ElementsAre(50)));
+  const int* buffer = nullptr;
+  for (const auto batch : staged) {
+    if (buffer) {
+      EXPECT_EQ(batch.data(), buffer);
+    }
+    buffer = batch.data();
+  }
+
+  int sum = 0;
+  for (const auto batch : utils::Batched(utils::Filter(v, [](int x) { return x % 2; }), 2)) {
+    for (std::size_t i = 0; i < batch.size(); i++) {
+      sum += batch[i];
+    }
+  }
+  EXPECT_EQ(sum, 9);
+  EXPECT_THAT(Nested(utils::Batched(empty, 4)), ElementsAre());
+}
+
+TEST(ChunkTest, Enumerate) {
+  auto v = std::vector<std::string>{"a", "b", "c"};
+  const auto enumerated = utils::Enumerate(v);
+  EXPECT_EQ(enumerated.size(), 3);
+  EXPECT_THAT(enumerated, ElementsAre(
+    testing::FieldsAre(0, "a"),
+    testing::FieldsAre(1, "b"),
+    testing::FieldsAre(2, "c")
+  ));
+  const auto& [index, value] = enumerated.begin()[2];
+  EXPECT_EQ(index, 2);
+  EXPECT_EQ(&value, &v[2]);
+  EXPECT_EQ(enumerated.end() - enumerated.begin(), 3);
+
+  EXPECT_THAT(utils::Enumerate(utils::SplitView("x y")), ElementsAre(
+    testing::FieldsAre(0, "x"),
+    testing::FieldsAre(1, "y")
+  ));
+}
+
+TEST(ChunkTest, TakeDrop) {
+  const auto v = std::vector{1, 2, 3, 4, 5};
+  EXPECT_THAT(utils::Take(v, 2), ElementsAre(1, 2));
+  EXPECT_EQ(utils::Take(v, 2).size(), 2);
+  EXPECT_THAT(utils::Take(v, 10), ElementsAre(1, 2, 3, 4, 5));
+  EXPECT_THAT(utils::Take(v, 0), ElementsAre());
+  EXPECT_THAT(utils::Take(utils::SplitView("a b c"), 2), ElementsAre("a", "b"));
+  EXPECT_THAT(utils::Take(utils::SplitView("a"), 2), ElementsAre("a"));
+
+  EXPECT_THAT(utils::Drop(v, 3), ElementsAre(4, 5));
+  EXPECT_EQ(utils::Drop(v, 3).size(), 2);
+  EXPECT_THAT(utils::Drop(v, 10), ElementsAre());
+  EXPECT_EQ(utils::Drop(v, 10).size(), 0);
+  EXPECT_THAT(utils::Drop(utils::SplitView("a b c"), 1), ElementsAre("b", "c"));
+
+  EXPECT_THAT(utils::Take(utils::Drop(v, 1), 3), ElementsAre(2, 3, 4));
+}
+
+TEST(ChunkTest, Chain) {
+  const auto v1 = std::vector{1, 2};
+  const auto v2 = std::vector<long>{3};
+  const auto chained = utils::Chain(v1, empty, v2, utils::Map(v1, [](int x) { return x * 10; }));
+  static_assert(std::is_same_v<decltype(chained)::value_type, long>);
+  EXPECT_EQ(chained.size(), 5);
+  EXPECT_THAT(chained, ElementsAre(1, 2, 3, 10, 20));
+  EXPECT_THAT(utils::Chain(empty, empty), ElementsAre());
+  EXPECT_THAT(utils::Chain(utils::SplitView("a b"), std::vector<std::string>{"c"}), ElementsAre("a", "b", "c"));
+}
+
+namespace IteratorTraitsTest {
+  // terminals over these run flat loops over the vector's memory
+  static_assert(utils::detail::IsArithmeticLowering<TMapped>);
+  static_assert(utils::detail::IsArithmeticLowering<TFiltered>);
+  static_assert(utils::detail::IsArithmeticLowering<decltype(utils::MakeView(std::declval<const TVector&>()))>);
+  static_assert(!utils::detail::TLowering<decltype(utils::Map(std::declval<const TFiltered&>(), TDouble{}))>::is_lowered);
+  static_assert(!utils::detail::TLowering<TZipped>::is_lowered);
+}
+
+TEST(ReductionTest, Sum) {
+  const auto v = std::vector{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+  const auto l = std::list(v.begin(), v.end());
+  EXPECT_EQ(utils::Sum(v), 66);
+  EXPECT_EQ(utils::Sum(l), 66);
+  EXPECT_EQ(utils::Sum(empty), 0);
+  const auto odd = [](int x) { return x % 2 != 0; };
+  const auto square = [](int x) { return x * x; };
+  EXPECT_EQ(utils::Sum(utils::Filter(utils::Map(v, square), odd)), 286);
+  EXPECT_EQ(utils::Sum(utils::Filter(utils::Map(l, square), odd)), 286);
+  // a map over a filter takes the generic path
+  EXPECT_EQ(utils::Sum(utils::Map(utils::Filter(v, odd), square)), 286);
+
+  // chars are summed as ints
+  const std::string s(300, 'z');
+  static_assert(std::is_same_v<decltype(utils::Sum(s)), int>);
+  EXPECT_EQ(utils::Sum(s), 300 * 'z');
+  EXPECT_DOUBLE_EQ(utils::Sum(std::vector{0.5, 0.25, 0.125}), 0.875);
+  EXPECT_EQ(utils::Sum(std::vector<std::string>{"a", "b"}), "ab");
+}
+
+TEST(ReductionTest, MinMax) {
+  const auto v = std::vector{5, -3, 8, 1, 9, -7, 2, 6, 0, 4, 3};
+  const auto l = std::list(v.begin(), v.end());
+  for (const auto& result : {utils::MinMax(v), utils::MinMax(l)}) {
+    ASSERT_TRUE(result);
+    EXPECT_EQ(result->Min, -7);
+    EXPECT_EQ(result->Max, 9);
+  }
+  EXPECT_FALSE(utils::MinMax(empty));
+  const auto even = utils::MinMax(utils::Filter(v, [](int x) { return x % 2 == 0; }));
+  ASSERT_TRUE(even);
+  EXPECT_EQ(even->Min, 0);
+  EXPECT_EQ(even->Max, 8);
+  EXPECT_FALSE(utils::MinMax(utils::Filter(v, [](int x) { return x > 100; })));
+  const auto words = utils::MinMax(utils::SplitView("pear apple fig"));
+  ASSERT_TRUE(words);
+  EXPECT_EQ(words->Min, "apple");
+  EXPECT_EQ(words->Max, "pear");
+}
+
+TEST(ReductionTest, Count) {
+  const auto v = std::vector{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+  EXPECT_EQ(utils::Count(v), 11);
+  EXPECT_EQ(utils::Count(utils::SplitView("a b c")), 3);
+  EXPECT_EQ(utils::CountIf(v, [](int x) { return x > 3; }), 8);
+  EXPECT_EQ(utils::CountIf(utils::Map(v, [](int x) { return x * 3; }), [](int x) { return x % 2 == 0; }), 5);
+  EXPECT_EQ(utils::CountIf(utils::SplitView("a bb c"), [](std::string_view x) { return x.size() == 1; }), 2);
+  EXPECT_EQ(utils::CountIf(empty, [](int) { return true; }), 0);
+
+  // contiguous elements that are not arithmetic are neither copied nor moved
+  std::unique_ptr<int> owners[] = {std::make_unique<int>(1), nullptr, std::make_unique<int>(3)};
+  const auto span = utils::TSpan<const std::unique_ptr<int>>{owners, 3};
+  EXPECT_EQ(utils::CountIf(span, [](const std::unique_ptr<int>& p) { return p != nullptr; }), 2);
+  const auto words = std::vector<std::string>{"a", "bb", "c"};
+  EXPECT_EQ(utils::CountIf(words, [](const std::string& x) { return x.size() == 1; }), 2);
+}
+
+TEST(ReductionTest, Reduce) {
+  const auto v = std::vector{1, 2, 3, 4};
+  EXPECT_EQ(utils::Reduce(v, 1, std::multiplies<>{}), 24);
+  EXPECT_EQ(utils::Reduce(utils::Filter(v, [](int x) { return x != 3; }), 0, std::minus<>{}), -7);
+  EXPECT_EQ(
+    utils::Reduce(utils::SplitView("a b c"), std::string{}, [](std::string acc, std::string_view x) { return acc.append(x); }),
+    "abc"
+  );
+}
+
+TEST(ReductionTest, AnyAll) {
+  auto v = std::vector<int>(100, 2);
+  const auto l = std::list(v.begin(), v.end());
+  const auto odd = [](int x) { return x % 2 != 0; };
+  EXPECT_FALSE(utils::Any(v, odd));
+  EXPECT_FALSE(utils::Any(l, odd));
+  EXPECT_TRUE(utils::All(v, [](int x) { return x == 2; }));
+  EXPECT_TRUE(utils::All(empty, odd));
+  EXPECT_FALSE(utils::Any(empty, odd));
+  for (const std::size_t i : {0, 7, 8, 95, 99}) {
+    v[i] = 3;
+    EXPECT_TRUE(utils::Any(v, odd)) << i;
+    EXPECT_FALSE(utils::All(v, [](int x) { return x == 2; })) << i;
+    // rejected by the filter
+    EXPECT_FALSE(utils::Any(utils::Filter(v, [](int x) { return x < 3; }), odd)) << i;
+    v[i] = 2;
+  }
+}
+
+TEST(PipelineTest, PipeSyntax) {
+  const auto v = std::vector{1, 2, 3, 4, 5, 6};
+  const auto odd = [](int x) { return x % 2 != 0; };
+  const auto square = [](int x) { return x * x; };
+
+  const auto view = v | utils::Filter(odd) | utils::Map(square);
+  EXPECT_THAT(view, ElementsAre(1, 9, 25));
+  EXPECT_THAT(v | utils::Map(square) | utils::Take(2) | utils::ToVector(), ElementsAre(1, 4));
+  EXPECT_THAT(v | utils::Drop(4) | utils::Enumerate(), ElementsAre(testing::FieldsAre(0, 5), testing::FieldsAre(1, 6)));
+  EXPECT_EQ(v | utils::Filter(odd) | utils::Sum(), 9);
+  EXPECT_EQ(v | utils::Map(square) | utils::Count(), 6);
+  EXPECT_EQ(v | utils::CountIf(odd), 3);
+  EXPECT_EQ(v | utils::Reduce(0, std::plus<>{}), 21);
+  EXPECT_TRUE(v | utils::Any([](int x) { return x > 5; }));
+  EXPECT_FALSE(v | utils::All(odd));
+  EXPECT_EQ((v | utils::MinMax())->Max, 6);
+  EXPECT_EQ((v | utils::Chunk(4) | utils::Count()), 2);
+
+  // closures compose before they get a range
+  const auto oddSquares = utils::Filter(odd) | utils::Map(square);
+  EXPECT_THAT(v | oddSquares | utils::ToVector(), ElementsAre(1, 9, 25));
+  EXPECT_THAT(utils::SplitView("a bb ccc") | utils::Map([](std::string_view s) { return s.size(); }) | utils::ToVector(),
+    ElementsAre(1, 2, 3));
+}
+
+TEST(PipelineTest, PushLoop) {
+  const auto v = std::vector{1, 2, 3, 4, 5, 6, 7, 8};
+  int mapped = 0;
+  const auto counted = [&mapped](int x) {
+    mapped++;
+    return x * 10;
+  };
+  // a map over a filter: every element is mapped at most once
+  const auto pipeline = v | utils::Filter([](int x) { return x > 2; }) | utils::Map(counted) | utils::Take(3);
+  EXPECT_THAT(utils::ToVector(pipeline), ElementsAre(30, 40, 50));
+  EXPECT_EQ(mapped, 3);
+
+  std::vector<int> seen;
+  utils::ForEach(v | utils::Drop(5), [&seen](int x) { seen.push_back(x); });
+  EXPECT_THAT(seen, ElementsAre(6, 7, 8));
+  seen.clear();
+  v | utils::Take(0) | utils::ForEach([&seen](int x) { seen.push_back(x); });
+  EXPECT_THAT(seen, ElementsAre());
+
+  // take and any stop the source loop early
+  mapped = 0;
+  EXPECT_TRUE(utils::Any(utils::Map(utils::Filter(v, [](int x) { return x > 0; }), counted), [](int x) { return x == 20; }));
+  EXPECT_EQ(mapped, 2);
+  EXPECT_EQ(utils::Sum(utils::Take(utils::Map(utils::Filter(v, [](int x) { return x % 2 == 0; }), counted), 2)), 60);
+  EXPECT_EQ(utils::Sum(utils::Drop(utils::SplitView("1 2 3") | utils::Map([](std::string_view s) { return s.size(); }), 1)), 2);
+
+  // dropped elements are not mapped unless a filter has to see them
+  mapped = 0;
+  EXPECT_THAT(utils::ToVector(utils::Drop(utils::Map(v, counted), 6)), ElementsAre(70, 80));
+  EXPECT_EQ(mapped, 2);
+  mapped = 0;
+  EXPECT_EQ(utils::Count(utils::Drop(utils::Filter(utils::Map(v, counted), [](int x) { return x > 20; }), 4)), 2);
+  EXPECT_EQ(mapped, 8);
+  mapped = 0;
+  const auto even = [](int x) { return x % 2 == 0; };
+  EXPECT_THAT(utils::ToVector(utils::Drop(utils::Map(utils::Filter(v, even), counted), 3)), ElementsAre(80));
+  EXPECT_EQ(mapped, 1);
+}
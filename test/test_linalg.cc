@@ -0,0 +1,413 @@
+#include <cpputils/linalg.hh>
+
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace {
+
+using utils::gf2::T4x4;
+using utils::gf2::T8x8;
+using utils::gf2::TMatrix;
+using utils::gf2::detail::EGf2Kernel;
+
+const EGf2Kernel ALL_KERNELS[] = {EGf2Kernel::Scalar, EGf2Kernel::Avx2, EGf2Kernel::Gfni};
+
+/// Bit-by-bit reference: c[i][j] = xor over k of a[i][k] & b[k][j]
+u64 Mul8x8Naive(u64 a, u64 b) {
+  u64 c = 0;
+  for (int i = 0; i < 8; i++) {
+    for (int j = 0; j < 8; j++) {
+      u64 bit = 0;
+      for (int k = 0; k < 8; k++) {
+        bit ^= (a >> (i * 8 + k)) & (b >> (k * 8 + j)) & 1;
+      }
+      c |= bit << (i * 8 + j);
+    }
+  }
+  return c;
+}
+
+template<class TBlock>
+TMatrix<TBlock> RandomMatrix(std::mt19937& rng, std::size_t rows, std::size_t cols) {
+  TMatrix<TBlock> result(rows, cols);
+  for (std::size_t i = 0; i < rows; i++) {
+    for (std::size_t j = 0; j < cols; j++) {
+      result.Set(i, j, rng() % 2);
+    }
+  }
+  return result;
+}
+
+template<class TBlock>
+TMatrix<TBlock> MulNaive(const TMatrix<TBlock>& a, const TMatrix<TBlock>& b) {
+  TMatrix<TBlock> result(a.Rows(), b.Cols());
+  for (std::size_t i = 0; i < a.Rows(); i++) {
+    for (std::size_t j = 0; j < b.Cols(); j++) {
+      bool bit = false;
+      for (std::size_t k = 0; k < a.Cols(); k++) {
+        bit ^= a.Get(i, k) && b.Get(k, j);
+      }
+      result.Set(i, j, bit);
+    }
+  }
+  return result;
+}
+
+/// Block by block with `TBlock::mul`, fast enough for large matrices
+template<class TBlock>
+TMatrix<TBlock> MulBlocked(const TMatrix<TBlock>& a, const TMatrix<TBlock>& b) {
+  TMatrix<TBlock> result(a.Rows(), b.Cols());
+  for (std::size_t i = 0; i < a.BlockRows(); i++) {
+    for (std::size_t j = 0; j < b.BlockCols(); j++) {
+      auto sum = TBlock::zero();
+      for (std::size_t k = 0; k < a.BlockCols(); k++) {
+        sum = TBlock::add(sum, TBlock::mul(a.Block(i, k), b.Block(k, j)));
+      }
+      result.Block(i, j) = sum;
+    }
+  }
+  return result;
+}
+
+/// Gaussian elimination bit by bit
+template<class TBlock>
+std::size_t RankNaive(const TMatrix<TBlock>& a) {
+  std::vector<std::vector<bool>> rows(a.Rows(), std::vector<bool>(a.Cols()));
+  for (std::size_t i = 0; i < a.Rows(); i++) {
+    for (std::size_t j = 0; j < a.Cols(); j++) {
+      rows[i][j] = a.Get(i, j);
+    }
+  }
+  std::size_t rank = 0;
+  for (std::size_t j = 0; j < a.Cols() && rank < a.Rows(); j++) {
+    auto pivot = rank;
+    while (pivot < a.Rows() && !rows[pivot][j]) {
+      pivot++;
+    }
+    if (pivot == a.Rows()) {
+      continue;
+    }
+    std::swap(rows[pivot], rows[rank]);
+    for (auto i = rank + 1; i < a.Rows(); i++) {
+      if (rows[i][j]) {
+        for (std::size_t k = j; k < a.Cols(); k++) {
+          rows[i][k] = rows[i][k] != rows[rank][k];
+        }
+      }
+    }
+    rank++;
+  }
+  return rank;
+}
+
+/// Random `rows x cols` matrix of rank at most `rank`
+template<class TBlock>
+TMatrix<TBlock> RandomLowRank(std::mt19937& rng, std::size_t rows, std::size_t cols, std::size_t rank) {
+  return RandomMatrix<TBlock>(rng, rows, rank) * RandomMatrix<TBlock>(rng, rank, cols);
+}
+
+/// The bits of the edge blocks outside of the matrix are zero
+template<class TBlock>
+void ExpectMaskedEdges(const TMatrix<TBlock>& m) {
+  constexpr auto DIM = TBlock::DIM;
+  for (std::size_t bi = 0; bi < m.BlockRows(); bi++) {
+    for (std::size_t bj = 0; bj < m.BlockCols(); bj++) {
+      const u64 data = m.Block(bi, bj).data;
+      for (std::size_t r = 0; r < DIM; r++) {
+        for (std::size_t c = 0; c < DIM; c++) {
+          if (bi * DIM + r >= m.Rows() || bj * DIM + c >= m.Cols()) {
+            ASSERT_EQ((data >> (r * DIM + c)) & 1, 0) << bi << ' ' << bj << ' ' << r << ' ' << c;
+          }
+        }
+      }
+    }
+  }
+}
+
+template<class TBlock>
+class Gf2MatrixTest : public testing::Test {};
+
+using TBlocks = testing::Types<T8x8, T4x4>;
+TYPED_TEST_SUITE(Gf2MatrixTest, TBlocks);
+
+}  // namespace
+
+TEST(Gf2BlockTest, Mul8x8) {
+  std::mt19937_64 rng{42};
+  for (int i = 0; i < 1000; i++) {
+    const auto a = rng();
+    const auto b = rng();
+    EXPECT_EQ(utils::gf2::mul8x8(a, b), Mul8x8Naive(a, b));
+  }
+  EXPECT_EQ(utils::gf2::mul8x8(0x8040201008040201ull, 0x1234), 0x1234);
+}
+
+TEST(Gf2BlockTest, Transpose) {
+  std::mt19937_64 rng{7};
+  for (int iteration = 0; iteration < 1000; iteration++) {
+    const auto a = rng();
+    const auto t = utils::gf2::transpose8x8(a);
+    for (int i = 0; i < 8; i++) {
+      for (int j = 0; j < 8; j++) {
+        ASSERT_EQ((t >> (i * 8 + j)) & 1, (a >> (j * 8 + i)) & 1);
+      }
+    }
+    const auto a4 = static_cast<uint16_t>(a);
+    const auto t4 = utils::gf2::transpose4x4(a4);
+    for (int i = 0; i < 4; i++) {
+      for (int j = 0; j < 4; j++) {
+        ASSERT_EQ((t4 >> (i * 4 + j)) & 1, (a4 >> (j * 4 + i)) & 1);
+      }
+    }
+    // (AB)^T = B^T A^T
+    const auto b = rng();
+    EXPECT_EQ(T8x8::transpose(T8x8::mul({a}, {b})).data, utils::gf2::mul8x8(utils::gf2::transpose8x8(b), t));
+  }
+}
+
+TYPED_TEST(Gf2MatrixTest, MulMatchesNaive) {
+  std::mt19937 rng{42};
+  const std::vector<std::size_t> sizes = {1, 3, 4, 8, 13, 64, 65, 100, 130};
+  for (const auto n : sizes) {
+    for (const auto m : sizes) {
+      const auto p = sizes[rng() % sizes.size()];
+      const auto a = RandomMatrix<TypeParam>(rng, n, m);
+      const auto b = RandomMatrix<TypeParam>(rng, m, p);
+      const auto c = a * b;
+      ASSERT_EQ(c.Rows(), n);
+      ASSERT_EQ(c.Cols(), p);
+      ASSERT_EQ(c, MulNaive(a, b)) << n << ' ' << m << ' ' << p;
+      ASSERT_EQ(c, MulBlocked(a, b)) << n << ' ' << m << ' ' << p;
+      ExpectMaskedEdges(c);
+    }
+  }
+}
+
+TYPED_TEST(Gf2MatrixTest, LargeMul) {
+  // several tiles, row chunks and table sets
+  std::mt19937 rng{7};
+  const auto a = RandomMatrix<TypeParam>(rng, 2100, 200);
+  const auto b = RandomMatrix<TypeParam>(rng, 200, 600);
+  EXPECT_EQ(a * b, MulBlocked(a, b));
+}
+
+TYPED_TEST(Gf2MatrixTest, Algebra) {
+  std::mt19937 rng{1};
+  const auto a = RandomMatrix<TypeParam>(rng, 37, 37);
+  const auto b = RandomMatrix<TypeParam>(rng, 37, 37);
+  const auto c = RandomMatrix<TypeParam>(rng, 37, 21);
+  const auto identity = TMatrix<TypeParam>::Identity(37);
+
+  EXPECT_EQ(a * identity, a);
+  EXPECT_EQ(identity * a, a);
+  EXPECT_EQ((a ^ b) * c, (a * c) ^ (b * c));
+  EXPECT_EQ((a * b) * c, a * (b * c));
+  EXPECT_EQ(a ^ a, (TMatrix<TypeParam>(37, 37)));
+  EXPECT_EQ((a & b) ^ (a | b), a ^ b);
+
+  auto d = a;
+  d *= c;
+  EXPECT_EQ(d, a * c);
+  EXPECT_EQ(d.Cols(), 21);
+  ExpectMaskedEdges(d);
+
+  EXPECT_THROW(c * a, std::runtime_error);
+  EXPECT_THROW(a ^ c, std::runtime_error);
+  EXPECT_THROW(d.Set(37, 0, true), std::runtime_error);
+}
+
+TEST(Gf2KernelTest, MatchScalar) {
+  const auto& scalar = utils::gf2::detail::GetGf2Kernels(EGf2Kernel::Scalar);
+  std::mt19937_64 rng{3};
+  for (const auto kernel : ALL_KERNELS) {
+    if (!utils::gf2::detail::IsKernelSupported(kernel)) {
+      continue;
+    }
+    const auto& kernels = utils::gf2::detail::GetGf2Kernels(kernel);
+    // every tail length
+    for (std::size_t count = 0; count < 40; count++) {
+      std::vector<u64> a(count), b(count), c(count);
+      for (std::size_t i = 0; i < count; i++) {
+        a[i] = rng();
+        b[i] = rng();
+        c[i] = rng();
+      }
+      std::vector<u64> expected(count), actual(count);
+      for (std::size_t i = 0; i < count; i++) {
+        expected[i] = Mul8x8Naive(a[i], b[i]);
+      }
+      kernels.Mul(a.data(), b.data(), actual.data(), count);
+      ASSERT_EQ(actual, expected) << static_cast<int>(kernel) << ' ' << count;
+
+      const auto constant = rng();
+      expected = c;
+      actual = c;
+      scalar.MulAddConst(a.data(), constant, expected.data(), count);
+      kernels.MulAddConst(a.data(), constant, actual.data(), count);
+      ASSERT_EQ(actual, expected) << static_cast<int>(kernel) << ' ' << count;
+
+      scalar.Transpose(a.data(), expected.data(), count);
+      kernels.Transpose(a.data(), actual.data(), count);
+      ASSERT_EQ(actual, expected) << static_cast<int>(kernel) << ' ' << count;
+      kernels.Transpose(a.data(), a.data(), count);
+      ASSERT_EQ(a, expected) << static_cast<int>(kernel) << ' ' << count;
+    }
+  }
+}
+
+TEST(Gf2KernelTest, MulBlocks) {
+  std::mt19937 rng{5};
+  for (const auto kernel : ALL_KERNELS) {
+    if (!utils::gf2::detail::IsKernelSupported(kernel)) {
+      continue;
+    }
+    const auto& kernels = utils::gf2::detail::GetGf2Kernels(kernel);
+    // beyond a tile of `MulBlocks` in every dimension
+    for (const auto& [n, m, p] : {std::tuple{1, 1, 1}, {3, 5, 7}, {13, 2, 9}, {300, 40, 3}, {600, 70, 5}}) {
+      const auto a = RandomMatrix<T8x8>(rng, n * 8, m * 8);
+      const auto b = RandomMatrix<T8x8>(rng, m * 8, p * 8);
+      TMatrix<T8x8> c(n * 8, p * 8);
+      utils::gf2::detail::MulBlocks(kernels, &a.Block(0, 0), &b.Block(0, 0), &c.Block(0, 0), n, m, p);
+      ASSERT_EQ(c, MulBlocked(a, b)) << static_cast<int>(kernel) << ' ' << n << ' ' << m << ' ' << p;
+    }
+  }
+}
+
+TYPED_TEST(Gf2MatrixTest, Rank) {
+  std::mt19937 rng{11};
+  const std::vector<std::size_t> sizes = {1, 5, 8, 9, 31, 64, 70, 150};
+  for (const auto n : sizes) {
+    for (const auto m : sizes) {
+      const auto a = RandomMatrix<TypeParam>(rng, n, m);
+      ASSERT_EQ(utils::gf2::Rank(a), RankNaive(a)) << n << ' ' << m;
+      const auto low = RandomLowRank<TypeParam>(rng, n, m, std::min(n, m) / 2);
+      ASSERT_EQ(utils::gf2::Rank(low), RankNaive(low)) << n << ' ' << m;
+    }
+  }
+  EXPECT_EQ(utils::gf2::Rank(TMatrix<TypeParam>(20, 30)), 0);
+  EXPECT_EQ(utils::gf2::Rank(TMatrix<TypeParam>::Identity(300)), 300);
+  // table elimination
+  EXPECT_EQ(utils::gf2::Rank(RandomLowRank<TypeParam>(rng, 900, 700, 333)), 333);
+}
+
+TYPED_TEST(Gf2MatrixTest, ReducedRowEchelon) {
+  std::mt19937 rng{12};
+  for (const auto& [n, m, rank] : {std::tuple{10, 20, 7}, {70, 65, 40}, {600, 500, 300}}) {
+    const auto a = RandomLowRank<TypeParam>(rng, n, m, rank);
+    const auto r = utils::gf2::ReducedRowEchelon(a);
+    ASSERT_EQ(r.Rows(), a.Rows());
+    ASSERT_EQ(r.Cols(), a.Cols());
+    ExpectMaskedEdges(r);
+    // the same row space
+    EXPECT_EQ(utils::gf2::Rank(r), utils::gf2::Rank(a));
+    EXPECT_EQ(utils::gf2::Nullspace(r), utils::gf2::Nullspace(a));
+    std::size_t nonzeroRows = 0;
+    std::size_t prevPivot = 0;
+    for (std::size_t i = 0; i < r.Rows(); i++) {
+      std::size_t pivot = 0;
+      while (pivot < r.Cols() && !r.Get(i, pivot)) {
+        pivot++;
+      }
+      if (pivot == r.Cols()) {
+        continue;
+      }
+      ASSERT_EQ(nonzeroRows++, i);
+      if (i > 0) {
+        ASSERT_GT(pivot, prevPivot);
+      }
+      for (std::size_t k = 0; k < r.Rows(); k++) {
+        ASSERT_EQ(r.Get(k, pivot), k == i) << k << ' ' << i;
+      }
+      prevPivot = pivot;
+    }
+  }
+}
+
+TYPED_TEST(Gf2MatrixTest, Solve) {
+  std::mt19937 rng{13};
+  for (const auto& [n, m] : {std::pair{1, 1}, {9, 5}, {40, 40}, {64, 100}, {700, 650}}) {
+    const auto a = RandomMatrix<TypeParam>(rng, n, m);
+    const auto x = RandomMatrix<TypeParam>(rng, m, 3);
+    const auto b = a * x;
+    const auto solution = utils::gf2::Solve(a, b);
+    ASSERT_TRUE(solution.has_value()) << n << ' ' << m;
+    ASSERT_EQ(solution->Rows(), a.Cols());
+    ASSERT_EQ(solution->Cols(), b.Cols());
+    EXPECT_EQ(a * *solution, b) << n << ' ' << m;
+    ExpectMaskedEdges(*solution);
+  }
+  // b outside of the column space
+  const auto a = RandomLowRank<TypeParam>(rng, 50, 50, 20);
+  auto b = a * RandomMatrix<TypeParam>(rng, 50, 1);
+  EXPECT_TRUE(utils::gf2::Solve(a, b).has_value());
+  bool found = false;
+  for (std::size_t i = 0; i < 50 && !found; i++) {
+    b.Set(i, 0, !b.Get(i, 0));
+    found = !utils::gf2::Solve(a, b).has_value();
+  }
+  EXPECT_TRUE(found);
+  EXPECT_THROW(utils::gf2::Solve(a, TMatrix<TypeParam>(49, 1)), std::runtime_error);
+}
+
+TYPED_TEST(Gf2MatrixTest, Inverse) {
+  std::mt19937 rng{14};
+  for (const std::size_t n : {1, 7, 8, 33, 64, 129, 500}) {
+    // random matrices are invertible with probability about 0.29
+    for (int attempt = 0; attempt < 100; attempt++) {
+      const auto a = RandomMatrix<TypeParam>(rng, n, n);
+      const auto inverse = utils::gf2::Inverse(a);
+      ASSERT_EQ(inverse.has_value(), utils::gf2::Rank(a) == n);
+      if (inverse) {
+        EXPECT_EQ(a * *inverse, TMatrix<TypeParam>::Identity(n));
+        EXPECT_EQ(*inverse * a, TMatrix<TypeParam>::Identity(n));
+        break;
+      }
+    }
+  }
+  EXPECT_FALSE(utils::gf2::Inverse(RandomLowRank<TypeParam>(rng, 40, 40, 39)).has_value());
+  EXPECT_THROW(utils::gf2::Inverse(TMatrix<TypeParam>(3, 4)), std::runtime_error);
+}
+
+TYPED_TEST(Gf2MatrixTest, Nullspace) {
+  std::mt19937 rng{15};
+  for (const auto& [n, m, rank] : {std::tuple{5, 5, 5}, {10, 20, 7}, {70, 65, 40}, {400, 600, 250}}) {
+    const auto a = RandomLowRank<TypeParam>(rng, n, m, rank);
+    const auto r = utils::gf2::Rank(a);
+    const auto basis = utils::gf2::Nullspace(a);
+    ASSERT_EQ(basis.Rows(), a.Cols());
+    ASSERT_EQ(basis.Cols(), a.Cols() - r);
+    EXPECT_EQ(a * basis, TMatrix<TypeParam>(a.Rows(), basis.Cols()));
+    EXPECT_EQ(utils::gf2::Rank(basis), basis.Cols());
+    ExpectMaskedEdges(basis);
+  }
+}
+
+TYPED_TEST(Gf2MatrixTest, ParallelMul) {
+  std::mt19937 rng{16};
+  utils::TThreadPool serial{0};
+  utils::TThreadPool single{1};
+  utils::TThreadPool several{3};
+  // odd quadrants and several levels of recursion
+  const std::tuple<std::size_t, std::size_t, std::size_t, std::size_t> cases[] = {
+    {1, 1, 1, 16}, {13, 70, 9, 16}, {100, 100, 100, 16}, {131, 77, 250, 40}, {700, 900, 500, 256},
+  };
+  for (const auto& [n, m, p, strassenCutoff] : cases) {
+    const auto a = RandomMatrix<TypeParam>(rng, n, m);
+    const auto b = RandomMatrix<TypeParam>(rng, m, p);
+    const auto expected = a * b;
+    for (auto* pool : {&serial, &single, &several}) {
+      for (const auto cutoff : {std::size_t{0}, strassenCutoff}) {
+        const auto c = utils::gf2::ParallelMul(a, b, {pool, cutoff});
+        ASSERT_EQ(c, expected) << n << ' ' << m << ' ' << p << ' ' << pool->Size() << ' ' << cutoff;
+        ExpectMaskedEdges(c);
+      }
+    }
+  }
+  EXPECT_EQ(utils::gf2::ParallelMul(TMatrix<TypeParam>(0, 5), TMatrix<TypeParam>(5, 3)), (TMatrix<TypeParam>(0, 3)));
+  EXPECT_EQ(utils::gf2::ParallelMul(TMatrix<TypeParam>(4, 0), TMatrix<TypeParam>(0, 3)), (TMatrix<TypeParam>(4, 3)));
+  EXPECT_THROW(utils::gf2::ParallelMul(TMatrix<TypeParam>(4, 5), TMatrix<TypeParam>(4, 5)), std::runtime_error);
+}
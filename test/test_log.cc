@@ -0,0 +1,142 @@
+#include <cpputils/io.hh>
+#include <cpputils/log.hh>
+
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace {
+
+std::string TempPath(std::string_view name) {
+  return utils::StrCat("/tmp/cpputils_test_log_", ::getpid(), "_", name);
+}
+
+/// Log lines without the timestamp
+std::vector<std::string> ReadMessages(const std::string& path) {
+  std::vector<std::string> result;
+  for (auto line : utils::ReadLines(path)) {
+    const auto afterDate = line.find(' ');
+    const auto afterTime = line.find(' ', afterDate + 1);
+    result.emplace_back(line.substr(afterTime + 1));
+  }
+  return result;
+}
+
+struct TPoint {
+  int X;
+  int Y;
+
+  friend std::ostream& operator<<(std::ostream& os, const TPoint& p) {
+    return os << '(' << p.X << ", " << p.Y << ')';
+  }
+};
+
+}  // namespace
+
+TEST(LoggerTest, FormatsInBackground) {
+  const auto path = TempPath("background");
+  std::remove(path.c_str());
+  {
+    utils::TLogger logger{path, {utils::ELogLevel::Debug}};
+    utils::TScopedLogger scope{logger};
+    std::string temporary = "temporary";
+    LOG_INFO(FMT("% + % = %"), 1, 2.5, 3.5f);
+    LOG_WARNING(FMT("% is copied, % is not a pointer"), temporary, "literal");
+    temporary.assign(temporary.size(), '?');
+    LOG_DEBUG(FMT("point %, flag %, char %"), TPoint{1, 2}, true, 'x');
+    LOG_TRACE(FMT("filtered at runtime"));
+    logger.SetLevel(utils::ELogLevel::Error);
+    LOG_INFO(FMT("filtered at runtime too"));
+    LOG_ERROR(FMT("\\% done"));
+    logger.Flush();
+    EXPECT_THAT(ReadMessages(path), testing::ElementsAre(
+      "INFO 1 + 2.5 = 3.5",
+      "WARNING temporary is copied, literal is not a pointer",
+      "DEBUG point (1, 2), flag 1, char x",
+      "ERROR % done"
+    ));
+  }
+  EXPECT_EQ(utils::GetLogger(), nullptr);
+  std::remove(path.c_str());
+}
+
+TEST(LoggerTest, ManyThreads) {
+  const auto path = TempPath("threads");
+  std::remove(path.c_str());
+  constexpr int THREADS = 4;
+  constexpr int RECORDS = 5000;
+  {
+    utils::TLoggerOptions options;
+    options.Overflow = utils::ELogOverflow::Block;
+    options.RingSize = 1024;
+    utils::TLogger logger{path, options};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; t++) {
+      threads.emplace_back([&logger, t] {
+        for (int i = 0; i < RECORDS; i++) {
+          logger.Log(utils::ELogLevel::Info, FMT("% %"), t, i);
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    EXPECT_EQ(logger.Dropped(), 0);
+  }
+  std::vector<int> next(THREADS, 0);
+  for (const auto& message : ReadMessages(path)) {
+    const auto parts = utils::Split(message);
+    ASSERT_EQ(parts.size(), 3);
+    const auto t = std::stoi(parts[1]);
+    EXPECT_EQ(std::stoi(parts[2]), next[t]++);
+  }
+  EXPECT_THAT(next, testing::Each(RECORDS));
+  std::remove(path.c_str());
+}
+
+TEST(LoggerTest, BlocksOnLargeRecords) {
+  const auto path = TempPath("large");
+  std::remove(path.c_str());
+  constexpr int RECORDS = 50;
+  {
+    utils::TLoggerOptions options;
+    options.Overflow = utils::ELogOverflow::Block;
+    options.RingSize = 1024;
+    utils::TLogger logger{path, options};
+    // most of the large records don't fit before the end of the ring
+    for (int i = 0; i < RECORDS; i++) {
+      logger.Log(utils::ELogLevel::Info, FMT("% %"), i, std::string(40 * (i % 10), 's'));
+      logger.Log(utils::ELogLevel::Info, FMT("% %"), i, std::string(700, 'l'));
+    }
+    // larger than the ring
+    logger.Log(utils::ELogLevel::Info, FMT("%"), std::string(2000, 'x'));
+    logger.Flush();
+    EXPECT_EQ(logger.Dropped(), 1);
+  }
+  const auto messages = ReadMessages(path);
+  ASSERT_EQ(messages.size(), 2 * RECORDS);
+  for (int i = 0; i < RECORDS; i++) {
+    EXPECT_EQ(messages[2 * i], utils::StrCat("INFO ", i, " ", std::string(40 * (i % 10), 's')));
+    EXPECT_EQ(messages[2 * i + 1], utils::StrCat("INFO ", i, " ", std::string(700, 'l')));
+  }
+  std::remove(path.c_str());
+}
+
+TEST(LoggerTest, DropsOnOverflow) {
+  const auto path = TempPath("drop");
+  utils::TLoggerOptions options;
+  options.RingSize = 256;
+  options.PollInterval = std::chrono::seconds{1};
+  utils::TLogger logger{path, options};
+  for (int i = 0; i < 100; i++) {
+    logger.Log(utils::ELogLevel::Info, FMT("%"), std::string(40, 'x'));
+  }
+  EXPECT_GT(logger.Dropped(), 0);
+  std::remove(path.c_str());
+}
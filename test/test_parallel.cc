@@ -0,0 +1,137 @@
+#include <cpputils/parallel.hh>
+
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace {
+
+std::vector<int> Iota(int n) {
+  std::vector<int> result(n);
+  std::iota(result.begin(), result.end(), 0);
+  return result;
+}
+
+}  // namespace
+
+TEST(ThreadPoolTest, Submit) {
+  std::atomic<int> done{0};
+  {
+    utils::TThreadPool pool{3};
+    EXPECT_EQ(pool.Size(), 3);
+    for (int i = 0; i < 100; i++) {
+      pool.Submit([&done] { done++; });
+    }
+  }
+  // the destructor drains the queues
+  EXPECT_EQ(done.load(), 100);
+}
+
+TEST(ThreadPoolTest, NestedParallelFor) {
+  utils::TThreadPool pool{3};
+  std::vector<std::atomic<int>> hits(64);
+  pool.ParallelFor(8, [&](std::size_t i) {
+    pool.ParallelFor(8, [&](std::size_t j) {
+      hits[i * 8 + j]++;
+    });
+  });
+  for (const auto& hit : hits) {
+    EXPECT_EQ(hit.load(), 1);
+  }
+}
+
+TEST(ThreadPoolTest, Exceptions) {
+  utils::TThreadPool pool{2};
+  std::atomic<int> done{0};
+  EXPECT_THROW(
+    pool.ParallelFor(16, [&](std::size_t i) {
+      done++;
+      if (i == 5) {
+        throw std::runtime_error("chunk failed");
+      }
+    }),
+    std::runtime_error
+  );
+  // the remaining calls still run
+  EXPECT_EQ(done.load(), 16);
+}
+
+TEST(ParallelTest, ForEach) {
+  utils::TThreadPool pool{4};
+  const auto v = Iota(10000);
+  std::vector<std::atomic<int>> hits(v.size());
+  utils::ParallelForEach(v, [&](int x) { hits[x]++; }, {7, &pool});
+  for (const auto& hit : hits) {
+    EXPECT_EQ(hit.load(), 1);
+  }
+}
+
+TEST(ParallelTest, MapKeepsOrder) {
+  utils::TThreadPool pool{4};
+  const auto v = Iota(5000);
+  const auto square = [](int x) { return static_cast<long>(x) * x; };
+  for (const std::size_t grain : {0, 1, 13, 10000}) {
+    EXPECT_EQ(
+      utils::ParallelMap(v, square, {grain, &pool}),
+      utils::ToVector(utils::Map(v, square))
+    );
+  }
+  // views and non-default-constructible results
+  struct TBox {
+    explicit TBox(int x) : Value{x} {}
+    int Value;
+  };
+  const auto boxes = utils::ParallelMap(
+    utils::Zip(v, utils::Map(v, square)),
+    [](const auto& p) { return TBox{static_cast<int>(std::get<1>(p) - std::get<0>(p))}; },
+    {100, &pool}
+  );
+  ASSERT_EQ(boxes.size(), v.size());
+  EXPECT_EQ(boxes[3].Value, 6);
+  EXPECT_EQ(boxes.back().Value, 4999 * 4998);
+
+  EXPECT_THAT(utils::ParallelMap(std::vector<int>{}, square), testing::IsEmpty());
+}
+
+TEST(ParallelTest, Reduce) {
+  utils::TThreadPool pool{4};
+  const auto v = Iota(100000);
+  EXPECT_EQ(utils::ParallelReduce(Iota(1000), 0, std::plus{}, {0, &pool}), 999 * 500);
+  EXPECT_EQ(utils::ParallelReduce(std::vector<int>{}, 42, std::plus{}), 42);
+
+  // the accumulator is of another type than the elements
+  const auto squares = [](long long acc, int x) { return acc + static_cast<long long>(x) * x; };
+  const auto expectedSquares = utils::Reduce(Iota(1001), 0LL, squares);
+  EXPECT_EQ(expectedSquares, 333833500LL);
+  for (const std::size_t grain : {1, 7, 0}) {
+    EXPECT_EQ(utils::ParallelReduce(Iota(1001), 0LL, squares, std::plus{}, {grain, &pool}), expectedSquares);
+  }
+  EXPECT_EQ(utils::ParallelReduce(v, 0L, std::plus{}, std::plus{}, {0, &pool}), 99999L * 100000 / 2);
+  EXPECT_EQ(utils::ParallelReduce(std::vector<int>{}, 0LL, squares, std::plus{}), 0);
+
+  // non-commutative but associative: the order of the elements is kept
+  std::vector<std::string> words;
+  for (int i = 0; i < 1000; i++) {
+    words.push_back(std::to_string(i % 10));
+  }
+  const auto expected = std::accumulate(words.begin(), words.end(), std::string{">"});
+  for (const std::size_t grain : {1, 3, 64, 0}) {
+    EXPECT_EQ(utils::ParallelReduce(words, std::string{">"}, std::plus{}, {grain, &pool}), expected);
+  }
+
+  // floating-point sums only depend on the grain size
+  std::vector<double> values;
+  for (int i = 0; i < 10000; i++) {
+    values.push_back(1.0 / (i + 1));
+  }
+  utils::TThreadPool single{1};
+  EXPECT_EQ(
+    utils::ParallelReduce(values, 0.0, std::plus{}, {128, &pool}),
+    utils::ParallelReduce(values, 0.0, std::plus{}, {128, &single})
+  );
+}
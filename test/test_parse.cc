@@ -0,0 +1,91 @@
+#include <cpputils/parse.hh>
+#include <cpputils/string.hh>
+
+#include <charconv>
+#include <limits>
+#include <random>
+#include <string>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace {
+
+/// `Parse` also accepts a leading '+', which `from_chars` doesn't
+template<class T>
+void ExpectSameAsFromChars(std::string_view s) {
+  const auto withoutPlus = s.size() > 1 && s[0] == '+' && s[1] != '-' ? s.substr(1) : s;
+  T expected{};
+  const auto [ptr, ec] = std::from_chars(withoutPlus.data(), withoutPlus.data() + withoutPlus.size(), expected);
+  const auto parsed = utils::Parse<T>(s);
+  if (ec == std::errc{} && ptr == s.data() + s.size()) {
+    ASSERT_TRUE(parsed.Ok()) << s;
+    ASSERT_EQ(parsed.Value, expected) << s;
+  } else {
+    ASSERT_FALSE(parsed.Ok()) << s;
+  }
+}
+
+}  // namespace
+
+TEST(ParseTest, Integers) {
+  EXPECT_EQ(utils::Parse<int>("42").Value, 42);
+  EXPECT_EQ(utils::Parse<int>("+42").Value, 42);
+  EXPECT_EQ(utils::Parse<int>("-2147483648").Value, std::numeric_limits<int>::min());
+  EXPECT_EQ(utils::Parse<u64>("18446744073709551615").Value, std::numeric_limits<u64>::max());
+  EXPECT_EQ(utils::Parse<i64>("-0000000000000000000000000000001").Value, -1);
+  EXPECT_EQ(utils::Parse<int>("").Error, utils::EParseError::Empty);
+  EXPECT_EQ(utils::Parse<int>("x1").Error, utils::EParseError::Invalid);
+  EXPECT_EQ(utils::Parse<int>("-").Error, utils::EParseError::Invalid);
+  EXPECT_EQ(utils::Parse<u32>("-1").Error, utils::EParseError::Invalid);
+  EXPECT_EQ(utils::Parse<int>("12 ").Error, utils::EParseError::Trailing);
+  EXPECT_EQ(utils::Parse<int>("2147483648").Error, utils::EParseError::OutOfRange);
+  EXPECT_EQ(utils::Parse<std::int8_t>("-129").Error, utils::EParseError::OutOfRange);
+  EXPECT_EQ(utils::Parse<u64>("18446744073709551616").Error, utils::EParseError::OutOfRange);
+}
+
+TEST(ParseTest, MatchesFromChars) {
+  std::mt19937_64 rng{7};
+  for (int i = 0; i < 20000; i++) {
+    const auto bits = rng() % 64;
+    const auto value = static_cast<i64>(rng() >> bits);
+    const auto text = utils::ToString(i % 2 ? value : -value);
+    ExpectSameAsFromChars<i64>(text);
+    ExpectSameAsFromChars<i32>(text);
+    ExpectSameAsFromChars<std::uint16_t>(text);
+    ExpectSameAsFromChars<u64>(text);
+    auto noisy = text;
+    noisy[rng() % noisy.size()] = static_cast<char>(rng());
+    ExpectSameAsFromChars<i64>(noisy);
+  }
+}
+
+TEST(ParseTest, Floats) {
+  EXPECT_DOUBLE_EQ(utils::Parse<double>("2.5").Value, 2.5);
+  EXPECT_DOUBLE_EQ(utils::Parse<double>("+1e-3").Value, 1e-3);
+  EXPECT_FLOAT_EQ(utils::Parse<float>("-0.125").Value, -0.125f);
+  EXPECT_EQ(utils::Parse<double>("+-1").Error, utils::EParseError::Invalid);
+  EXPECT_EQ(utils::Parse<double>("1.5x").Error, utils::EParseError::Trailing);
+  EXPECT_EQ(utils::Parse<double>("1e999").Error, utils::EParseError::OutOfRange);
+}
+
+TEST(ParseTest, ParseMany) {
+  std::vector<i64> ints;
+  auto result = utils::ParseMany<i64>("1,22, 333 ,-4444,\n123456789012345678", ", \n", ints);
+  EXPECT_TRUE(result.Ok());
+  EXPECT_EQ(result.Count, 5);
+  EXPECT_THAT(ints, testing::ElementsAre(1, 22, 333, -4444, 123456789012345678));
+
+  std::vector<double> doubles{0.5};
+  result = utils::ParseMany<double>("1.5 2e3 oops 4", utils::detail::WS, doubles);
+  EXPECT_EQ(result.Error, utils::EParseError::Invalid);
+  EXPECT_EQ(result.ErrorOffset, 8);
+  EXPECT_EQ(result.Count, 2);
+  EXPECT_THAT(doubles, testing::ElementsAre(0.5, 1.5, 2000.0));
+}
+
+TEST(ParseTest, ComposesWithSplitView) {
+  const auto parsed = utils::Map(utils::SplitView("1,2,x,4", ','), utils::Parse<int>);
+  const auto values = utils::Map(utils::Filter(parsed, [](const auto& p) { return p.Ok(); }), [](const auto& p) { return p.Value; });
+  EXPECT_THAT(utils::ToVector(values), testing::ElementsAre(1, 2, 4));
+}
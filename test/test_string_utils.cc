@@ -1,8 +1,13 @@
 #include <cpputils/common.hh>
 #include <cpputils/string.hh>
+#include <cpputils/itertools.hh>
 #include <iostream>
 
 #include <charconv>
+#include <iomanip>
+#include <limits>
+#include <random>
+#include <sstream>
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
@@ -28,6 +33,221 @@ TEST(FormatTest, InvalidArgumentNumber) {
   EXPECT_THROW_MATCHES([]{ utils::Format("%%", 42); }, ERROR_MESSAGE_MATCHER);
 }
 
+TEST(FormatTest, CompileTimeFormat) {
+  EXPECT_EQ(utils::Format(FMT("%"), 42), "42");
+  EXPECT_EQ(utils::Format(FMT("\\%")), "%");
+  EXPECT_EQ(utils::Format(FMT("")), "");
+  EXPECT_EQ(utils::Format(FMT("%%"), 'a', 'b'), "ab");
+  EXPECT_EQ(utils::Format(FMT("[%] \\\\ [%]"), "x", std::string{"y"}), "[x] \\ [y]");
+  EXPECT_EQ(utils::Format(FMT("%/%/%/%"), -17, 42u, 2.5, true), "-17/42/2.5/1");
+}
+
+TEST(FormatTest, MatchesStreamOutput) {
+  for (double x : {0.1, 1.0 / 3, 1e20, -2.5e-7, 123456789.0, 0.0}) {
+    std::ostringstream os;
+    os << x;
+    EXPECT_EQ(utils::ToString(x), os.str());
+    EXPECT_EQ(utils::Format(FMT("%"), x), os.str());
+  }
+  EXPECT_EQ(utils::ToString(static_cast<unsigned char>('z')), "z");
+  EXPECT_EQ(utils::ToString(std::numeric_limits<i64>::min()), "-9223372036854775808");
+}
+
+TEST(FormatTest, FormatTo) {
+  std::string buffer = "key=";
+  utils::FormatTo(buffer, FMT("%,%"), "label", 7);
+  EXPECT_EQ(buffer, "key=label,7");
+  utils::FormatTo(buffer, "; %", 8);
+  EXPECT_EQ(buffer, "key=label,7; 8");
+  EXPECT_THROW(utils::FormatTo(buffer, "%%", 9), std::runtime_error);
+  EXPECT_EQ(buffer, "key=label,7; 8");
+}
+
+TEST(SplitViewTest, Tokens) {
+  EXPECT_THAT(utils::ToVector(utils::SplitView("  a bb\tccc  ")), testing::ElementsAre("a", "bb", "ccc"));
+  EXPECT_THAT(utils::ToVector(utils::SplitView("a,,b,", ',')), testing::ElementsAre("a", "b"));
+  EXPECT_THAT(utils::ToVector(utils::SplitView(" \n ")), testing::IsEmpty());
+  EXPECT_THAT(utils::ToVector(utils::SplitView("")), testing::IsEmpty());
+}
+
+TEST(SplitViewTest, Lines) {
+  EXPECT_THAT(utils::ToVector(utils::SplitLines("a\r\n\nb\n")), testing::ElementsAre("a", "", "b"));
+  EXPECT_THAT(utils::ToVector(utils::SplitLines("a\nb")), testing::ElementsAre("a", "b"));
+  EXPECT_THAT(utils::ToVector(utils::SplitLines("\n")), testing::ElementsAre(""));
+  EXPECT_THAT(utils::ToVector(utils::SplitLines("")), testing::IsEmpty());
+}
+
+TEST(SplitViewTest, ComposesWithItertools) {
+  const std::string line = "1,22,x,333";
+  const auto size = [](std::string_view token) { return token.size(); };
+  const auto odd = [](std::size_t x) { return x % 2 == 1; };
+  EXPECT_THAT(utils::ToVector(utils::Filter(utils::Map(utils::SplitView(line, ','), size), odd)), testing::ElementsAre(1, 1, 3));
+
+  std::vector<std::pair<std::string_view, std::string_view>> pairs;
+  for (auto [key, value] : utils::Zip(utils::SplitView("a b c"), utils::SplitLines("1\n2"))) {
+    pairs.emplace_back(key, value);
+  }
+  EXPECT_THAT(pairs, testing::ElementsAre(testing::Pair("a", "1"), testing::Pair("b", "2")));
+}
+
+TEST(StringBuilderTest, InlineAndHeap) {
+  utils::TBasicStringBuilder<8> builder;
+  builder << "ab" << 12 << 'c';
+  EXPECT_EQ(builder.View(), "ab12c");
+  EXPECT_TRUE(builder.IsInline());
+  builder.Append(-3.5, "|", true, std::string(20, 'x'));
+  EXPECT_EQ(builder.View(), "ab12c-3.5|1" + std::string(20, 'x'));
+  EXPECT_FALSE(builder.IsInline());
+
+  const auto copy = builder;
+  builder.clear();
+  utils::FormatTo(builder, FMT("%=%"), "k", 42u);
+  EXPECT_EQ(builder.Str(), "k=42");
+  EXPECT_EQ(copy.View(), "ab12c-3.5|1" + std::string(20, 'x'));
+
+  const std::string made = utils::MakeString() << "x" << 1 << 2.5;
+  EXPECT_EQ(made, "x12.5");
+  const std::string manipulated = utils::MakeString() << std::hex << 255 << std::setw(4) << 1 << std::fixed << 0.5;
+  EXPECT_EQ(manipulated, "ff   10.500000");
+}
+
+TEST(StringBuilderTest, SelfAppendAndMove) {
+  utils::TBasicStringBuilder<8> builder;
+  builder << "abcdef";
+  builder.append(builder.View());
+  EXPECT_EQ(builder.View(), "abcdefabcdef");
+  EXPECT_FALSE(builder.IsInline());
+  builder.append(builder.View());
+  EXPECT_EQ(builder.View(), "abcdefabcdefabcdefabcdef");
+
+  const char* data = builder.data();
+  auto moved = std::move(builder);
+  EXPECT_EQ(moved.data(), data);
+  EXPECT_EQ(moved.View(), "abcdefabcdefabcdefabcdef");
+  EXPECT_TRUE(builder.IsInline());
+  EXPECT_EQ(builder.size(), 0u);
+
+  utils::TBasicStringBuilder<8> small;
+  small << "xyz";
+  moved = std::move(small);
+  EXPECT_TRUE(moved.IsInline());
+  EXPECT_EQ(moved.View(), "xyz");
+  static_assert(std::is_nothrow_move_constructible_v<utils::TStringBuilder>);
+}
+
+TEST(StringBuilderTest, StrCat) {
+  EXPECT_EQ(utils::StrCat(), "");
+  EXPECT_EQ(utils::StrCat("host-", 17, ':', std::string_view{"8080"}, "/", 0.25), "host-17:8080/0.25");
+  std::string dest = "a";
+  utils::StrAppend(dest, std::numeric_limits<i64>::min(), 'b');
+  EXPECT_EQ(dest, "a-9223372036854775808b");
+  const auto cat = utils::StrCat(std::string(100, 'y'), 1234567, std::numeric_limits<u64>::max());
+  EXPECT_EQ(cat.size(), 100 + 7 + 20);
+  EXPECT_LE(cat.capacity(), 100 + 7 + 20 + 20 + 2);
+}
+
+TEST(JoinTest, Join) {
+  EXPECT_EQ(utils::Join({"a", "b", "c"}), "a, b, c");
+  EXPECT_EQ(utils::Join(std::vector<std::string>{}, "-"), "");
+  EXPECT_EQ(utils::Join(std::vector{1, 2, 3}, "+"), "1+2+3");
+  const std::vector<std::string> words = {"x", "yy", "zzz"};
+  const auto joined = utils::Join(words, "--");
+  EXPECT_EQ(joined, "x--yy--zzz");
+  EXPECT_EQ(utils::Join(utils::Map(words, [](const std::string& w) { return w.size(); }), ","), "1,2,3");
+
+  // a mapped element is computed once, there is no sizing pass over a map
+  int mapped = 0;
+  const auto toString = [&mapped](int x) {
+    mapped++;
+    return std::to_string(x);
+  };
+  EXPECT_EQ(utils::Join(utils::Map(std::vector{1, 2, 3, 4}, toString), " "), "1 2 3 4");
+  EXPECT_EQ(mapped, 4);
+}
+
+namespace {
+
+/// Tries every pattern at every position, the reference for `TReplacer`
+std::string NaiveReplace(std::string_view text, const std::vector<std::pair<std::string_view, std::string_view>>& pairs, bool longest) {
+  std::string result;
+  for (std::size_t i = 0; i < text.size();) {
+    const std::pair<std::string_view, std::string_view>* best = nullptr;
+    for (const auto& pair : pairs) {
+      if (text.substr(i, pair.first.size()) == pair.first && (!best || (longest && pair.first.size() > best->first.size()))) {
+        best = &pair;
+        if (!longest) {
+          break;
+        }
+      }
+    }
+    if (best) {
+      result.append(best->second);
+      i += best->first.size();
+    } else {
+      result.push_back(text[i++]);
+    }
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST(ReplaceTest, Simple) {
+  EXPECT_EQ(utils::Replace("<a & b>", {{"<", "&lt;"}, {">", "&gt;"}, {"&", "&amp;"}}), "&lt;a &amp; b&gt;");
+  EXPECT_EQ(utils::Replace("abcd", {{"bc", "X"}, {"abcd", "Y"}}), "Y");
+  EXPECT_EQ(utils::Replace("abce", {{"abcd", "Y"}, {"b", "1"}, {"c", "2"}}), "a12e");
+  EXPECT_EQ(utils::Replace("aaa", {{"a", "aa"}}), "aaaaaa");
+  EXPECT_EQ(utils::Replace("", {{"a", "b"}}), "");
+  EXPECT_EQ(utils::Replace("text", {}), "text");
+  EXPECT_THROW(utils::Replace("text", {{"", "x"}}), std::runtime_error);
+}
+
+TEST(ReplaceTest, MatchKinds) {
+  using EMatchKind = utils::TReplacer::EMatchKind;
+  const std::vector<std::pair<std::string_view, std::string_view>> pairs = {{"ab", "1"}, {"abc", "2"}, {"b", "3"}};
+  EXPECT_EQ(utils::TReplacer(pairs, EMatchKind::LeftmostFirst).Replace("abcab"), "1c1");
+  EXPECT_EQ(utils::TReplacer(pairs, EMatchKind::LeftmostLongest).Replace("abcab"), "21");
+}
+
+TEST(ReplaceTest, MatchesNaiveImplementation) {
+  using EMatchKind = utils::TReplacer::EMatchKind;
+  std::mt19937 rng{1337};
+  const auto randomString = [&rng](std::size_t maxSize) {
+    std::string result(1 + rng() % maxSize, 'a');
+    for (auto& c : result) {
+      c = static_cast<char>('a' + rng() % 3);
+    }
+    return result;
+  };
+  for (int iteration = 0; iteration < 500; iteration++) {
+    std::vector<std::string> storage;
+    for (int i = 0; i < 1 + static_cast<int>(rng() % 6); i++) {
+      storage.push_back(randomString(5));
+      storage.push_back(std::to_string(i));
+    }
+    std::vector<std::pair<std::string_view, std::string_view>> pairs;
+    for (std::size_t i = 0; i < storage.size(); i += 2) {
+      pairs.emplace_back(storage[i], storage[i + 1]);
+    }
+    const auto text = randomString(60);
+    for (const bool longest : {false, true}) {
+      const utils::TReplacer replacer{pairs, longest ? EMatchKind::LeftmostLongest : EMatchKind::LeftmostFirst};
+      const auto expected = NaiveReplace(text, pairs, longest);
+      ASSERT_EQ(replacer.Replace(text), expected) << text;
+
+      auto stream = replacer.Stream();
+      std::string streamed;
+      for (std::size_t pos = 0; pos < text.size();) {
+        const auto size = std::min<std::size_t>(rng() % 4, text.size() - pos);
+        stream.Feed(std::string_view{text}.substr(pos, size), streamed);
+        pos += size;
+      }
+      stream.Finish(streamed);
+      ASSERT_EQ(streamed, expected) << text;
+    }
+  }
+}
+
 // int main() {
 //   std::string str = "file";
 //   std::cout << utils::Trim(str) << std::endl;